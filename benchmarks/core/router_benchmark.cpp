@@ -0,0 +1,64 @@
+#include "core/router.h"
+#include <benchmark/benchmark.h>
+#include <string>
+
+namespace express {
+namespace benchmark {
+
+class DiscardingResponse : public Response {
+public:
+  DiscardingResponse() : Response([](std::vector<char>) {}) {}
+};
+
+/**
+ * Router with `count` parameterized routes under distinct static prefixes, a mounted sub-router
+ * and path-scoped middleware, as a large application would register.
+ */
+Router make_router(int64_t count) {
+  Router router;
+  router.use([](Request &, Response &, Next &next) { next(); });
+  router.use("/api/v1", [](Request &, Response &, Next &next) { next(); });
+  for (int64_t i = 0; i < count; i++) {
+    std::string prefix = "/api/v1/resource" + std::to_string(i);
+    router.get(prefix + "/:id", [](Request &, Response &) {});
+    router.post(prefix, [](Request &, Response &) {});
+  }
+  Router admin;
+  admin.get("/users/:id", [](Request &, Response &) {});
+  router.use("/admin", std::move(admin));
+  return router;
+}
+
+/**
+ * Startup cost of building the dispatch table shared by every server thread.
+ */
+void BM_RouterCompile(::benchmark::State &state) {
+  Router router = make_router(state.range(0));
+  for (auto _ : state) {
+    std::shared_ptr<const CompiledRouter> compiled = router.compile();
+    ::benchmark::DoNotOptimize(compiled);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+}
+
+/**
+ * Dispatch of one request through the middleware chain to a parameterized route.
+ */
+void BM_CompiledRouterDispatch(::benchmark::State &state) {
+  std::shared_ptr<const CompiledRouter> compiled = make_router(state.range(0)).compile();
+  std::string target = "/api/v1/resource" + std::to_string(state.range(0) / 2) + "/42";
+  Request request("GET " + target + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  DiscardingResponse response;
+  for (auto _ : state) {
+    request.params.clear();
+    Task<> task = compiled->run(request, response);
+    ::benchmark::DoNotOptimize(task);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_RouterCompile)->Arg(100)->Arg(1000)->Arg(5000);
+BENCHMARK(BM_CompiledRouterDispatch)->Arg(100)->Arg(5000);
+
+} // namespace benchmark
+} // namespace express
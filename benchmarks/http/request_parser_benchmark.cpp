@@ -0,0 +1,114 @@
+#include "http/byte_scanner.h"
+#include <benchmark/benchmark.h>
+#include <express/request.h>
+#include <string>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace express {
+namespace benchmark {
+
+/**
+ * Builds a request whose request line and headers take about `size` bytes, with header lines
+ * shaped like a browser's.
+ */
+std::string make_request(size_t size) {
+  std::string request =
+      "GET /api/v1/catalog/items?page=2&sort=price HTTP/1.1\r\n"
+      "Host: shop.example.com\r\n"
+      "User-Agent: Mozilla/5.0 (X11; Linux x86_64) Gecko/20100101 Firefox/131.0\r\n"
+      "Accept: text/html,application/xhtml+xml,application/xml;q=0.9\r\n"
+      "Accept-Language: en-US,en;q=0.5\r\n"
+      "Accept-Encoding: gzip, deflate, br\r\n"
+      "Connection: keep-alive\r\n";
+  for (int i = 0; request.size() + 4 < size; i++) {
+    std::string line = "X-Trace-" + std::to_string(i) + ": " + std::string(48, 'a' + i % 26);
+    request += line.substr(0, std::min(line.size(), size - request.size() - 4)) + "\r\n";
+  }
+  return request + "\r\n";
+}
+
+uint64_t cycles() {
+#if defined(__x86_64__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Parses a whole request. Reports time stamp counter cycles per request, so the cost is
+ * comparable across machines of different clock speeds. Argument 0 is the header block size.
+ */
+void BM_ParseRequest(::benchmark::State &state) {
+  std::string raw = make_request(static_cast<size_t>(state.range(0)));
+  uint64_t start = cycles();
+  for (auto _ : state) {
+    Request request(raw);
+    ::benchmark::DoNotOptimize(request);
+  }
+  uint64_t elapsed = cycles() - start;
+  state.counters["cycles_per_request"] =
+      static_cast<double>(elapsed) / static_cast<double>(state.iterations());
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(raw.size()));
+}
+
+/**
+ * Scans a header block for every line end with each scanner variant the CPU supports.
+ * Argument 0 is the header block size, argument 1 the variant: 0 scalar, 1 SSE4.2, 2 AVX2.
+ */
+void BM_ScanHeaderBlock(::benchmark::State &state) {
+  std::string raw = make_request(static_cast<size_t>(state.range(0)));
+  ByteScanner::Isa isa = static_cast<ByteScanner::Isa>(state.range(1));
+  if (!ByteScanner::supports(isa)) {
+    state.SkipWithError("Scanner variant not supported by this CPU");
+    return;
+  }
+  const char *labels[] = {"scalar", "sse4.2", "avx2"};
+  state.SetLabel(labels[state.range(1)]);
+
+  uint64_t start = cycles();
+  for (auto _ : state) {
+    size_t lines = 0;
+    for (size_t at = ByteScanner::find(isa, raw, ":\r"); at != std::string::npos;
+         at = ByteScanner::find(isa, raw, ":\r", at + 1)) {
+      lines++;
+    }
+    ::benchmark::DoNotOptimize(lines);
+  }
+  uint64_t elapsed = cycles() - start;
+  state.counters["cycles_per_request"] =
+      static_cast<double>(elapsed) / static_cast<double>(state.iterations());
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(raw.size()));
+}
+
+/**
+ * Looks up the headers the server and typical middleware read on every request. Argument 0
+ * picks the lookup: 0 by well-known id, 1 by name.
+ */
+void BM_HeaderLookup(::benchmark::State &state) {
+  Request request(make_request(500));
+  bool by_name = state.range(0) == 1;
+  state.SetLabel(by_name ? "name" : "id");
+  for (auto _ : state) {
+    if (by_name) {
+      ::benchmark::DoNotOptimize(request.header("connection"));
+      ::benchmark::DoNotOptimize(request.header("host"));
+      ::benchmark::DoNotOptimize(request.header("accept-encoding"));
+    } else {
+      ::benchmark::DoNotOptimize(request.header(Header::Connection));
+      ::benchmark::DoNotOptimize(request.header(Header::Host));
+      ::benchmark::DoNotOptimize(request.header(Header::AcceptEncoding));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 3);
+}
+
+BENCHMARK(BM_ParseRequest)->Arg(500)->Arg(4096);
+BENCHMARK(BM_ScanHeaderBlock)->ArgsProduct({{500, 4096}, {0, 1, 2}});
+BENCHMARK(BM_HeaderLookup)->Arg(0)->Arg(1);
+
+} // namespace benchmark
+} // namespace express
@@ -0,0 +1,67 @@
+#include "http/url_codec.h"
+#include <benchmark/benchmark.h>
+#include <string>
+
+namespace express {
+namespace benchmark {
+
+/**
+ * Query values shaped like real traffic. Argument 0 picks one: 0 plain ASCII, 1 ASCII with
+ * escaped punctuation and spaces, 2 escaped UTF-8 text.
+ */
+std::string make_encoded(int64_t kind) {
+  switch (kind) {
+    case 0:
+      return "electronics-and-home-appliances_sorted_by_price_ascending_page_2";
+    case 1:
+      return "red+shoes%2C+size+42%20%26%20up%21+free%20shipping%3F+yes%2Fno";
+    default:
+      return "%E6%97%A5%E6%9C%AC%E8%AA%9E%E3%81%AE%E6%A4%9C%E7%B4%A2%F0%9F%98%80";
+  }
+}
+
+const char *labels[] = {"ascii", "escaped", "utf8"};
+
+void BM_UrlDecodeToString(::benchmark::State &state) {
+  std::string encoded = make_encoded(state.range(0));
+  state.SetLabel(labels[state.range(0)]);
+  for (auto _ : state) {
+    std::string decoded = UrlCodec::decode(encoded);
+    ::benchmark::DoNotOptimize(decoded);
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(encoded.size()));
+}
+
+/**
+ * Decodes into a reused buffer, as Request's lazily parsed parameters do.
+ */
+void BM_UrlDecodeIntoBuffer(::benchmark::State &state) {
+  std::string encoded = make_encoded(state.range(0));
+  std::string output(encoded.size(), '\0');
+  state.SetLabel(labels[state.range(0)]);
+  for (auto _ : state) {
+    UrlCodec::DecodeResult result = UrlCodec::decode(encoded, output.data());
+    ::benchmark::DoNotOptimize(result);
+    ::benchmark::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(encoded.size()));
+}
+
+void BM_UrlEncode(::benchmark::State &state) {
+  std::string decoded = UrlCodec::decode(make_encoded(state.range(0)));
+  std::string output(UrlCodec::encoded_size(decoded), '\0');
+  state.SetLabel(labels[state.range(0)]);
+  for (auto _ : state) {
+    size_t size = UrlCodec::encode(decoded, output.data());
+    ::benchmark::DoNotOptimize(size);
+    ::benchmark::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(decoded.size()));
+}
+
+BENCHMARK(BM_UrlDecodeToString)->DenseRange(0, 2);
+BENCHMARK(BM_UrlDecodeIntoBuffer)->DenseRange(0, 2);
+BENCHMARK(BM_UrlEncode)->DenseRange(0, 2);
+
+} // namespace benchmark
+} // namespace express
@@ -0,0 +1,94 @@
+#include "core/router.h"
+#include "net/servers/server.h"
+#include "../../utils/loopback_client.h"
+#include <benchmark/benchmark.h>
+
+namespace express {
+namespace benchmark {
+
+constexpr int BACKEND_BASE_PORT = 18180;
+constexpr int BACKEND_CLIENTS = 8;
+constexpr int REQUESTS_PER_CONNECTION = 256;
+constexpr std::string_view KEEP_ALIVE_REQUEST = "GET / HTTP/1.1\r\n"
+                                                "Host: localhost\r\n"
+                                                "\r\n";
+constexpr std::string_view CLOSING_REQUEST = "GET / HTTP/1.1\r\n"
+                                             "Host: localhost\r\n"
+                                             "Connection: close\r\n"
+                                             "\r\n";
+
+/**
+ * Starts a server with the given backend serving the same small route for every benchmark.
+ * @returns nullptr after skipping the benchmark if the backend is unavailable on this kernel.
+ */
+std::unique_ptr<Server> start_backend(::benchmark::State &state, int port) {
+  IoBackend backend = state.range(0) == 0 ? IoBackend::EPOLL : IoBackend::IO_URING;
+  state.SetLabel(backend == IoBackend::EPOLL ? "epoll" : "io_uring");
+
+  Router router;
+  router.get("/", [](Request &, Response &response) { response.send("Hello world!"); });
+
+  ListenOptions options;
+  options.backend = backend;
+  SocketConfig config = {AF_INET, SOCK_STREAM, 0, port, INADDR_ANY, 511};
+  auto slot = std::make_shared<RouterSlot>(router.compile());
+  auto server = std::make_unique<Server>(config, slot, options);
+  if (server->backend() != backend) {
+    state.SkipWithError("io_uring is not available on this kernel");
+    return nullptr;
+  }
+  server->launch();
+  return server;
+}
+
+/**
+ * Requests per second on persistent connections, where the per-request syscalls dominate.
+ * Argument 0 is epoll, 1 is io_uring.
+ */
+void BM_IoBackendKeepAlive(::benchmark::State &state) {
+  int port = BACKEND_BASE_PORT + static_cast<int>(state.range(0));
+  std::unique_ptr<Server> server = start_backend(state, port);
+  if (server == nullptr)
+    return;
+
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < BACKEND_CLIENTS; i++) {
+      threads.emplace_back([port]() {
+        request_keep_alive(port, KEEP_ALIVE_REQUEST, REQUESTS_PER_CONNECTION);
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * BACKEND_CLIENTS * REQUESTS_PER_CONNECTION);
+  server->stop();
+}
+
+/**
+ * Requests per second with one connection per request, exercising accept and the final close.
+ * Argument 0 is epoll, 1 is io_uring.
+ */
+void BM_IoBackendConnectionPerRequest(::benchmark::State &state) {
+  int port = BACKEND_BASE_PORT + 2 + static_cast<int>(state.range(0));
+  std::unique_ptr<Server> server = start_backend(state, port);
+  if (server == nullptr)
+    return;
+
+  for (auto _ : state) {
+    run_clients(port, CLOSING_REQUEST, BACKEND_CLIENTS, REQUESTS_PER_CONNECTION / 8);
+  }
+  state.SetItemsProcessed(state.iterations() * BACKEND_CLIENTS * (REQUESTS_PER_CONNECTION / 8));
+  server->stop();
+}
+
+BENCHMARK(BM_IoBackendKeepAlive)->Arg(0)->Arg(1)->UseRealTime()->Unit(::benchmark::kMillisecond);
+BENCHMARK(BM_IoBackendConnectionPerRequest)
+    ->Arg(0)
+    ->Arg(1)
+    ->UseRealTime()
+    ->Unit(::benchmark::kMillisecond);
+
+} // namespace benchmark
+} // namespace express
@@ -0,0 +1,70 @@
+#include "core/router.h"
+#include "net/servers/server.h"
+#include "net/servers/worker_pool.h"
+#include "../../utils/loopback_client.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+
+namespace express {
+namespace benchmark {
+
+constexpr int BASE_PORT = 18080;
+constexpr int CLIENTS = 16;
+constexpr int REQUESTS_PER_CLIENT = 32;
+constexpr std::string_view RAW_REQUEST = "GET / HTTP/1.1\r\n"
+                                         "Host: localhost\r\n"
+                                         "Connection: close\r\n"
+                                         "\r\n";
+
+/**
+ * Keeps the calling thread busy for roughly the given duration, standing in for a CPU-bound
+ * route handler.
+ */
+void burn_cpu(std::chrono::microseconds duration) {
+  auto deadline = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < deadline) {
+  }
+}
+
+/**
+ * Requests per second against a CPU-heavy route as the worker pool grows.
+ * Reported as items_per_second; ideal scaling is linear in the worker count up to the core count.
+ */
+void BM_WorkerPoolScaling(::benchmark::State &state) {
+  int worker_threads = static_cast<int>(state.range(0));
+  int port = BASE_PORT + worker_threads;
+
+  Router router;
+  router.get("/", [](Request &, Response &response) {
+    burn_cpu(std::chrono::microseconds(200));
+    response.send("ok");
+  });
+
+  auto pool = std::make_unique<WorkerPool>(worker_threads);
+  SocketConfig config = {AF_INET, SOCK_STREAM, 0, port, INADDR_ANY, 511};
+  auto slot = std::make_shared<RouterSlot>(router.compile());
+  Server server(config, slot, ListenOptions(), pool.get());
+  server.launch();
+
+  for (auto _ : state) {
+    run_clients(port, RAW_REQUEST, CLIENTS, REQUESTS_PER_CLIENT);
+  }
+  state.SetItemsProcessed(state.iterations() * CLIENTS * REQUESTS_PER_CLIENT);
+
+  server.stop();
+  pool = nullptr;
+}
+
+BENCHMARK(BM_WorkerPoolScaling)
+    ->Apply([](::benchmark::internal::Benchmark *benchmark) {
+      int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+      for (int workers = 1; workers < cores; workers *= 2) {
+        benchmark->Arg(workers);
+      }
+      benchmark->Arg(cores);
+    })
+    ->UseRealTime()
+    ->Unit(::benchmark::kMillisecond);
+
+} // namespace benchmark
+} // namespace express
@@ -0,0 +1,113 @@
+#ifndef EXPRESS_BENCHMARK_LOOPBACK_CLIENT_H
+#define EXPRESS_BENCHMARK_LOOPBACK_CLIENT_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace express {
+namespace benchmark {
+
+/**
+ * Sends one raw request over a fresh loopback connection and reads until the server closes it.
+ * @returns Number of response bytes received, or -1 if the connection failed.
+ */
+inline ssize_t request_once(int port, std::string_view raw_request) {
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock < 0)
+    return -1;
+
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(sock, (struct sockaddr *)&address, sizeof(address)) < 0) {
+    close(sock);
+    return -1;
+  }
+
+  send(sock, raw_request.data(), raw_request.size(), 0);
+  ssize_t total = 0;
+  char buffer[4096];
+  ssize_t received;
+  while ((received = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+    total += received;
+  }
+  close(sock);
+  return total;
+}
+
+/**
+ * Sends `count` requests one after another over a single persistent loopback connection,
+ * reading each response in full (headers plus Content-Length body) before sending the next.
+ * @returns Number of responses received, or -1 if the connection failed.
+ */
+inline int request_keep_alive(int port, std::string_view raw_request, int count) {
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock < 0)
+    return -1;
+
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(sock, (struct sockaddr *)&address, sizeof(address)) < 0) {
+    close(sock);
+    return -1;
+  }
+
+  std::string pending;
+  char buffer[4096];
+  int answered = 0;
+  for (; answered < count; answered++) {
+    send(sock, raw_request.data(), raw_request.size(), MSG_NOSIGNAL);
+
+    size_t response_size = std::string::npos;
+    while (response_size == std::string::npos || pending.size() < response_size) {
+      size_t header_end = pending.find("\r\n\r\n");
+      if (response_size == std::string::npos && header_end != std::string::npos) {
+        size_t length_at = pending.find("Content-Length: ");
+        size_t body_size = length_at < header_end ? std::stoul(pending.substr(length_at + 16)) : 0;
+        response_size = header_end + 4 + body_size;
+        continue;
+      }
+      ssize_t received = recv(sock, buffer, sizeof(buffer), 0);
+      if (received <= 0) {
+        close(sock);
+        return answered;
+      }
+      pending.append(buffer, received);
+    }
+    pending.erase(0, response_size);
+  }
+  close(sock);
+  return answered;
+}
+
+/**
+ * Runs `clients` threads that each send `requests_per_client` requests back to back.
+ */
+inline void run_clients(int port, std::string_view raw_request, int clients,
+                        int requests_per_client) {
+  std::vector<std::thread> threads;
+  for (int i = 0; i < clients; i++) {
+    threads.emplace_back([port, raw_request, requests_per_client]() {
+      for (int j = 0; j < requests_per_client; j++) {
+        request_once(port, raw_request);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace benchmark
+} // namespace express
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef EXPRESS_PUBLIC_BODY_OPTIONS_H
+#define EXPRESS_PUBLIC_BODY_OPTIONS_H
+
+#include <cstddef>
+#include <optional>
+
+namespace express {
+/**
+ * @brief How a route receives request bodies, e.g. for uploads larger than the default limit.
+ * @example app.post("/upload", express::BodyOptions{.max_size = 8ULL << 30, .stream = true}, h);
+ */
+struct BodyOptions {
+  /**
+   * Largest body accepted; larger ones are answered with 413.
+   * @note Unset uses ListenOptions::max_body_size.
+   */
+  std::optional<size_t> max_size;
+
+  /**
+   * Runs the handler as soon as the headers arrived, and hands it the body a chunk at a time
+   * through Request::body_chunk() instead of buffering it whole. Reading from the client pauses
+   * while the handler falls behind, so the body is never held in memory at once.
+   * @note Request::body stays empty; only coroutine handlers can read a streamed body, and
+   * registering a synchronous handler with it throws std::invalid_argument.
+   */
+  bool stream = false;
+};
+} // namespace express
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef EXPRESS_PUBLIC_CACHE_H
+#define EXPRESS_PUBLIC_CACHE_H
+
+#include "types.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace express {
+/**
+ * @brief Settings of a response cache created with express::cache.
+ */
+struct CacheOptions {
+  /** How long a cached response is replayed without running the handler */
+  std::chrono::seconds ttl{0};
+
+  /** How long past `ttl` the stale response is still replayed while one request refreshes it */
+  std::chrono::seconds stale_while_revalidate{0};
+
+  /** Query parameters that are part of the cache key; all others are ignored */
+  std::vector<std::string> vary_query;
+
+  /** Request headers that are part of the cache key, e.g. "Accept-Language" */
+  std::vector<std::string> vary_headers;
+
+  /** Combined size of the cached responses, beyond which the least recently used are evicted */
+  size_t max_bytes = 64 * 1024 * 1024;
+};
+
+/**
+ * Creates route middleware caching the serialized responses of GET and HEAD requests. Hits are
+ * written straight to the connection without running the handler. Only 2xx responses sent in
+ * one piece, e.g. by send() or json(), are cached, and never those that set a cookie, are marked
+ * Cache-Control private or no-store, or Vary on a header missing from `vary_headers`.
+ * @note Concurrent requests for a key with nothing cached yet all run the handler; only once a
+ * response is kept are the following ones answered from it.
+ * @example app.get("/catalog", express::cache(std::chrono::seconds(30)), handler);
+ */
+Middleware cache(std::chrono::seconds ttl);
+
+/**
+ * Creates route middleware caching responses with the given settings.
+ * @example app.get("/catalog", express::cache({.ttl = 30s, .stale_while_revalidate = 60s}), h);
+ */
+Middleware cache(CacheOptions options);
+
+} // namespace express
+
+#endif
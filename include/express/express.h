@@ -1,23 +1,126 @@
 #ifndef EXPRESS_PUBLIC_H
 #define EXPRESS_PUBLIC_H
 
+#include "body_options.h"
+#include "cache.h"
+#include "listen_options.h"
+#include "shard_stats.h"
+#include "static_routes.h"
 #include "types.h"
+#include <concepts>
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace express {
 class Express {
 public:
   static Express express();
   void listen(int port, Callback callback = Callback());
+  void listen(int port, ListenOptions options, Callback callback = Callback());
   void shutdown();
 
-  // HTTP method handlers
+  // Per-reactor traffic counters, one entry per reactor thread
+  std::vector<ShardStats> stats();
+
+  // HTTP method handlers. Routes and middleware can also be registered or removed while the app
+  // is listening: each change publishes a new routing table, and requests already running finish
+  // with the table they started with.
   void get(std::string route, Handler handler);
   void post(std::string route, Handler handler);
   void put(std::string route, Handler handler);
   void del(std::string route, Handler handler);
+  void patch(std::string route, Handler handler);
+  // HEAD requests fall back to the GET route, and OPTIONS requests are answered with an Allow
+  // header listing the methods routed for the path, unless a route is registered for them
+  void head(std::string route, Handler handler);
+  void options(std::string route, Handler handler);
+
+  // Coroutine handlers, resumed by the server's event loop whenever they suspend
+  void get(std::string route, AsyncHandler handler);
+  void post(std::string route, AsyncHandler handler);
+  void put(std::string route, AsyncHandler handler);
+  void del(std::string route, AsyncHandler handler);
+  void patch(std::string route, AsyncHandler handler);
+  void head(std::string route, AsyncHandler handler);
+  void options(std::string route, AsyncHandler handler);
+
+  // Coroutine lambdas convert to both handler types, so pick AsyncHandler explicitly
+  template <CoroutineHandler F> void get(std::string route, F handler) {
+    get(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void post(std::string route, F handler) {
+    post(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void put(std::string route, F handler) {
+    put(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void del(std::string route, F handler) {
+    del(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void patch(std::string route, F handler) {
+    patch(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void head(std::string route, F handler) {
+    head(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void options(std::string route, F handler) {
+    options(std::move(route), AsyncHandler(std::move(handler)));
+  }
+
+  // GET routes behind route middleware, e.g. express::cache, which runs right before the handler
+  // and can answer the request itself by not calling next()
+  void get(std::string route, Middleware middleware, Handler handler);
+  void get(std::string route, Middleware middleware, AsyncHandler handler);
+  template <CoroutineHandler F> void get(std::string route, Middleware middleware, F handler) {
+    get(std::move(route), std::move(middleware), AsyncHandler(std::move(handler)));
+  }
+
+  // POST and PUT routes receiving bodies their own way, e.g. larger than
+  // ListenOptions::max_body_size, or streamed to a coroutine handler through Request::body_chunk().
+  // Streaming to a synchronous handler throws std::invalid_argument.
+  void post(std::string route, BodyOptions body, Handler handler);
+  void post(std::string route, BodyOptions body, AsyncHandler handler);
+  void put(std::string route, BodyOptions body, Handler handler);
+  void put(std::string route, BodyOptions body, AsyncHandler handler);
+  template <CoroutineHandler F> void post(std::string route, BodyOptions body, F handler) {
+    post(std::move(route), body, AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void put(std::string route, BodyOptions body, F handler) {
+    put(std::move(route), body, AsyncHandler(std::move(handler)));
+  }
+
+  // Mounts a route table under a path prefix, e.g. one built at compile time by express::routes
+  void use(std::string prefix, std::shared_ptr<const RouteTable> table);
+  template <typename T>
+    requires std::derived_from<T, RouteTable>
+  void use(std::string prefix, T table) {
+    std::shared_ptr<const RouteTable> shared = std::make_shared<const T>(std::move(table));
+    use(std::move(prefix), std::move(shared));
+  }
+
+  // Middleware, run in registration order before routing, optionally only for requests under a
+  // path. The chain stops at the first middleware that does not call next() or that sends the
+  // response headers.
+  void use(Middleware middleware);
+  void use(std::string path, Middleware middleware);
+  void use(AsyncMiddleware middleware);
+  void use(std::string path, AsyncMiddleware middleware);
+
+  // Coroutine lambdas convert to both middleware types, so pick AsyncMiddleware explicitly
+  template <CoroutineMiddleware F> void use(F middleware) {
+    use(AsyncMiddleware(std::move(middleware)));
+  }
+  template <CoroutineMiddleware F> void use(std::string path, F middleware) {
+    use(std::move(path), AsyncMiddleware(std::move(middleware)));
+  }
+
+  // Removes the handlers of a route, e.g. to turn off a feature-flagged route, or the middleware
+  // registered at a path. Returns whether anything was removed; remove_route throws on an unknown
+  // method.
+  bool remove_route(std::string method, std::string route);
+  bool remove_middleware(std::string path);
 
   // Rule of 5
   ~Express();
@@ -0,0 +1,169 @@
+#ifndef EXPRESS_PUBLIC_HEADERS_H
+#define EXPRESS_PUBLIC_HEADERS_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace express {
+/**
+ * Headers recognized while parsing, each with a fixed slot in Headers so that looking it up
+ * needs no string comparison.
+ */
+enum class Header : uint8_t {
+  Accept,
+  AcceptEncoding,
+  AcceptLanguage,
+  Authorization,
+  CacheControl,
+  Connection,
+  ContentEncoding,
+  ContentLength,
+  ContentType,
+  Cookie,
+  Date,
+  ETag,
+  Expect,
+  Host,
+  IfModifiedSince,
+  IfNoneMatch,
+  LastModified,
+  Location,
+  Origin,
+  Range,
+  Referer,
+  Server,
+  SetCookie,
+  TransferEncoding,
+  Upgrade,
+  UserAgent,
+  Vary,
+  XForwardedFor,
+};
+
+/**
+ * @brief Header fields of a request, as views, in the order they were sent.
+ *
+ * Fields are kept in a flat array, inline for the first INLINE_CAPACITY of them, so a typical
+ * request stores its headers without allocating. Names compare case-insensitively. Well-known
+ * names are recognized when a field is added and remember the field's position, so get(Header)
+ * is a single index. A name sent more than once keeps every field; lookups find the last one.
+ */
+class Headers {
+public:
+  struct Field {
+    std::string_view name;
+    std::string_view value;
+  };
+
+  using const_iterator = const Field *;
+
+  /** Fields stored without allocating */
+  static constexpr size_t INLINE_CAPACITY = 16;
+
+  /** Number of well-known headers, for tables indexed by Header */
+  static constexpr size_t WELL_KNOWN_COUNT = 28;
+
+  /**
+   * @returns The well-known header with the given name, in any case, or nothing.
+   */
+  static std::optional<Header> id(std::string_view name);
+
+  /**
+   * @returns The canonical name of a well-known header, e.g. "Content-Length".
+   */
+  static std::string_view name(Header id);
+
+  /**
+   * @returns True if both names are equal ignoring ASCII case, as header names compare.
+   */
+  static bool equals(std::string_view a, std::string_view b);
+
+  /**
+   * @returns Value of the header, or an empty view if it was not sent.
+   */
+  std::string_view get(Header id) const;
+
+  /**
+   * Looks a header up by name, in any case.
+   * @returns Value of the header, or an empty view if it was not sent.
+   */
+  std::string_view get(std::string_view name) const;
+
+  bool contains(Header id) const;
+  bool contains(std::string_view name) const;
+
+  /**
+   * Appends a field, keeping earlier fields with the same name. Name and value must outlive
+   * the headers.
+   */
+  void add(std::string_view name, std::string_view value);
+
+  /**
+   * Replaces the value of the field get() finds, or appends a field if there is none. Name and
+   * value must outlive the headers.
+   */
+  void set(std::string_view name, std::string_view value);
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size_; }
+
+private:
+  static constexpr std::array<std::string_view, WELL_KNOWN_COUNT> names_ = {
+      "Accept",
+      "Accept-Encoding",
+      "Accept-Language",
+      "Authorization",
+      "Cache-Control",
+      "Connection",
+      "Content-Encoding",
+      "Content-Length",
+      "Content-Type",
+      "Cookie",
+      "Date",
+      "ETag",
+      "Expect",
+      "Host",
+      "If-Modified-Since",
+      "If-None-Match",
+      "Last-Modified",
+      "Location",
+      "Origin",
+      "Range",
+      "Referer",
+      "Server",
+      "Set-Cookie",
+      "Transfer-Encoding",
+      "Upgrade",
+      "User-Agent",
+      "Vary",
+      "X-Forwarded-For",
+  };
+
+  /** Fields in the order they were added, until there are more than INLINE_CAPACITY */
+  std::array<Field, INLINE_CAPACITY> inline_fields_;
+
+  /** All fields, once they no longer fit inline */
+  std::vector<Field> spilled_fields_;
+
+  uint32_t size_ = 0;
+
+  /** Position plus one of the last field of each well-known header, or 0 if it was not sent */
+  std::array<uint32_t, WELL_KNOWN_COUNT> slots_{};
+
+  const Field *data() const;
+  Field *data();
+
+  /**
+   * @returns Position of the last field with the given name, or nothing.
+   * @private
+   */
+  std::optional<size_t> find(std::string_view name) const;
+};
+} // namespace express
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef EXPRESS_PUBLIC_LISTEN_OPTIONS_H
+#define EXPRESS_PUBLIC_LISTEN_OPTIONS_H
+
+#include <chrono>
+#include <cstddef>
+
+namespace express {
+/**
+ * @brief Mechanism a reactor uses to wait for and perform socket I/O
+ */
+enum class IoBackend {
+  /** Readiness notifications from epoll, with a read/write syscall per operation */
+  EPOLL,
+  /** Completions from io_uring, with multishot accept/receive and batched submissions */
+  IO_URING,
+};
+
+/**
+ * @brief Tuning knobs for Express::listen
+ */
+struct ListenOptions {
+  /**
+   * Number of worker threads running route handlers.
+   * @note 0 runs handlers inline on the I/O thread.
+   */
+  size_t worker_threads = 0;
+
+  /**
+   * Number of reactor threads accepting and serving connections.
+   * @note Above 1, every reactor binds its own SO_REUSEPORT socket to the port and the kernel
+   * spreads incoming connections across them.
+   */
+  size_t reactor_threads = 1;
+
+  /**
+   * Requests served on one persistent connection before the server closes it.
+   * @note 1 disables keep-alive.
+   */
+  size_t max_requests_per_connection = 1000;
+
+  /**
+   * How long a persistent connection may sit idle between requests before it is closed.
+   */
+  std::chrono::milliseconds keep_alive_timeout{5000};
+
+  /**
+   * Largest request body accepted by routes that do not set their own BodyOptions::max_size.
+   * Larger bodies are answered with 413.
+   */
+  size_t max_body_size = 1024 * 1024;
+
+  /**
+   * I/O mechanism used by every reactor.
+   * @note IO_URING needs Linux 6.0 or later and a build with EXPRESS_WITH_IO_URING. Reactors fall
+   * back to EPOLL when either is missing.
+   */
+  IoBackend backend = IoBackend::EPOLL;
+};
+} // namespace express
+
+#endif
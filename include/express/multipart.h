@@ -0,0 +1,198 @@
+#ifndef EXPRESS_PUBLIC_MULTIPART_H
+#define EXPRESS_PUBLIC_MULTIPART_H
+
+#include "headers.h"
+#include "request.h"
+#include "task.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace express {
+/**
+ * @brief Headers of one part of a multipart/form-data body, as views valid until the part ends.
+ */
+struct MultipartPart {
+  Headers headers;
+  /** Form field name, from the Content-Disposition header */
+  std::string_view name;
+  /** Name of the uploaded file, from the Content-Disposition header, or an empty view */
+  std::string_view filename;
+  /** Value of the part's Content-Type header, or an empty view, which means text/plain */
+  std::string_view content_type;
+};
+
+/**
+ * @brief Incremental parser for multipart/form-data bodies, as browsers send file uploads.
+ *
+ * The body is fed in chunks of any size, and each part's headers and content are handed on as
+ * soon as they are framed, so memory use does not depend on the size of a part: the parser only
+ * keeps the headers of the current part and the few bytes at the end of a chunk that may begin
+ * a delimiter. Delimiters are found with Boyer-Moore-Horspool, which mostly skips the length of
+ * the delimiter per comparison. Malformed bodies throw BodyError with status 400, which answers
+ * the request when a handler lets it propagate.
+ * @example
+ * co_await express::MultipartParser(express::MultipartParser::boundary(req.header(
+ *     express::Header::ContentType)), {.on_part = on_part, .on_data = on_data}).parse(req);
+ */
+class MultipartParser {
+public:
+  struct Callbacks {
+    /** Called with the headers of each part, before its content. May call write_to(). */
+    std::function<void(const MultipartPart &)> on_part;
+    /** Called with each piece of the current part's content, in order */
+    std::function<void(std::string_view)> on_data;
+    /** Called once the content of the current part is complete */
+    std::function<void()> on_part_end;
+  };
+
+  /** Largest header section of a part; larger ones throw BodyError with status 431 (8KB) */
+  static constexpr size_t MAX_HEADER_SIZE_ = 8 * 1024;
+
+  /** Longest boundary allowed by RFC 2046 */
+  static constexpr size_t MAX_BOUNDARY_SIZE_ = 70;
+
+  /**
+   * @param content_type Value of the request's Content-Type header.
+   * @returns The boundary parameter of a multipart/form-data content type, or an empty view for
+   * any other content type.
+   */
+  static std::string_view boundary(std::string_view content_type);
+
+  /**
+   * @param boundary Boundary between the parts, e.g. from boundary(). Copied.
+   * @throws BodyError with status 400 if the boundary is empty or longer than
+   * MAX_BOUNDARY_SIZE_.
+   */
+  MultipartParser(std::string_view boundary, Callbacks callbacks);
+
+  /**
+   * Parses the next chunk of the body, calling back for what it completes.
+   * @throws BodyError if the body is malformed.
+   */
+  void feed(std::string_view chunk);
+
+  /**
+   * Checks that the body fed so far ended with the closing delimiter.
+   * @throws BodyError with status 400 if it did not.
+   */
+  void finish();
+
+  /**
+   * @returns True once the closing delimiter was parsed. Anything fed after it is ignored.
+   */
+  bool done() const;
+
+  /**
+   * Writes the content of the current part to a file descriptor instead of passing it to
+   * on_data, e.g. to store an uploaded file without copying it into the handler. Called from
+   * on_part; the descriptor must be blocking and stays owned by the caller.
+   * @throws std::runtime_error from feed() if writing fails.
+   */
+  void write_to(int fd);
+
+  /**
+   * Feeds the whole body of the request, chunk by chunk as it arrives for routes that stream
+   * it, then calls finish().
+   * @example co_await parser.parse(req);
+   */
+  Task<> parse(Request &req);
+
+private:
+  enum class State {
+    PREAMBLE,
+    AFTER_DELIMITER,
+    CLOSING,
+    DELIMITER_LF,
+    HEADERS,
+    CONTENT,
+    EPILOGUE,
+    FAILED,
+  };
+
+  /** CRLF, two dashes and the boundary, which precedes every part and the end of the body */
+  std::string delimiter_;
+
+  /** Boyer-Moore-Horspool shift for each byte found under the delimiter's last byte */
+  std::array<uint8_t, 256> shifts_;
+
+  Callbacks callbacks_;
+  State state_ = State::PREAMBLE;
+
+  /**
+   * End of the previous chunk that may begin a delimiter, held back from on_data until the
+   * next chunk tells. Starts out as CRLF, so the first delimiter needs none before it.
+   */
+  std::string held_;
+
+  /** Header section of the current part, preceded by the CRLF ending the delimiter line */
+  std::string part_headers_;
+
+  MultipartPart part_;
+
+  /** Descriptor receiving the current part's content, or -1 */
+  int fd_ = -1;
+
+  /**
+   * Parses content, or the preamble, up to the next delimiter.
+   * @returns Offset in `chunk` parsing stopped at.
+   * @private
+   */
+  size_t parse_content(std::string_view chunk, size_t offset);
+
+  /**
+   * Parses the rest of a delimiter line, which either begins a part or closes the body.
+   * @returns Offset in `chunk` parsing stopped at.
+   * @private
+   */
+  size_t parse_delimiter_end(std::string_view chunk, size_t offset);
+
+  /**
+   * Collects the header section of a part.
+   * @returns Offset in `chunk` parsing stopped at.
+   * @private
+   */
+  size_t parse_headers(std::string_view chunk, size_t offset);
+
+  /**
+   * Splits the collected header section into part_ and announces the part.
+   * @private
+   */
+  void begin_part(std::string_view header_lines);
+
+  /**
+   * Ends the current part, or the preamble, on finding a delimiter.
+   * @private
+   */
+  void end_content();
+
+  /**
+   * Passes content on, or drops it while in the preamble.
+   * @private
+   */
+  void emit(std::string_view content);
+
+  /**
+   * @returns Index of the first delimiter in `text`, or std::string_view::npos.
+   * @private
+   */
+  size_t find_delimiter(std::string_view text) const;
+
+  /**
+   * @returns Length of the longest end of `text` that begins a delimiter.
+   * @private
+   */
+  size_t partial_delimiter(std::string_view text) const;
+
+  /**
+   * @throws BodyError with the given status, after which every call to feed() throws.
+   * @private
+   */
+  [[noreturn]] void fail(int status);
+};
+} // namespace express
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef EXPRESS_PUBLIC_PARAMETERS_H
+#define EXPRESS_PUBLIC_PARAMETERS_H
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace express {
+/**
+ * @brief Key-value pairs of a query string, a Cookie header or a form body, parsed on first
+ * access.
+ *
+ * Nothing is parsed until a handler reads the parameters, so routes that never look at them
+ * pay nothing. Keys and values are then views into the source; only those containing escapes
+ * are decoded, into one buffer the size of the source. A key given more than once keeps its
+ * first position and its last value. Malformed escapes are kept as sent rather than rejected.
+ * Parsing on access mutates internal state, so the parameters must not be read from several
+ * threads at once.
+ */
+class Parameters {
+public:
+  enum class Syntax {
+    /** `a=1&b=2`, as in query strings and form bodies; `+` stands for a space */
+    URL_ENCODED,
+    /** `a=1; b=2`, as in the Cookie header; values may be quoted and `+` is literal */
+    COOKIE
+  };
+
+  struct Field {
+    std::string_view key;
+    std::string_view value;
+  };
+
+  using const_iterator = std::vector<Field>::const_iterator;
+
+  Parameters() = default;
+
+  /**
+   * @param source Text to parse on first access. Must outlive the parameters.
+   */
+  Parameters(std::string_view source, Syntax syntax);
+
+  /**
+   * @returns Decoded value of the given decoded key, or an empty view.
+   */
+  std::string_view get(std::string_view key) const;
+  std::string_view operator[](std::string_view key) const { return get(key); }
+  bool contains(std::string_view key) const;
+
+  size_t size() const;
+  bool empty() const { return size() == 0; }
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  // Rule of 5
+  ~Parameters() = default;
+  Parameters(const Parameters &) = delete;
+  Parameters &operator=(const Parameters &) = delete;
+  Parameters(Parameters &&) = default;
+  Parameters &operator=(Parameters &&) = default;
+
+private:
+  std::string_view source_;
+  Syntax syntax_ = Syntax::URL_ENCODED;
+  mutable bool parsed_ = false;
+  mutable std::vector<Field> fields_;
+
+  /** Beyond this many fields, keys are looked up through `index_` instead of a linear scan */
+  static constexpr size_t INDEX_THRESHOLD_ = 16;
+
+  /** Position of each key in `fields_`, once there are more than INDEX_THRESHOLD_ of them */
+  mutable std::unordered_map<std::string_view, size_t> index_;
+
+  /** Decoded keys and values, allocated on the first escape. Never grows, so views stay valid. */
+  mutable std::unique_ptr<char[]> decoded_;
+  mutable size_t decoded_size_ = 0;
+
+  /**
+   * Splits the source into fields, once.
+   * @private
+   */
+  void parse() const;
+
+  /**
+   * @returns `raw` if it has nothing to decode, else a view of its decoded copy.
+   * @private
+   */
+  std::string_view decode(std::string_view raw) const;
+
+  /**
+   * @returns Position of the field with the given key, or the number of fields.
+   * @private
+   */
+  size_t find(std::string_view key) const;
+
+  /**
+   * Makes the newly added field at `position` findable, indexing every field once there are
+   * more than INDEX_THRESHOLD_.
+   * @private
+   */
+  void index_field(size_t position) const;
+
+  /**
+   * Same as find(), without parsing first.
+   * @private
+   */
+  size_t find_parsed(std::string_view key) const;
+};
+} // namespace express
+
+#endif
@@ -1,38 +1,170 @@
 #ifndef EXPRESS_PUBLIC_REQUEST_H
 #define EXPRESS_PUBLIC_REQUEST_H
 
+#include "headers.h"
+#include "parameters.h"
 #include "types.h"
+#include <coroutine>
 #include <functional>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 
 namespace express {
+struct OwnedRequest;
+class BodyStream;
+
+/**
+ * @brief Thrown by Request::body_chunk() when a streamed body ends early: the client went away,
+ * sent a malformed body, or exceeded the route's size limit. Handlers that let it propagate are
+ * answered with its status.
+ */
+class BodyError : public std::runtime_error {
+public:
+  BodyError(int status, const std::string &message)
+      : std::runtime_error(message), status_(status) {}
+
+  /**
+   * @returns The HTTP status the request should be answered with, e.g. 413.
+   */
+  int status() const noexcept { return status_; }
+
+private:
+  int status_;
+};
+
+/**
+ * @brief Parsed HTTP request.
+ *
+ * The request keeps one copy of the raw message, and the method, URL, path, version, headers
+ * and body are views into it: parsing allocates no string per field. The views stay valid for
+ * as long as the request, which the server keeps until the response completes. Handlers that
+ * need the data after that take a copy with to_owned().
+ */
 class Request {
 public:
   /**
    * Initializes a Request object and parses a raw HTTP request.
    *
-   * @param raw_request The complete HTTP request string
+   * @param raw_request The complete HTTP request string, copied once into the request
    * @note The constructor assumes the request is well-formed
    */
   Request(std::string_view raw_request);
 
+  /**
+   * Initializes a Request whose body is streamed to body_chunk() as it arrives.
+   *
+   * @param head The request line and headers, copied once into the request
+   * @param body Stream the server appends the body to
+   */
+  Request(std::string_view head, std::shared_ptr<BodyStream> body);
+
+  std::string_view method;
+  std::string_view original_url;
+  std::string_view path;
+  /**
+   * Route parameters captured by the matched route, e.g. `id` for `/users/:id`. Keys and values
+   * are views into the route pattern and into `path`, so they are not percent-decoded and stay
+   * valid for as long as the request and the router are.
+   */
+  std::map<std::string_view, std::string_view> params;
+  /** Query string parameters, parsed and decoded on first access */
+  Parameters query;
+  /**
+   * Part of `path` the running middleware or route was mounted under, e.g. `/api` for a route
+   * of a router mounted at `/api`. The rest of `path` is the path relative to the mount point.
+   */
+  std::string_view base_url;
+  std::string_view http_version;
+  /** Header fields, as sent. Values set by middleware must outlive the request. */
+  Headers headers;
+  /** The whole body, unless the route streams it with BodyOptions::stream */
+  std::string_view body;
+  /** Cookies sent in the Cookie header, parsed and decoded on first access */
+  Parameters cookies;
+  /**
+   * Fields of an application/x-www-form-urlencoded body, parsed and decoded on first access.
+   * Empty for other content types.
+   */
+  Parameters form;
+
+  /**
+   * @returns Value of a well-known header, or an empty view if it was not sent.
+   * @example req.header(Header::ContentLength)
+   */
+  std::string_view header(Header id) const;
+
+  /**
+   * @returns Value of the header with the given name, in any case, or an empty view.
+   */
+  std::string_view header(std::string_view name) const;
+
+  /**
+   * Copies the request into plain strings, for data kept after the response completes.
+   */
+  OwnedRequest to_owned() const;
+
+  /**
+   * @brief Awaitable yielding the next chunk of the request body.
+   */
+  class BodyChunkAwaitable {
+  public:
+    bool await_ready() const noexcept { return stream_ == nullptr; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    std::string_view await_resume();
+
+  private:
+    friend class Request;
+    BodyChunkAwaitable(std::string_view chunk, BodyStream *stream)
+        : chunk_(chunk), stream_(stream) {}
+    std::string_view chunk_;
+    BodyStream *stream_;
+  };
+
+  /**
+   * Awaits the next chunk of the request body, for coroutine handlers.
+   * @returns An awaitable yielding the chunk, valid until the next call, or an empty view once
+   * the body is exhausted.
+   * @throws BodyError from the awaitable if a streamed body ends early.
+   * @note Unless the route streams the body, the server frames it whole before running handlers,
+   * so the first chunk is the entire body and awaiting never suspends.
+   * @example while (!(chunk = co_await req.body_chunk()).empty()) { ... }
+   */
+  BodyChunkAwaitable body_chunk();
+
+  // Rule of 5
+  ~Request();
+  Request(const Request &) = delete;
+  Request &operator=(const Request &) = delete;
+  Request(Request &&) = default;
+  Request &operator=(Request &&) = default;
+
+private:
+  /** The raw message every view points into. Its bytes stay put when the request moves. */
+  std::unique_ptr<char[]> buffer_;
+
+  /** Number of body bytes already handed out by body_chunk() */
+  size_t body_offset_ = 0;
+
+  /** Body still arriving, for routes that stream it; shared with the server appending to it */
+  std::shared_ptr<BodyStream> body_stream_;
+};
+
+/**
+ * @brief Request data copied out of a Request by to_owned(), valid independently of it.
+ */
+struct OwnedRequest {
   std::string method;
   std::string original_url;
   std::string path;
   std::map<std::string, std::string> params;
+  std::map<std::string, std::string> query;
+  std::string base_url;
   std::string http_version;
   std::map<std::string, std::string> headers;
   std::string body;
-
-  // Rule of 5
-  ~Request() = default;
-  Request(const Request &) = delete;
-  Request &operator=(const Request &) = delete;
-  Request(Request &&) = default;
-  Request &operator=(Request &&) = default;
 };
 
 } // namespace express
@@ -3,17 +3,38 @@
 
 #include "concepts.h"
 #include "types.h"
+#include <chrono>
+#include <coroutine>
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace express {
+class ResponseCache;
 class Server;
 
 class Response {
 public:
+  /**
+   * @brief Awaitable resuming a coroutine handler once the written data reached the socket.
+   */
+  class WriteAwaitable {
+  public:
+    bool await_ready() const noexcept { return !*wait_for_drain_; }
+    void await_suspend(std::coroutine_handle<> handle) const { (*wait_for_drain_)(handle); }
+    void await_resume() const noexcept {}
+
+  private:
+    friend class Response;
+    explicit WriteAwaitable(const std::function<void(std::coroutine_handle<>)> *wait_for_drain)
+        : wait_for_drain_(wait_for_drain) {}
+    const std::function<void(std::coroutine_handle<>)> *wait_for_drain_;
+  };
+
   /**
    * Sends a response to the client with the specified body content.
    * @param data The data to send.
@@ -71,8 +92,7 @@ public:
    * @returns Reference to this response for chaining
    */
   template <typename T> Response &json(const T &data) {
-    std::string serialized = nlohmann::json(data).dump(2);
-    return json_str(std::move(serialized));
+    return json_body(dump_json(nlohmann::json(data), 2));
   }
 
   /**
@@ -109,11 +129,38 @@ public:
 
   /**
    * Ends the response without sending any data.
-   * @param header
-   * @param value
+   * @warning Finalizing action. Locks down the response from further sends.
+   * @throws Error if the response has already been sent.
    */
   void end();
 
+  /**
+   * Sends the contents of a file. The epoll backend sends it straight from the page cache with
+   * sendfile; io_uring has no sendfile, so it reads the file into a buffer a chunk at a time,
+   * off the reactor thread, and sends that.
+   * @param path The file to send. Sending a path with send() does the same.
+   * @note Content-Length comes from the file size, and Content-Type from the extension unless
+   * already set.
+   * @note Answers 404 if the path cannot be opened or is not a regular file.
+   * @warning Finalizing action. Locks down the response from further sends.
+   * @throws Error if a redundant send is attempted.
+   * @returns Reference to this response for chaining
+   */
+  Response &send_file(const std::filesystem::path &path);
+
+  /**
+   * Streams part of the body to the client using chunked transfer encoding.
+   * The first write sends the status line and headers; end() finishes the body.
+   * @note HTTP/1.0 clients cannot parse chunks, so they get the raw bytes and the connection
+   * closes after the response to mark the end of the body.
+   * @param chunk Body bytes to send. Empty chunks are skipped.
+   * @throws Error if the response was already sent with send() or end().
+   * @returns Awaitable resuming the handler once the connection's output drained, so slow
+   * clients push back on coroutine handlers. Synchronous handlers may discard it.
+   * @example co_await res.write("data: tick\n\n");
+   */
+  WriteAwaitable write(std::string_view chunk);
+
   // Rule of 5
   ~Response();
   Response(const Response &) = delete;
@@ -122,12 +169,88 @@ public:
   Response &operator=(Response &&) = default;
 
 protected:
-  explicit Response(std::function<void(const std::vector<char>)> write_to_socket,
-                    std::function<void()> close_socket);
+  /**
+   * @param write_to_socket Called with each buffer of the serialized response: the head, then
+   * the body, or each streamed chunk. Takes ownership so the buffers are sent without a copy.
+   * @param wait_for_drain Resumes the given coroutine once the bytes written so far are sent.
+   * Without it, writes never suspend.
+   * @param write_file_to_socket Takes ownership of an open file and sends its first `length`
+   * bytes after everything written so far. Without it, files are read into the body.
+   * @param write_shared_to_socket Sends an immutable buffer that other responses may be sending
+   * too, keeping a reference until it is written. Without it, the buffer is copied.
+   * @note The connection's lifetime belongs to the server, which decides whether to keep it open.
+   */
+  explicit Response(std::function<void(std::vector<char>)> write_to_socket,
+                    std::function<void(std::coroutine_handle<>)> wait_for_drain = {},
+                    std::function<void(int file_fd, size_t length)> write_file_to_socket = {},
+                    std::function<void(std::shared_ptr<const std::vector<char>>)>
+                        write_shared_to_socket = {});
+
+  /**
+   * Records the HTTP version of the request being answered. Bodies streamed to an HTTP/1.0
+   * peer are sent unframed and end when the connection closes.
+   */
+  void set_http_version(std::string_view version);
+
+  /**
+   * @returns True once the body was streamed unframed, so only closing the connection ends it.
+   */
+  bool close_delimited();
 
 private:
+  friend class ResponseCache;
   friend class Server;
-  Response &json_str(const std::string &data);
+
+  /**
+   * Sends serialized JSON as the body, setting Content-Type unless already set.
+   */
+  Response &json_body(std::vector<char> body);
+
+  /**
+   * Serializes JSON straight into a body buffer, without an intermediate string.
+   */
+  static std::vector<char> dump_json(const nlohmann::json &data, int indent);
+
+  /**
+   * @brief Complete response as kept by the response cache, without the headers that differ
+   * between requests (Date and Connection).
+   */
+  struct Snapshot {
+    int status_code;
+    /** Status line and header lines, each ending in CRLF, without the blank line */
+    std::string head;
+    /** Shared with every connection the snapshot is replayed to, so hits never copy it */
+    std::shared_ptr<const std::vector<char>> body;
+  };
+
+  /**
+   * Registers a callback receiving the response once it is sent in one piece, e.g. by send().
+   * Streamed and file responses are not reported.
+   */
+  void observe(std::function<void(Snapshot)> observer);
+
+  /**
+   * Sends a response kept by the response cache instead of running the handler.
+   * @param age Time since the snapshot was taken, sent as the Age header.
+   * @throws Error if the response was already sent.
+   */
+  void send_snapshot(const Snapshot &snapshot, std::chrono::seconds age);
+
+  /**
+   * Returns the value of a response header, or an empty string if it is not set.
+   */
+  std::string_view header(std::string_view name);
+
+  /**
+   * Terminates a chunked body the handler left open.
+   */
+  void finish();
+
+  /**
+   * Sends only the status line and headers from now on, as HEAD requests require. The headers
+   * still describe the body the handler sends, e.g. its Content-Length.
+   */
+  void omit_body();
 
   class Impl;
   std::unique_ptr<Impl> pImpl;
@@ -0,0 +1,37 @@
+#ifndef EXPRESS_PUBLIC_SHARD_STATS_H
+#define EXPRESS_PUBLIC_SHARD_STATS_H
+
+#include <cstddef>
+
+namespace express {
+/**
+ * @brief Snapshot of the traffic one reactor thread has handled since listen()
+ *
+ * With several reactor threads, compare these across shards to check that the kernel is
+ * spreading connections evenly.
+ */
+struct ShardStats {
+  /** Index of the reactor thread */
+  size_t shard = 0;
+
+  /** Connections accepted by this shard */
+  size_t connections_accepted = 0;
+
+  /** Accepts that failed, e.g. because the process ran out of file descriptors */
+  size_t accept_errors = 0;
+
+  /** Connections currently open on this shard */
+  size_t open_connections = 0;
+
+  /** Requests dispatched to the router by this shard */
+  size_t requests_handled = 0;
+
+  /** Bytes read from clients */
+  size_t bytes_read = 0;
+
+  /** Bytes written to clients */
+  size_t bytes_written = 0;
+};
+} // namespace express
+
+#endif
@@ -0,0 +1,368 @@
+#ifndef EXPRESS_PUBLIC_STATIC_ROUTES_H
+#define EXPRESS_PUBLIC_STATIC_ROUTES_H
+
+#include "request.h"
+#include "task.h"
+#include "types.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace express {
+/**
+ * @brief String literal usable as a template argument, e.g. the `"/health"` in
+ * `route<"GET", "/health">`.
+ */
+template <size_t N> struct FixedString {
+  char value[N]{};
+
+  constexpr FixedString(const char (&text)[N]) { std::copy_n(text, N, value); }
+
+  constexpr std::string_view view() const { return std::string_view(value, N - 1); }
+};
+
+namespace detail {
+/**
+ * @brief Piece of a route pattern: static text to compare, or a named capture.
+ */
+struct PatternPiece {
+  enum class Kind { TEXT, CAPTURE, WILDCARD };
+  Kind kind;
+  std::string_view text;
+};
+
+/** Drops one trailing slash, so `/users/` routes like `/users` */
+constexpr std::string_view normalize_path(std::string_view path) {
+  if (path.size() > 1 && path.back() == '/')
+    path.remove_suffix(1);
+  return path;
+}
+
+/** Number of pieces `split_pattern` produces for a pattern */
+constexpr size_t count_pieces(std::string_view pattern) {
+  size_t pieces = 0;
+  bool in_text = false;
+  for (size_t i = 0; i < pattern.size(); i++) {
+    bool segment_start = i > 0 && pattern[i - 1] == '/';
+    if (segment_start && (pattern[i] == ':' || pattern[i] == '*')) {
+      pieces++;
+      in_text = false;
+      if (pattern[i] == '*')
+        break;
+      while (i + 1 < pattern.size() && pattern[i + 1] != '/')
+        i++;
+    } else if (!in_text) {
+      pieces++;
+      in_text = true;
+    }
+  }
+  return pieces;
+}
+
+/**
+ * Splits a pattern into static text and captures, with the same syntax as Router: `:name`
+ * captures one segment and a trailing `*name` (or `*`) captures the rest of the path.
+ */
+template <size_t Count>
+constexpr std::array<PatternPiece, Count> split_pattern(std::string_view pattern) {
+  std::array<PatternPiece, Count> pieces{};
+  size_t count = 0;
+  size_t text_start = 0;
+  bool in_text = false;
+  for (size_t i = 0; i < pattern.size(); i++) {
+    bool segment_start = i > 0 && pattern[i - 1] == '/';
+    if (segment_start && (pattern[i] == ':' || pattern[i] == '*')) {
+      if (in_text)
+        pieces[count - 1].text = pattern.substr(text_start, i - text_start);
+      in_text = false;
+      if (pattern[i] == '*') {
+        std::string_view name = pattern.substr(i + 1);
+        if (name.find('/') != std::string_view::npos)
+          throw "Route wildcard must be the last segment";
+        pieces[count++] = {PatternPiece::Kind::WILDCARD, name.empty() ? "*" : name};
+        return pieces;
+      }
+      size_t end = pattern.find('/', i);
+      std::string_view name = pattern.substr(i + 1, end == std::string_view::npos
+                                                         ? std::string_view::npos
+                                                         : end - i - 1);
+      if (name.empty())
+        throw "Route parameter has no name";
+      pieces[count++] = {PatternPiece::Kind::CAPTURE, name};
+      i += name.size();
+    } else if (!in_text) {
+      pieces[count++] = {PatternPiece::Kind::TEXT, {}};
+      text_start = i;
+      in_text = true;
+    }
+  }
+  if (in_text)
+    pieces[count - 1].text = pattern.substr(text_start);
+  return pieces;
+}
+
+/** FNV-1a over the method, a space and the path, salted by a seed to search for a perfect hash */
+constexpr uint64_t route_hash(std::string_view method, std::string_view path, uint64_t seed) {
+  uint64_t hash = 14695981039346656037ull ^ seed;
+  auto mix = [&hash](char c) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  };
+  for (char c : method)
+    mix(c);
+  mix(' ');
+  for (char c : path)
+    mix(c);
+  return hash ^ (hash >> 29);
+}
+
+/** Runs a handler, returning the task of a coroutine handler or an empty task */
+template <typename F>
+Task<> invoke_route_handler(const F &handler, Request &request, Response &response) {
+  if constexpr (std::is_same_v<std::invoke_result_t<const F &, Request &, Response &>, Task<>>) {
+    return handler(request, response);
+  } else {
+    handler(request, response);
+    return Task<>();
+  }
+}
+} // namespace detail
+
+/**
+ * @brief Route whose method and pattern are fixed at compile time. Built by `express::route`.
+ */
+template <FixedString Method, FixedString Pattern, typename F> struct StaticRoute {
+  static constexpr std::string_view method = Method.view();
+  static constexpr std::string_view pattern = detail::normalize_path(Pattern.view());
+  static constexpr size_t piece_count = detail::count_pieces(pattern);
+  static constexpr std::array<detail::PatternPiece, piece_count> pieces =
+      detail::split_pattern<piece_count>(pattern);
+  /** True if the pattern has no captures, so the route can live in the perfect hash table */
+  static constexpr bool is_exact =
+      piece_count == 0 ||
+      (piece_count == 1 && pieces[0].kind == detail::PatternPiece::Kind::TEXT);
+
+  F handler;
+
+  /**
+   * Matches a normalized path against the pattern, capturing parameters on success.
+   * @private
+   */
+  static bool match(std::string_view path, decltype(Request::params) &params) {
+    std::array<std::string_view, piece_count> captured{};
+    for (size_t i = 0; i < piece_count; i++) {
+      const detail::PatternPiece &piece = pieces[i];
+      if (piece.kind == detail::PatternPiece::Kind::TEXT) {
+        if (!path.starts_with(piece.text))
+          return false;
+        path.remove_prefix(piece.text.size());
+      } else if (piece.kind == detail::PatternPiece::Kind::CAPTURE) {
+        captured[i] = path.substr(0, path.find('/'));
+        if (captured[i].empty())
+          return false;
+        path.remove_prefix(captured[i].size());
+      } else {
+        captured[i] = path;
+        path = {};
+      }
+    }
+    if (!path.empty())
+      return false;
+    for (size_t i = 0; i < piece_count; i++) {
+      if (pieces[i].kind != detail::PatternPiece::Kind::TEXT)
+        params[pieces[i].text] = captured[i];
+    }
+    return true;
+  }
+};
+
+/**
+ * Declares a route for a compile-time route table.
+ * @tparam Method HTTP method, e.g. "GET".
+ * @tparam Pattern Route pattern, with the same syntax as runtime routes.
+ * @param handler Handler taking (Request &, Response &), returning void or Task<>.
+ * @example express::route<"GET", "/health">([](auto &req, auto &res) { res.send("ok"); })
+ */
+template <FixedString Method, FixedString Pattern, typename F>
+constexpr StaticRoute<Method, Pattern, F> route(F handler) {
+  return StaticRoute<Method, Pattern, F>{std::move(handler)};
+}
+
+/**
+ * @brief Route table built entirely at compile time.
+ *
+ * Routes without captures are found through a perfect hash of the method and path, computed
+ * at compile time, followed by one string comparison. Routes with captures are matched in
+ * declaration order, by comparisons generated from their patterns. Handlers are called
+ * directly, without type erasure. Two routes with the same method and path and no captures do
+ * not compile. Mount a table on a router with `use(prefix, table)`.
+ *
+ * @example app.use("/api", express::routes(express::route<"GET", "/health">(health)));
+ */
+template <typename... Routes> class StaticRoutes final : public RouteTable {
+public:
+  explicit StaticRoutes(Routes... routes) : routes_(std::move(routes)...) {}
+
+  /**
+   * Dispatches a request to the route matching its method and path.
+   * @param path Path relative to the mount point.
+   * @returns Nothing if no route matches, otherwise the task running a coroutine handler, or an
+   * empty task if the handler already ran to completion.
+   */
+  std::optional<Task<>> operator()(std::string_view path, Request &request,
+                                   Response &response) const {
+    return dispatch(request.method, path, request, response);
+  }
+
+  std::optional<Task<>> dispatch(std::string_view method, std::string_view path,
+                                 Request &request, Response &response) const override {
+    path = detail::normalize_path(path);
+    if constexpr (EXACT_COUNT_ > 0) {
+      size_t index = find_exact(method, path);
+      if (index != EMPTY_)
+        return call(index, request, response, std::index_sequence_for<Routes...>());
+    }
+    return match_captures(method, path, request, response, std::index_sequence_for<Routes...>());
+  }
+
+  bool has_route(std::string_view method, std::string_view path) const override {
+    path = detail::normalize_path(path);
+    if constexpr (EXACT_COUNT_ > 0) {
+      if (find_exact(method, path) != EMPTY_)
+        return true;
+    }
+    decltype(Request::params) ignored;
+    return ((!Routes::is_exact && method == Routes::method && Routes::match(path, ignored)) ||
+            ...);
+  }
+
+private:
+  static constexpr size_t EMPTY_ = sizeof...(Routes);
+  static constexpr size_t EXACT_COUNT_ = (size_t{Routes::is_exact} + ... + 0);
+  static constexpr std::array<std::string_view, sizeof...(Routes)> METHODS_ = {Routes::method...};
+  static constexpr std::array<std::string_view, sizeof...(Routes)> PATTERNS_ = {
+      Routes::pattern...};
+
+  template <size_t Size> struct HashTable {
+    uint64_t seed = 0;
+    std::array<size_t, Size> slots{};
+  };
+
+  /** Power of two at most a quarter full, so a collision-free seed turns up quickly */
+  static constexpr size_t table_size() {
+    size_t size = 1;
+    while (size < 4 * EXACT_COUNT_)
+      size *= 2;
+    return size;
+  }
+
+  /**
+   * @returns True if two exact routes have the same method and path, which no seed can tell
+   * apart.
+   * @private
+   */
+  static constexpr bool has_duplicate_exact_routes() {
+    constexpr bool exact[] = {Routes::is_exact..., false};
+    for (size_t i = 0; i < sizeof...(Routes); i++) {
+      for (size_t j = i + 1; j < sizeof...(Routes); j++) {
+        if (exact[i] && exact[j] && METHODS_[i] == METHODS_[j] && PATTERNS_[i] == PATTERNS_[j])
+          return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Searches for a seed under which every exact route hashes to its own slot.
+   * @private
+   */
+  static constexpr HashTable<table_size()> build_table() {
+    static_assert(!has_duplicate_exact_routes(),
+                  "express::routes has two routes with the same method and path");
+    constexpr bool exact[] = {Routes::is_exact..., false};
+    HashTable<table_size()> table;
+    if (has_duplicate_exact_routes())
+      return table; // Already reported above; searching for a seed would never end
+    for (uint64_t seed = 0;; seed++) {
+      table.seed = seed;
+      table.slots.fill(EMPTY_);
+      bool collided = false;
+      for (size_t i = 0; i < sizeof...(Routes) && !collided; i++) {
+        if (!exact[i])
+          continue;
+        size_t slot = detail::route_hash(METHODS_[i], PATTERNS_[i], seed) & (table_size() - 1);
+        collided = table.slots[slot] != EMPTY_;
+        table.slots[slot] = i;
+      }
+      if (!collided)
+        return table;
+    }
+  }
+
+  static constexpr HashTable<table_size()> TABLE_ = build_table();
+
+  std::tuple<Routes...> routes_;
+
+  /**
+   * @returns Index of the exact route for a method and normalized path, or EMPTY_.
+   * @private
+   */
+  static size_t find_exact(std::string_view method, std::string_view path) {
+    uint64_t hash = detail::route_hash(method, path, TABLE_.seed);
+    size_t index = TABLE_.slots[hash & (TABLE_.slots.size() - 1)];
+    if (index != EMPTY_ && method == METHODS_[index] && path == PATTERNS_[index])
+      return index;
+    return EMPTY_;
+  }
+
+  /**
+   * Calls the handler of the route at a runtime index, through a switch over the routes.
+   * @private
+   */
+  template <size_t... I>
+  Task<> call(size_t index, Request &request, Response &response,
+              std::index_sequence<I...>) const {
+    Task<> task;
+    ((index == I ? (task = detail::invoke_route_handler(std::get<I>(routes_).handler, request,
+                                                        response),
+                    true)
+                 : false) ||
+     ...);
+    return task;
+  }
+
+  /**
+   * Tries the routes with captures in declaration order.
+   * @private
+   */
+  template <size_t... I>
+  std::optional<Task<>> match_captures(std::string_view method, std::string_view path,
+                                       Request &request, Response &response,
+                                       std::index_sequence<I...>) const {
+    std::optional<Task<>> task;
+    ((!Routes::is_exact && method == Routes::method &&
+              Routes::match(path, request.params)
+          ? (task = detail::invoke_route_handler(std::get<I>(routes_).handler, request,
+                                                 response),
+             true)
+          : false) ||
+     ...);
+    return task;
+  }
+};
+
+/**
+ * Builds a compile-time route table from routes declared with `express::route`.
+ */
+template <typename... Routes> StaticRoutes<Routes...> routes(Routes... routes) {
+  return StaticRoutes<Routes...>(std::move(routes)...);
+}
+
+} // namespace express
+
+#endif
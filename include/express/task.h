@@ -0,0 +1,187 @@
+#ifndef EXPRESS_PUBLIC_TASK_H
+#define EXPRESS_PUBLIC_TASK_H
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace express {
+class Request;
+class Response;
+
+template <typename T = void> class Task;
+
+namespace detail {
+/**
+ * @brief State shared by every Task promise: who to resume on completion, and any exception.
+ */
+struct TaskPromiseBase {
+  /** Coroutine awaiting this task, resumed once it finishes */
+  std::coroutine_handle<> continuation;
+
+  /** Exception escaping the coroutine body, rethrown to the awaiter */
+  std::exception_ptr exception;
+
+  /**
+   * @brief Hands control straight back to the awaiting coroutine, without growing the stack.
+   */
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+      std::coroutine_handle<> continuation = handle.promise().continuation;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  // Tasks are lazy: the body runs once the task is awaited
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <typename T> struct TaskPromise : TaskPromiseBase {
+  std::optional<T> value;
+
+  Task<T> get_return_object() noexcept;
+
+  template <typename U>
+    requires std::is_convertible_v<U &&, T>
+  void return_value(U &&result) {
+    value.emplace(std::forward<U>(result));
+  }
+
+  T result() {
+    if (exception)
+      std::rethrow_exception(exception);
+    return std::move(*value);
+  }
+};
+
+template <> struct TaskPromise<void> : TaskPromiseBase {
+  Task<void> get_return_object() noexcept;
+
+  void return_void() const noexcept {}
+
+  void result() {
+    if (exception)
+      std::rethrow_exception(exception);
+  }
+};
+} // namespace detail
+
+/**
+ * @brief Lazily started coroutine returning a T, for use as an asynchronous route handler.
+ *
+ * A handler declared as `[](Request &req, Response &res) -> express::Task<> { ... }` may
+ * `co_await` other tasks, `express::sleep_for`, `req.body_chunk()` and `res.write()`.
+ * Suspended handlers hold no thread: the server's event loop resumes them once the awaited
+ * event happens.
+ *
+ * @tparam T Type of the value produced by `co_return`.
+ */
+template <typename T> class Task {
+public:
+  using promise_type = detail::TaskPromise<T>;
+
+  /** Creates an empty task, which holds no coroutine */
+  Task() noexcept = default;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+  /**
+   * @returns True if the task holds a coroutine.
+   */
+  explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+  /**
+   * @returns True once the coroutine ran to completion.
+   */
+  bool done() const noexcept { return handle_ && handle_.done(); }
+
+  // Awaitable interface: starts the task, and resumes the awaiter once it finishes
+  bool await_ready() const noexcept { return handle_.done(); }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    handle_.promise().continuation = awaiting;
+    return handle_;
+  }
+
+  T await_resume() { return handle_.promise().result(); }
+
+  // Rule of 5
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T> Task<T> detail::TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> detail::TaskPromise<void>::get_return_object() noexcept {
+  return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/**
+ * @brief Concept for route handlers written as coroutines returning Task<>
+ */
+template <typename F>
+concept CoroutineHandler = std::is_invocable_v<F, Request &, Response &> &&
+                           std::is_same_v<std::invoke_result_t<F, Request &, Response &>, Task<>>;
+
+/**
+ * @brief Awaitable suspending the calling handler for a duration, without blocking its thread.
+ */
+class SleepAwaitable {
+public:
+  explicit SleepAwaitable(std::chrono::steady_clock::duration duration) : duration_(duration) {}
+
+  bool await_ready() const noexcept { return duration_ <= std::chrono::steady_clock::duration(); }
+
+  /**
+   * Arms a timer on the event loop of the server running the handler.
+   * @throws std::logic_error if awaited outside a handler run by a server.
+   */
+  void await_suspend(std::coroutine_handle<> handle) const;
+
+  void await_resume() const noexcept {}
+
+private:
+  std::chrono::steady_clock::duration duration_;
+};
+
+/**
+ * Suspends the calling handler for at least the given duration.
+ * @example co_await express::sleep_for(std::chrono::milliseconds(50));
+ */
+inline SleepAwaitable sleep_for(std::chrono::steady_clock::duration duration) {
+  return SleepAwaitable(duration);
+}
+
+} // namespace express
+
+#endif
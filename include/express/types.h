@@ -2,8 +2,12 @@
 #define EXPRESS_PUBLIC_TYPES_H
 
 #include "request.h"
+#include "task.h"
 #include <functional>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 namespace express {
 
@@ -11,7 +15,66 @@ class Request;
 class Response;
 
 using Handler = std::function<void(Request &request, Response &response)>;
+using AsyncHandler = std::function<Task<>(Request &request, Response &response)>;
 using Callback = std::function<void()>;
+
+/**
+ * @brief Passed to middleware; calling it lets the request continue down the chain.
+ *
+ * Calling next() only marks the middleware as done: the chain continues once the middleware
+ * returns, so running it needs neither recursion nor an allocation per request.
+ */
+class Next {
+public:
+  void operator()() noexcept { called_ = true; }
+
+  /**
+   * @returns True if the middleware let the request continue.
+   */
+  bool called() const noexcept { return called_; }
+
+private:
+  bool called_ = false;
+};
+
+using Middleware = std::function<void(Request &request, Response &response, Next &next)>;
+using AsyncMiddleware = std::function<Task<>(Request &request, Response &response, Next &next)>;
+
+/**
+ * @brief Concept for middleware written as coroutines returning Task<>
+ */
+template <typename F>
+concept CoroutineMiddleware =
+    std::is_invocable_v<F, Request &, Response &, Next &> &&
+    std::is_same_v<std::invoke_result_t<F, Request &, Response &, Next &>, Task<>>;
+
+/**
+ * @brief Route table mounted under a path prefix with `use(prefix, table)`, such as one built at
+ * compile time by `express::routes`.
+ *
+ * The router holds mounted tables through this interface, so dispatching to one costs a single
+ * virtual call; the table's own lookup and handler calls need no further indirection.
+ */
+class RouteTable {
+public:
+  virtual ~RouteTable() = default;
+
+  /**
+   * Dispatches a request to the table's route for a method and path.
+   * @param method Method to match, which is GET when a HEAD request no route answers is retried.
+   * @param path Path relative to the mount point.
+   * @returns Nothing if no route matches, otherwise the task running a coroutine handler, or an
+   * empty task if the handler already ran to completion.
+   */
+  virtual std::optional<Task<>> dispatch(std::string_view method, std::string_view path,
+                                         Request &request, Response &response) const = 0;
+
+  /**
+   * @returns True if the table has a route for the method and path, which is relative to the
+   * mount point. Used to list a path's methods when answering OPTIONS.
+   */
+  virtual bool has_route(std::string_view method, std::string_view path) const = 0;
+};
 } // namespace express
 
 #endif
\ No newline at end of file
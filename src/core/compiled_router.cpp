@@ -0,0 +1,192 @@
+#include "compiled_router.h"
+
+std::optional<size_t> express::CompiledRouter::match_prefix(std::string_view path,
+                                                            std::string_view prefix) {
+  size_t matched = 0;
+  while (!prefix.empty()) {
+    if (matched >= path.size() || path[matched] != '/')
+      return std::nullopt;
+    std::string_view expected = prefix.substr(1, prefix.find('/', 1) - 1);
+    std::string_view segment = path.substr(matched + 1, path.find('/', matched + 1) - matched - 1);
+    bool is_capture = expected.starts_with(':');
+    if (is_capture ? segment.empty() : segment != expected)
+      return std::nullopt;
+    matched += 1 + segment.size();
+    prefix.remove_prefix(1 + expected.size());
+  }
+  if (matched < path.size() && path[matched] != '/')
+    return std::nullopt; // Prefix ends mid-segment
+  return matched;
+}
+
+const express::BodyOptions *express::CompiledRouter::body_options(std::string_view method,
+                                                                 std::string_view target) const {
+  if (body_options_.empty())
+    return nullptr; // Spares requests the route lookup when no route has options
+  std::optional<HttpVerb::Value> verb = HttpVerb::decode(method);
+  if (!verb)
+    return nullptr;
+  decltype(Request::params) ignored;
+  const Route *matched = routes(*verb).find(target.substr(0, target.find('?')), ignored);
+  if (matched == nullptr || matched->body == 0)
+    return nullptr;
+  return &body_options_[matched->body - 1];
+}
+
+express::Task<> express::CompiledRouter::run(Request &request, Response &response) const {
+  for (size_t i = 0; i < middleware_.size(); i++) {
+    const MiddlewareEntry &entry = middleware_[i];
+    std::optional<size_t> base = match_prefix(request.path, entry.path);
+    if (!base)
+      continue;
+    if (std::holds_alternative<AsyncMiddleware>(entry.middleware)) {
+      return run_middleware_from(i, request, response);
+    }
+    request.base_url = std::string_view(request.path).substr(0, *base);
+    Next next;
+    std::get<Middleware>(entry.middleware)(request, response, next);
+    if (!next.called() || response.headers_sent())
+      return Task<>();
+  }
+  return route(request, response);
+}
+
+express::Task<> express::CompiledRouter::run_middleware_from(size_t first, Request &request,
+                                                             Response &response) const {
+  for (size_t i = first; i < middleware_.size(); i++) {
+    const MiddlewareEntry &entry = middleware_[i];
+    std::optional<size_t> base = match_prefix(request.path, entry.path);
+    if (!base)
+      continue;
+    request.base_url = std::string_view(request.path).substr(0, *base);
+    Next next;
+    if (const AsyncMiddleware *middleware = std::get_if<AsyncMiddleware>(&entry.middleware)) {
+      co_await (*middleware)(request, response, next);
+    } else {
+      std::get<Middleware>(entry.middleware)(request, response, next);
+    }
+    if (!next.called() || response.headers_sent())
+      co_return;
+  }
+
+  Task<> task = route(request, response);
+  if (task)
+    co_await task;
+}
+
+express::Task<> express::CompiledRouter::route(Request &request, Response &response) const {
+  std::string_view path = request.path;
+  std::optional<Task<>> task = route_tables(request.method, request, response);
+  if (task)
+    return std::move(*task);
+
+  std::optional<HttpVerb::Value> verb = HttpVerb::decode(request.method);
+  if (!verb)
+    return Task<>(); // Unknown method, answered 404 like a missing route
+  const Route *matched = routes(*verb).find(path, request.params);
+  if (matched == nullptr && verb == HttpVerb::Value::HEAD) {
+    // Only once no HEAD route answered anywhere, so an explicit one wins over a table's GET
+    task = route_tables("GET", request, response);
+    if (task)
+      return std::move(*task);
+    matched = routes(HttpVerb::Value::GET).find(path, request.params);
+  }
+  if (matched == nullptr) {
+    if (verb == HttpVerb::Value::OPTIONS)
+      answer_options(request, response);
+    return Task<>();
+  }
+  for (size_t i = 0; i < matched->count; i++) {
+    enter_mount(*matched, i, request);
+    const RouteHandler &handler = handlers_[matched->first + i];
+    if (std::holds_alternative<AsyncHandler>(handler)) {
+      // Synchronous handlers never pay for a coroutine frame
+      return run_from(*matched, i, request, response);
+    }
+    if (const Middleware *middleware = std::get_if<Middleware>(&handler)) {
+      Next next;
+      (*middleware)(request, response, next);
+      if (!next.called() || response.headers_sent())
+        return Task<>();
+      continue;
+    }
+    std::get<Handler>(handler)(request, response);
+  }
+  return Task<>();
+}
+
+std::optional<express::Task<>> express::CompiledRouter::route_tables(std::string_view method,
+                                                                    Request &request,
+                                                                    Response &response) const {
+  std::string_view path = request.path;
+  for (const MountedTable &mounted : tables_) {
+    std::optional<size_t> base = match_prefix(path, mounted.prefix);
+    if (!base)
+      continue;
+    request.base_url = path.substr(0, *base);
+    std::string_view relative = path.substr(*base);
+    std::optional<Task<>> task =
+        mounted.table->dispatch(method, relative.empty() ? "/" : relative, request, response);
+    if (task)
+      return task;
+  }
+  return std::nullopt;
+}
+
+bool express::CompiledRouter::has_route(HttpVerb::Value verb, std::string_view path) const {
+  decltype(Request::params) ignored;
+  if (routes(verb).find(path, ignored) != nullptr)
+    return true;
+  std::string method = HttpVerb::toString(verb);
+  for (const MountedTable &mounted : tables_) {
+    std::optional<size_t> base = match_prefix(path, mounted.prefix);
+    std::string_view relative = base ? path.substr(*base) : std::string_view();
+    if (base && mounted.table->has_route(method, relative.empty() ? "/" : relative))
+      return true;
+  }
+  return false;
+}
+
+void express::CompiledRouter::enter_mount(Route route, size_t index, Request &request) const {
+  size_t position = route.first + index;
+  if (index > 0 && handler_mounts_[position].data() == handler_mounts_[position - 1].data())
+    return;
+  std::string_view path = request.path;
+  request.base_url = path.substr(0, match_prefix(path, handler_mounts_[position]).value_or(0));
+}
+
+bool express::CompiledRouter::answer_options(Request &request, Response &response) const {
+  std::string allow;
+  for (size_t i = 0; i < HttpVerb::COUNT; i++) {
+    HttpVerb::Value verb = static_cast<HttpVerb::Value>(i);
+    bool routed = has_route(verb, request.path);
+    bool derived = verb == HttpVerb::Value::HEAD && has_route(HttpVerb::Value::GET, request.path);
+    if (routed || derived) {
+      allow += allow.empty() ? "" : ",";
+      allow += HttpVerb::toString(verb);
+    }
+  }
+  if (allow.empty())
+    return false;
+  response.set("Allow", allow);
+  response.send(allow);
+  return true;
+}
+
+express::Task<> express::CompiledRouter::run_from(Route route, size_t first, Request &request,
+                                                  Response &response) const {
+  for (size_t i = first; i < route.count; i++) {
+    enter_mount(route, i, request);
+    const RouteHandler &handler = handlers_[route.first + i];
+    if (const AsyncHandler *async_handler = std::get_if<AsyncHandler>(&handler)) {
+      co_await (*async_handler)(request, response);
+    } else if (const Middleware *middleware = std::get_if<Middleware>(&handler)) {
+      Next next;
+      (*middleware)(request, response, next);
+      if (!next.called() || response.headers_sent())
+        co_return;
+    } else {
+      std::get<Handler>(handler)(request, response);
+    }
+  }
+}
@@ -0,0 +1,130 @@
+#ifndef EXPRESS_COMPILED_ROUTER_H
+#define EXPRESS_COMPILED_ROUTER_H
+
+#include "core/route_tree.h"
+#include "http/http_verb.h"
+#include <express/body_options.h>
+#include <express/request.h>
+#include <express/response.h>
+#include <express/types.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+namespace express {
+class Router;
+
+/**
+ * @brief Immutable dispatch table built by Router::compile(), shared by every server thread.
+ *
+ * All route handlers live in one contiguous array, each route referring to its run of handlers
+ * by index, and every path the table keeps is interned once. Nothing is modified after
+ * compilation, so any number of threads can run requests through the same table.
+ */
+class CompiledRouter {
+public:
+  using RouteHandler = std::variant<Handler, AsyncHandler, Middleware>;
+  using MiddlewareHandler = std::variant<Middleware, AsyncMiddleware>;
+
+  /**
+   * Executes an incoming request: the middleware chain, then the matching route.
+   * @returns An empty task if every handler ran to completion, or the task running the rest of
+   * the handlers once one of them is a coroutine.
+   */
+  Task<> run(Request &request, Response &response) const;
+
+  /**
+   * Returns the length of the part of `path` matching `prefix` segment by segment, with `:name`
+   * matching any segment, or nothing if the path is not under the prefix.
+   */
+  static std::optional<size_t> match_prefix(std::string_view path, std::string_view prefix);
+
+  /**
+   * Returns the body options of the route a request would be dispatched to, or nullptr if that
+   * route was registered without any. Routes of mounted tables have none.
+   * @param target Request target, whose query string is ignored.
+   */
+  const BodyOptions *body_options(std::string_view method, std::string_view target) const;
+
+  // Rule of 5. Tables are shared by pointer; the interned paths are viewed, so never copied.
+  ~CompiledRouter() = default;
+  CompiledRouter(const CompiledRouter &) = delete;
+  CompiledRouter &operator=(const CompiledRouter &) = delete;
+  CompiledRouter(CompiledRouter &&) = delete;
+  CompiledRouter &operator=(CompiledRouter &&) = delete;
+
+private:
+  friend class Router;
+  CompiledRouter() = default;
+
+  /** Run of `handlers_` making up one route */
+  struct Route {
+    uint32_t first = 0;
+    uint32_t count = 0;
+    /** Position of the route's options in `body_options_` plus one, or 0 for none */
+    uint32_t body = 0;
+  };
+
+  struct MountedTable {
+    std::string_view prefix;
+    std::shared_ptr<const RouteTable> table;
+  };
+
+  struct MiddlewareEntry {
+    std::string_view path;
+    MiddlewareHandler middleware;
+  };
+
+  /** Interned paths, whose nodes never move so views of them stay valid */
+  std::unordered_set<std::string> strings_;
+  std::vector<RouteHandler> handlers_;
+  // Path of the router each handler was registered on, parallel to `handlers_`. Interned, so
+  // equal mounts share their characters.
+  std::vector<std::string_view> handler_mounts_;
+  // One tree per verb, indexed by HttpVerb::Value
+  std::array<RouteTree<Route>, HttpVerb::COUNT> routes_;
+  std::vector<MountedTable> tables_;
+  // Middleware chain, kept contiguous so running it walks one array without allocating
+  std::vector<MiddlewareEntry> middleware_;
+  // Options of the routes registered with BodyOptions, usually none
+  std::vector<BodyOptions> body_options_;
+
+  std::string_view intern(const std::string &text) { return *strings_.insert(text).first; }
+
+  const RouteTree<Route> &routes(HttpVerb::Value verb) const {
+    return routes_[static_cast<size_t>(verb)];
+  }
+
+  // Dispatches to the matching mounted table or route, once the middleware chain let it through
+  Task<> route(Request &request, Response &response) const;
+
+  // Dispatches to the first mounted table with a route for the method, if any
+  std::optional<Task<>> route_tables(std::string_view method, Request &request,
+                                     Response &response) const;
+
+  // Returns whether the tree or a mounted table has a route for the verb and path
+  bool has_route(HttpVerb::Value verb, std::string_view path) const;
+
+  // Points base_url at the mount of a route's handler, unless the previous handler of the route
+  // had the same one; a route merges handlers of routers mounted at different paths
+  void enter_mount(Route route, size_t index, Request &request) const;
+
+  // Answers an OPTIONS request with the methods that have a route for the path, if any
+  bool answer_options(Request &request, Response &response) const;
+
+  // Continues the middleware chain from `first` once a middleware is a coroutine, then routes
+  Task<> run_middleware_from(size_t first, Request &request, Response &response) const;
+
+  // Runs the handlers of a route from `first` on, suspending on each coroutine handler until it
+  // finishes, and stopping at route middleware that does not let the request through
+  Task<> run_from(Route route, size_t first, Request &request, Response &response) const;
+};
+} // namespace express
+
+#endif
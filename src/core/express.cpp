@@ -1,8 +1,13 @@
 #include "core/router.h"
+#include "core/router_slot.h"
 #include "net/servers/server.h"
+#include "net/servers/worker_pool.h"
 #include "utils/constants.h"
+#include <algorithm>
+#include <atomic>
 #include <express/express.h>
 #include <memory>
+#include <mutex>
 
 namespace express {
 
@@ -11,30 +16,179 @@ class Express::Impl : public Router {
 public:
   Impl() = default;
 
-  void listen(int port, Callback callback) {
+  void listen(int port, ListenOptions options, Callback callback) {
     using namespace express::constants;
     express::SocketConfig config = {DEFAULT_DOMAIN, DEFAULT_SERVICE,   DEFAULT_PROTOCOL,
                                     port,           DEFAULT_INTERFACE, DEFAULT_BACKLOG};
-    server_ = std::make_unique<Server>(config, *this);
-    server_->launch();
+    size_t reactor_threads = std::max<size_t>(1, options.reactor_threads);
+    config.reuse_port = reactor_threads > 1;
+
+    if (options.worker_threads > 0) {
+      worker_pool_ = std::make_unique<WorkerPool>(options.worker_threads);
+    }
+    {
+      std::lock_guard<std::mutex> lock(routes_mutex_);
+      router_slot_ = std::make_shared<RouterSlot>(compile());
+    }
+    for (size_t i = 0; i < reactor_threads; i++) {
+      servers_.push_back(
+          std::make_unique<Server>(config, router_slot_, options, worker_pool_.get()));
+    }
+    is_running_ = true;
+    for (std::unique_ptr<Server> &server : servers_) {
+      server->launch();
+    }
     callback();
     block_while_running();
   }
 
-  void shutdown() { server_ = nullptr; }
+  void shutdown() {
+    is_running_ = false;
+    for (std::unique_ptr<Server> &server : servers_) {
+      server->stop();
+    }
+    worker_pool_ = nullptr; // Finishes queued handlers while the servers can still take their output
+    servers_.clear();
+  }
+
+  std::vector<ShardStats> stats() {
+    std::vector<ShardStats> shard_stats;
+    for (size_t i = 0; i < servers_.size(); i++) {
+      ShardStats snapshot = servers_[i]->stats();
+      snapshot.shard = i;
+      shard_stats.push_back(snapshot);
+    }
+    return shard_stats;
+  }
+
+  void get(std::string route, Handler handler) {
+    update([&] { Router::get(route, std::move(handler)); });
+  }
+
+  void post(std::string route, Handler handler) {
+    update([&] { Router::post(route, std::move(handler)); });
+  }
+
+  void put(std::string route, Handler handler) {
+    update([&] { Router::put(route, std::move(handler)); });
+  }
+
+  void del(std::string route, Handler handler) {
+    update([&] { Router::del(route, std::move(handler)); });
+  }
+
+  void get(std::string route, AsyncHandler handler) {
+    update([&] { Router::get(route, std::move(handler)); });
+  }
+
+  void post(std::string route, AsyncHandler handler) {
+    update([&] { Router::post(route, std::move(handler)); });
+  }
+
+  void put(std::string route, AsyncHandler handler) {
+    update([&] { Router::put(route, std::move(handler)); });
+  }
+
+  void del(std::string route, AsyncHandler handler) {
+    update([&] { Router::del(route, std::move(handler)); });
+  }
+
+  void patch(std::string route, Handler handler) {
+    update([&] { Router::patch(route, std::move(handler)); });
+  }
+
+  void head(std::string route, Handler handler) {
+    update([&] { Router::head(route, std::move(handler)); });
+  }
+
+  void options(std::string route, Handler handler) {
+    update([&] { Router::options(route, std::move(handler)); });
+  }
+
+  void patch(std::string route, AsyncHandler handler) {
+    update([&] { Router::patch(route, std::move(handler)); });
+  }
 
-  void get(std::string route, Handler handler) { Router::get(route, std::move(handler)); }
+  void head(std::string route, AsyncHandler handler) {
+    update([&] { Router::head(route, std::move(handler)); });
+  }
 
-  void post(std::string route, Handler handler) { Router::post(route, std::move(handler)); }
+  void options(std::string route, AsyncHandler handler) {
+    update([&] { Router::options(route, std::move(handler)); });
+  }
 
-  void put(std::string route, Handler handler) { Router::put(route, std::move(handler)); }
+  void get(std::string route, Middleware middleware, Handler handler) {
+    update([&] { Router::get(route, std::move(middleware), std::move(handler)); });
+  }
 
-  void del(std::string route, Handler handler) { Router::del(route, std::move(handler)); }
+  void get(std::string route, Middleware middleware, AsyncHandler handler) {
+    update([&] { Router::get(route, std::move(middleware), std::move(handler)); });
+  }
+
+  void post(std::string route, BodyOptions body, Handler handler) {
+    update([&] { Router::post(route, body, std::move(handler)); });
+  }
+
+  void post(std::string route, BodyOptions body, AsyncHandler handler) {
+    update([&] { Router::post(route, body, std::move(handler)); });
+  }
+
+  void put(std::string route, BodyOptions body, Handler handler) {
+    update([&] { Router::put(route, body, std::move(handler)); });
+  }
+
+  void put(std::string route, BodyOptions body, AsyncHandler handler) {
+    update([&] { Router::put(route, body, std::move(handler)); });
+  }
+
+  void use(std::string prefix, std::shared_ptr<const RouteTable> table) {
+    update([&] { Router::use(std::move(prefix), std::move(table)); });
+  }
+
+  void use(std::string path, Middleware middleware) {
+    update([&] { Router::use(std::move(path), std::move(middleware)); });
+  }
+
+  void use(std::string path, AsyncMiddleware middleware) {
+    update([&] { Router::use(std::move(path), std::move(middleware)); });
+  }
+
+  bool remove_route(std::string_view method, std::string_view route) {
+    bool removed = false;
+    update([&] { removed = Router::remove_route(method, route); });
+    return removed;
+  }
+
+  bool remove_middleware(std::string path) {
+    bool removed = false;
+    update([&] { removed = Router::remove_middleware(std::move(path)); });
+    return removed;
+  }
 
 private:
-  std::unique_ptr<Server> server_;
+  std::unique_ptr<WorkerPool> worker_pool_;
+  std::vector<std::unique_ptr<Server>> servers_;
+  std::atomic<bool> is_running_{false};
+
+  /** Serializes changes to the routes, which may come from any thread once listening */
+  std::mutex routes_mutex_;
+  /** Slot the servers dispatch from, set by listen() */
+  std::shared_ptr<RouterSlot> router_slot_;
+
+  /**
+   * Applies a change to the routes, then publishes a freshly compiled table if the servers are
+   * already running. Requests in flight finish on the table they started with.
+   */
+  template <typename F> void update(F &&change) {
+    std::lock_guard<std::mutex> lock(routes_mutex_);
+    change();
+    if (router_slot_) {
+      router_slot_->publish(compile());
+    }
+  }
+
   void block_while_running() {
-    while (server_->is_running) {
+    while (is_running_) {
       struct timeval tv;
       tv.tv_sec = 0;
       tv.tv_usec = constants::DEFAULT_SELECT_TIMEOUT_US;
@@ -58,13 +212,21 @@ Express Express::express() {
 
 // Method implementations
 void Express::listen(int port, Callback callback) {
-  pImpl->listen(port, std::move(callback));
+  pImpl->listen(port, ListenOptions(), std::move(callback));
+}
+
+void Express::listen(int port, ListenOptions options, Callback callback) {
+  pImpl->listen(port, options, std::move(callback));
 }
 
 void Express::shutdown() {
   pImpl->shutdown();
 }
 
+std::vector<ShardStats> Express::stats() {
+  return pImpl->stats();
+}
+
 void Express::get(std::string route, Handler handler) {
   pImpl->get(route, std::move(handler));
 }
@@ -81,4 +243,96 @@ void Express::del(std::string route, Handler handler) {
   pImpl->del(route, std::move(handler));
 }
 
+void Express::get(std::string route, AsyncHandler handler) {
+  pImpl->get(route, std::move(handler));
+}
+
+void Express::post(std::string route, AsyncHandler handler) {
+  pImpl->post(route, std::move(handler));
+}
+
+void Express::put(std::string route, AsyncHandler handler) {
+  pImpl->put(route, std::move(handler));
+}
+
+void Express::del(std::string route, AsyncHandler handler) {
+  pImpl->del(route, std::move(handler));
+}
+
+void Express::patch(std::string route, Handler handler) {
+  pImpl->patch(route, std::move(handler));
+}
+
+void Express::head(std::string route, Handler handler) {
+  pImpl->head(route, std::move(handler));
+}
+
+void Express::options(std::string route, Handler handler) {
+  pImpl->options(route, std::move(handler));
+}
+
+void Express::patch(std::string route, AsyncHandler handler) {
+  pImpl->patch(route, std::move(handler));
+}
+
+void Express::head(std::string route, AsyncHandler handler) {
+  pImpl->head(route, std::move(handler));
+}
+
+void Express::options(std::string route, AsyncHandler handler) {
+  pImpl->options(route, std::move(handler));
+}
+
+void Express::get(std::string route, Middleware middleware, Handler handler) {
+  pImpl->get(route, std::move(middleware), std::move(handler));
+}
+
+void Express::get(std::string route, Middleware middleware, AsyncHandler handler) {
+  pImpl->get(route, std::move(middleware), std::move(handler));
+}
+
+void Express::post(std::string route, BodyOptions body, Handler handler) {
+  pImpl->post(route, body, std::move(handler));
+}
+
+void Express::post(std::string route, BodyOptions body, AsyncHandler handler) {
+  pImpl->post(route, body, std::move(handler));
+}
+
+void Express::put(std::string route, BodyOptions body, Handler handler) {
+  pImpl->put(route, body, std::move(handler));
+}
+
+void Express::put(std::string route, BodyOptions body, AsyncHandler handler) {
+  pImpl->put(route, body, std::move(handler));
+}
+
+bool Express::remove_route(std::string method, std::string route) {
+  return pImpl->remove_route(method, route);
+}
+
+bool Express::remove_middleware(std::string path) {
+  return pImpl->remove_middleware(std::move(path));
+}
+
+void Express::use(std::string prefix, std::shared_ptr<const RouteTable> table) {
+  pImpl->use(std::move(prefix), std::move(table));
+}
+
+void Express::use(Middleware middleware) {
+  pImpl->use("", std::move(middleware));
+}
+
+void Express::use(std::string path, Middleware middleware) {
+  pImpl->use(std::move(path), std::move(middleware));
+}
+
+void Express::use(AsyncMiddleware middleware) {
+  pImpl->use("", std::move(middleware));
+}
+
+void Express::use(std::string path, AsyncMiddleware middleware) {
+  pImpl->use(std::move(path), std::move(middleware));
+}
+
 } // namespace express
\ No newline at end of file
@@ -0,0 +1,305 @@
+#ifndef EXPRESS_ROUTE_TREE_H
+#define EXPRESS_ROUTE_TREE_H
+
+#include <express/request.h>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace express {
+/**
+ * @brief Compressed prefix tree mapping route patterns to values.
+ *
+ * Patterns are made of static text, `:name` segments capturing one path segment, and an
+ * optional trailing `*name` (or bare `*`) capturing the rest of the path. Static children are
+ * indexed by their first byte, so lookup cost grows with the path length and not with the
+ * number of routes. Static text is preferred over a capture, and a capture over a wildcard.
+ *
+ * Nodes live in one contiguous vector and refer to each other by index, so the tree copies
+ * like a plain value.
+ *
+ * @tparam T Type of the value stored for each route.
+ */
+template <typename T> class RouteTree {
+public:
+  using Params = decltype(Request::params);
+
+  RouteTree() : nodes_(1) {}
+
+  /**
+   * Finds the value for a pattern, inserting an empty one if the pattern is new.
+   * @param pattern Route pattern, e.g. `/users/:id/posts/:post`.
+   * @returns Value stored for the pattern.
+   * @throws std::invalid_argument if a capture has no name or a wildcard is not last.
+   */
+  T &insert(std::string_view pattern) {
+    pattern = normalize(pattern);
+    size_t node = ROOT_;
+    while (!pattern.empty()) {
+      // Static text stops right after a '/' followed by a capture, so these start a segment
+      if (pattern.front() == ':') {
+        size_t end = pattern.find('/');
+        std::string_view name = pattern.substr(1, end == std::string_view::npos ? end : end - 1);
+        if (name.empty())
+          throw std::invalid_argument("Route parameter has no name");
+        node = capture_child(node, name);
+        pattern.remove_prefix(name.size() + 1);
+      } else if (pattern.front() == '*') {
+        std::string_view name = pattern.substr(1);
+        if (name.find('/') != std::string_view::npos)
+          throw std::invalid_argument("Route wildcard must be the last segment");
+        node = wildcard_child(node, name.empty() ? "*" : name);
+        pattern = {};
+      } else {
+        size_t end = static_end(pattern);
+        node = static_child(node, pattern.substr(0, end));
+        pattern.remove_prefix(end);
+      }
+    }
+    if (!nodes_[node].value)
+      nodes_[node].value.emplace();
+    return *nodes_[node].value;
+  }
+
+  /**
+   * Removes the value stored for a pattern. Its nodes stay in place and are skipped by lookups.
+   * @param pattern Route pattern, written as when it was inserted.
+   * @returns True if the pattern had a value.
+   */
+  bool erase(std::string_view pattern) {
+    size_t node = locate(normalize(pattern));
+    if (node == NONE_ || !nodes_[node].value)
+      return false;
+    nodes_[node].value.reset();
+    return true;
+  }
+
+  /**
+   * Looks up the value for a request path.
+   * @param path Request path, without the query string.
+   * @param params Receives the captures of the matched route, as views into `path` and into
+   * this tree.
+   * @returns The matched value, or nullptr if no route matches.
+   */
+  const T *find(std::string_view path, Params &params) const {
+    return match(ROOT_, normalize(path), params);
+  }
+
+  /**
+   * Visits every stored value with its pattern, e.g. to copy the routes into another tree.
+   * @param visit Called with (const std::string &pattern, const T &value).
+   */
+  template <typename F> void for_each(F &&visit) const {
+    std::string pattern;
+    visit_from(ROOT_, pattern, visit);
+  }
+
+private:
+  static constexpr size_t ROOT_ = 0;
+  static constexpr size_t NONE_ = static_cast<size_t>(-1);
+
+  struct Node {
+    /** Static text of the edge leading here, or the capture name for capture nodes */
+    std::string label;
+    /** First byte of each static child, parallel to `children` */
+    std::string indices;
+    std::vector<size_t> children;
+    std::vector<size_t> captures;
+    size_t wildcard = NONE_;
+    std::optional<T> value;
+  };
+
+  std::vector<Node> nodes_;
+
+  /**
+   * Drops one trailing slash, so `/users/` routes like `/users`.
+   * @private
+   */
+  static std::string_view normalize(std::string_view path) {
+    if (path.size() > 1 && path.back() == '/')
+      path.remove_suffix(1);
+    return path;
+  }
+
+  /**
+   * @returns Length of the static text at the front of a pattern remainder.
+   * @private
+   */
+  static size_t static_end(std::string_view pattern) {
+    for (size_t i = 0; i + 1 < pattern.size(); i++) {
+      if (pattern[i] == '/' && (pattern[i + 1] == ':' || pattern[i + 1] == '*'))
+        return i + 1;
+    }
+    return pattern.size();
+  }
+
+  size_t add_node(std::string_view label) {
+    nodes_.push_back(Node{std::string(label), {}, {}, {}, NONE_, std::nullopt});
+    return nodes_.size() - 1;
+  }
+
+  /**
+   * Walks or extends the static edges below a node, splitting an edge where the text diverges.
+   * @returns Node reached once all of `text` is consumed.
+   * @private
+   */
+  size_t static_child(size_t node, std::string_view text) {
+    while (!text.empty()) {
+      size_t index = nodes_[node].indices.find(text.front());
+      if (index == std::string::npos) {
+        size_t child = add_node(text);
+        nodes_[node].indices.push_back(text.front());
+        nodes_[node].children.push_back(child);
+        return child;
+      }
+
+      size_t child = nodes_[node].children[index];
+      const std::string &label = nodes_[child].label;
+      size_t common = 0;
+      while (common < label.size() && common < text.size() && label[common] == text[common])
+        common++;
+
+      if (common < label.size()) {
+        // Split the edge: a new node takes the shared prefix and adopts the old child
+        size_t middle = add_node(std::string_view(nodes_[child].label).substr(0, common));
+        nodes_[child].label.erase(0, common);
+        nodes_[middle].indices.push_back(nodes_[child].label.front());
+        nodes_[middle].children.push_back(child);
+        nodes_[node].children[index] = middle;
+        child = middle;
+      }
+      node = child;
+      text.remove_prefix(common);
+    }
+    return node;
+  }
+
+  size_t capture_child(size_t node, std::string_view name) {
+    for (size_t capture : nodes_[node].captures) {
+      if (nodes_[capture].label == name)
+        return capture;
+    }
+    size_t capture = add_node(name);
+    nodes_[node].captures.push_back(capture);
+    return capture;
+  }
+
+  size_t wildcard_child(size_t node, std::string_view name) {
+    size_t wildcard = nodes_[node].wildcard;
+    if (wildcard == NONE_) {
+      wildcard = add_node(name);
+      nodes_[node].wildcard = wildcard;
+    } else if (nodes_[wildcard].label != name) {
+      throw std::invalid_argument("Route wildcard conflicts with an existing wildcard name");
+    }
+    return wildcard;
+  }
+
+  /**
+   * Walks the nodes a pattern was inserted along, without adding any.
+   * @returns Node the pattern ends at, or NONE_ if the tree has no such node.
+   * @private
+   */
+  size_t locate(std::string_view pattern) const {
+    size_t node = ROOT_;
+    while (!pattern.empty() && node != NONE_) {
+      if (pattern.front() == ':') {
+        size_t end = pattern.find('/');
+        std::string_view name = pattern.substr(1, end == std::string_view::npos ? end : end - 1);
+        size_t found = NONE_;
+        for (size_t capture : nodes_[node].captures) {
+          if (nodes_[capture].label == name)
+            found = capture;
+        }
+        node = found;
+        pattern.remove_prefix(name.size() + 1);
+      } else if (pattern.front() == '*') {
+        std::string_view name = pattern.size() > 1 ? pattern.substr(1) : "*";
+        size_t wildcard = nodes_[node].wildcard;
+        node = wildcard != NONE_ && nodes_[wildcard].label == name ? wildcard : NONE_;
+        pattern = {};
+      } else {
+        std::string_view text = pattern.substr(0, static_end(pattern));
+        pattern.remove_prefix(text.size());
+        while (!text.empty() && node != NONE_) {
+          size_t index = nodes_[node].indices.find(text.front());
+          size_t child = index == std::string::npos ? NONE_ : nodes_[node].children[index];
+          if (child == NONE_ || !text.starts_with(nodes_[child].label))
+            return NONE_;
+          text.remove_prefix(nodes_[child].label.size());
+          node = child;
+        }
+      }
+    }
+    return node;
+  }
+
+  template <typename F> void visit_from(size_t node_index, std::string &pattern, F &visit) const {
+    const Node &node = nodes_[node_index];
+    if (node.value)
+      visit(pattern, *node.value);
+    size_t length = pattern.size();
+    for (size_t child : node.children) {
+      pattern += nodes_[child].label;
+      visit_from(child, pattern, visit);
+      pattern.resize(length);
+    }
+    for (size_t capture : node.captures) {
+      pattern += ':' + nodes_[capture].label;
+      visit_from(capture, pattern, visit);
+      pattern.resize(length);
+    }
+    if (node.wildcard != NONE_) {
+      std::string_view name = nodes_[node.wildcard].label;
+      pattern += '*';
+      pattern += name == "*" ? "" : name;
+      visit_from(node.wildcard, pattern, visit);
+      pattern.resize(length);
+    }
+  }
+
+  /**
+   * Matches the rest of a path below a node, backtracking from static text to captures to the
+   * wildcard. Captures are only recorded on the way back from a successful match.
+   * @private
+   */
+  const T *match(size_t node_index, std::string_view path, Params &params) const {
+    const Node &node = nodes_[node_index];
+    if (path.empty() && node.value)
+      return &*node.value;
+
+    if (!path.empty()) {
+      size_t index = node.indices.find(path.front());
+      if (index != std::string::npos) {
+        const Node &child = nodes_[node.children[index]];
+        if (path.starts_with(child.label)) {
+          const T *found = match(node.children[index], path.substr(child.label.size()), params);
+          if (found)
+            return found;
+        }
+      }
+
+      std::string_view segment = path.substr(0, path.find('/'));
+      if (!segment.empty()) {
+        for (size_t capture : node.captures) {
+          const T *found = match(capture, path.substr(segment.size()), params);
+          if (found) {
+            params[nodes_[capture].label] = segment;
+            return found;
+          }
+        }
+      }
+    }
+
+    if (node.wildcard != NONE_ && nodes_[node.wildcard].value) {
+      params[nodes_[node.wildcard].label] = path;
+      return &*nodes_[node.wildcard].value;
+    }
+    return nullptr;
+  }
+};
+} // namespace express
+
+#endif
@@ -1,40 +1,221 @@
 #include "router.h"
+#include <stdexcept>
 
 express::Router::Router() = default;
 
-void express::Router::register_handler(HttpVerb::Value verb, Handler new_handler) {
-  std::vector<Handler> &verb_handlers = handlers_[verb];
-  verb_handlers.push_back(new_handler);
+void express::Router::register_handler(HttpVerb::Value verb, std::string_view route,
+                                       RouteHandler new_handler) {
+  Route &entry = routes(verb).insert(route);
+  entry.handlers.push_back(std::move(new_handler));
+  entry.mounts.emplace_back();
+}
+
+void express::Router::register_body(HttpVerb::Value verb, std::string_view route,
+                                    BodyOptions body) {
+  routes(verb).insert(route).body = body;
 }
 
 void express::Router::get(std::string route, Handler handler) {
-  register_handler(HttpVerb::Value::GET, std::move(handler));
+  register_handler(HttpVerb::Value::GET, route, std::move(handler));
 }
 
 void express::Router::post(std::string route, Handler handler) {
-  register_handler(HttpVerb::Value::POST, std::move(handler));
+  register_handler(HttpVerb::Value::POST, route, std::move(handler));
 }
 
 void express::Router::put(std::string route, Handler handler) {
-  register_handler(HttpVerb::Value::PUT, std::move(handler));
+  register_handler(HttpVerb::Value::PUT, route, std::move(handler));
 }
 
 void express::Router::del(std::string route, Handler handler) {
-  register_handler(HttpVerb::Value::DELETE, std::move(handler));
+  register_handler(HttpVerb::Value::DELETE, route, std::move(handler));
+}
+
+void express::Router::get(std::string route, AsyncHandler handler) {
+  register_handler(HttpVerb::Value::GET, route, std::move(handler));
+}
+
+void express::Router::post(std::string route, AsyncHandler handler) {
+  register_handler(HttpVerb::Value::POST, route, std::move(handler));
+}
+
+void express::Router::put(std::string route, AsyncHandler handler) {
+  register_handler(HttpVerb::Value::PUT, route, std::move(handler));
+}
+
+void express::Router::del(std::string route, AsyncHandler handler) {
+  register_handler(HttpVerb::Value::DELETE, route, std::move(handler));
+}
+
+void express::Router::get(std::string route, Middleware middleware, Handler handler) {
+  register_handler(HttpVerb::Value::GET, route, std::move(middleware));
+  register_handler(HttpVerb::Value::GET, route, std::move(handler));
+}
+
+void express::Router::get(std::string route, Middleware middleware, AsyncHandler handler) {
+  register_handler(HttpVerb::Value::GET, route, std::move(middleware));
+  register_handler(HttpVerb::Value::GET, route, std::move(handler));
+}
+
+void express::Router::post(std::string route, BodyOptions body, Handler handler) {
+  if (body.stream)
+    throw std::invalid_argument("Only coroutine handlers can read a streamed body");
+  register_body(HttpVerb::Value::POST, route, body);
+  register_handler(HttpVerb::Value::POST, route, std::move(handler));
+}
+
+void express::Router::post(std::string route, BodyOptions body, AsyncHandler handler) {
+  register_body(HttpVerb::Value::POST, route, body);
+  register_handler(HttpVerb::Value::POST, route, std::move(handler));
+}
+
+void express::Router::put(std::string route, BodyOptions body, Handler handler) {
+  if (body.stream)
+    throw std::invalid_argument("Only coroutine handlers can read a streamed body");
+  register_body(HttpVerb::Value::PUT, route, body);
+  register_handler(HttpVerb::Value::PUT, route, std::move(handler));
+}
+
+void express::Router::put(std::string route, BodyOptions body, AsyncHandler handler) {
+  register_body(HttpVerb::Value::PUT, route, body);
+  register_handler(HttpVerb::Value::PUT, route, std::move(handler));
+}
+
+void express::Router::head(std::string route, Handler handler) {
+  register_handler(HttpVerb::Value::HEAD, route, std::move(handler));
+}
+
+void express::Router::options(std::string route, Handler handler) {
+  register_handler(HttpVerb::Value::OPTIONS, route, std::move(handler));
+}
+
+void express::Router::patch(std::string route, Handler handler) {
+  register_handler(HttpVerb::Value::PATCH, route, std::move(handler));
+}
+
+void express::Router::head(std::string route, AsyncHandler handler) {
+  register_handler(HttpVerb::Value::HEAD, route, std::move(handler));
+}
+
+void express::Router::options(std::string route, AsyncHandler handler) {
+  register_handler(HttpVerb::Value::OPTIONS, route, std::move(handler));
+}
+
+void express::Router::patch(std::string route, AsyncHandler handler) {
+  register_handler(HttpVerb::Value::PATCH, route, std::move(handler));
+}
+
+bool express::Router::remove_route(std::string_view method, std::string_view route) {
+  return routes(HttpVerb::toEnum(method)).erase(route);
+}
+
+bool express::Router::remove_middleware(std::string path) {
+  path = normalize_prefix(std::move(path));
+  size_t removed = std::erase_if(middleware_, [&path](const MiddlewareEntry &entry) {
+    return entry.path == path;
+  });
+  return removed > 0;
 }
 
 void express::Router::use(std::string subroute, Router router) {
-  subrouters_[subroute] = router;
-}
-
-void express::Router::run(Request &request, Response &response) {
-  HttpVerb::Value http_verb = HttpVerb::toEnum(request.method);
-  if (request.path == "/") {
-    std::vector<Handler> &handlers = handlers_[http_verb];
-    for (Handler &handler : handlers) {
-      handler(request, response);
-    }
-  } else {
-    // TODO: Recursive matching
+  std::string prefix = normalize_prefix(std::move(subroute));
+  if (prefix.find('*') != std::string::npos)
+    throw std::invalid_argument("Router mount path cannot contain a wildcard");
+
+  // Flatten the mounted router into this one, so routing never walks nested routers
+  for (MiddlewareEntry &entry : router.middleware_) {
+    middleware_.push_back(MiddlewareEntry{prefix + entry.path, std::move(entry.middleware)});
+  }
+  for (MountedTable &mounted : router.tables_) {
+    tables_.push_back(MountedTable{prefix + mounted.prefix, std::move(mounted.table)});
+  }
+  for (size_t verb = 0; verb < HttpVerb::COUNT; verb++) {
+    RouteTree<Route> &target_tree = routes_[verb];
+    auto merge = [&prefix, &target_tree](const std::string &pattern, const Route &route) {
+      Route &target = target_tree.insert(prefix + pattern);
+      if (route.body)
+        target.body = route.body;
+      target.handlers.insert(target.handlers.end(), route.handlers.begin(), route.handlers.end());
+      for (const std::string &mount : route.mounts) {
+        target.mounts.push_back(prefix + mount);
+      }
+    };
+    router.routes_[verb].for_each(merge);
+  }
+}
+
+void express::Router::use(std::string prefix, std::shared_ptr<const RouteTable> table) {
+  tables_.push_back(MountedTable{normalize_prefix(std::move(prefix)), std::move(table)});
+}
+
+void express::Router::use(Middleware middleware) {
+  use("", std::move(middleware));
+}
+
+void express::Router::use(std::string path, Middleware middleware) {
+  register_middleware(std::move(path), std::move(middleware));
+}
+
+void express::Router::use(AsyncMiddleware middleware) {
+  use("", std::move(middleware));
+}
+
+void express::Router::use(std::string path, AsyncMiddleware middleware) {
+  register_middleware(std::move(path), std::move(middleware));
+}
+
+void express::Router::register_middleware(std::string path, MiddlewareHandler middleware) {
+  middleware_.push_back(MiddlewareEntry{normalize_prefix(std::move(path)), std::move(middleware)});
+}
+
+std::string express::Router::normalize_prefix(std::string prefix) {
+  if (!prefix.empty() && prefix.front() != '/')
+    prefix.insert(prefix.begin(), '/');
+  if (!prefix.empty() && prefix.back() == '/')
+    prefix.pop_back();
+  return prefix;
+}
+
+std::shared_ptr<const express::CompiledRouter> express::Router::compile() const {
+  std::shared_ptr<CompiledRouter> compiled(new CompiledRouter());
+
+  size_t handler_count = 0;
+  for (const RouteTree<Route> &tree : routes_) {
+    tree.for_each([&handler_count](const std::string &, const Route &route) {
+      handler_count += route.handlers.size();
+    });
+  }
+  compiled->handlers_.reserve(handler_count);
+  compiled->handler_mounts_.reserve(handler_count);
+
+  // Each route's handlers are laid out next to each other, so running a route walks one run of
+  // the array
+  for (size_t verb = 0; verb < HttpVerb::COUNT; verb++) {
+    RouteTree<CompiledRouter::Route> &target_tree = compiled->routes_[verb];
+    auto add = [&compiled, &target_tree](const std::string &pattern, const Route &route) {
+      CompiledRouter::Route &target = target_tree.insert(pattern);
+      target.first = static_cast<uint32_t>(compiled->handlers_.size());
+      target.count = static_cast<uint32_t>(route.handlers.size());
+      if (route.body) {
+        compiled->body_options_.push_back(*route.body);
+        target.body = static_cast<uint32_t>(compiled->body_options_.size());
+      }
+      compiled->handlers_.insert(compiled->handlers_.end(), route.handlers.begin(),
+                                 route.handlers.end());
+      for (const std::string &mount : route.mounts) {
+        compiled->handler_mounts_.push_back(compiled->intern(mount));
+      }
+    };
+    routes_[verb].for_each(add);
   }
-}
\ No newline at end of file
+
+  compiled->tables_.reserve(tables_.size());
+  for (const MountedTable &mounted : tables_) {
+    compiled->tables_.push_back({compiled->intern(mounted.prefix), mounted.table});
+  }
+  compiled->middleware_.reserve(middleware_.size());
+  for (const MiddlewareEntry &entry : middleware_) {
+    compiled->middleware_.push_back({compiled->intern(entry.path), entry.middleware});
+  }
+  return compiled;
+}
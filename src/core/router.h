@@ -1,36 +1,169 @@
 #ifndef EXPRESS_ROUTER_H
 #define EXPRESS_ROUTER_H
 
+#include "core/compiled_router.h"
+#include "core/route_tree.h"
 #include "http/http_verb.h"
+#include <express/body_options.h>
 #include <express/request.h>
 #include <express/response.h>
 #include <express/types.h>
+#include <array>
+#include <concepts>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <optional>
 #include <string>
+#include <variant>
 #include <vector>
 
 namespace express {
 class Router {
 public:
   Router();
-  // Execute incoming request
-  void run(Request &request, Response &response);
+  // Builds the immutable table requests are dispatched with, copying every handler once. The
+  // table is shared by all server threads; later registrations on the router are not seen.
+  std::shared_ptr<const CompiledRouter> compile() const;
 
-  // Handler registration functions
+  // Handler registration functions. Routes are matched segment by segment: `:name` captures one
+  // segment into Request::params, and a trailing `*name` (or `*`) captures the rest of the path.
   void del(std::string route, Handler handler);
   void get(std::string route, Handler handler);
   void post(std::string route, Handler handler);
   void put(std::string route, Handler handler);
+  void patch(std::string route, Handler handler);
+  // HEAD requests fall back to the GET route, and OPTIONS requests are answered with the
+  // methods the path has routes for, unless a route is registered for them
+  void head(std::string route, Handler handler);
+  void options(std::string route, Handler handler);
 
-  // Sub-router registration
+  // Coroutine handler registration functions
+  void del(std::string route, AsyncHandler handler);
+  void get(std::string route, AsyncHandler handler);
+  void post(std::string route, AsyncHandler handler);
+  void put(std::string route, AsyncHandler handler);
+  void patch(std::string route, AsyncHandler handler);
+  void head(std::string route, AsyncHandler handler);
+  void options(std::string route, AsyncHandler handler);
+
+  // Coroutine lambdas convert to both handler types, so pick AsyncHandler explicitly
+  template <CoroutineHandler F> void del(std::string route, F handler) {
+    del(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void get(std::string route, F handler) {
+    get(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void post(std::string route, F handler) {
+    post(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void put(std::string route, F handler) {
+    put(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void patch(std::string route, F handler) {
+    patch(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void head(std::string route, F handler) {
+    head(std::move(route), AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void options(std::string route, F handler) {
+    options(std::move(route), AsyncHandler(std::move(handler)));
+  }
+
+  // GET routes behind route middleware, e.g. express::cache, which runs right before the handler
+  // and can answer the request itself by not calling next()
+  void get(std::string route, Middleware middleware, Handler handler);
+  void get(std::string route, Middleware middleware, AsyncHandler handler);
+  template <CoroutineHandler F> void get(std::string route, Middleware middleware, F handler) {
+    get(std::move(route), std::move(middleware), AsyncHandler(std::move(handler)));
+  }
+
+  // POST and PUT routes receiving bodies their own way, e.g. larger than the default limit, or
+  // streamed to a coroutine handler through Request::body_chunk(). Streaming to a synchronous
+  // handler throws std::invalid_argument.
+  void post(std::string route, BodyOptions body, Handler handler);
+  void post(std::string route, BodyOptions body, AsyncHandler handler);
+  void put(std::string route, BodyOptions body, Handler handler);
+  void put(std::string route, BodyOptions body, AsyncHandler handler);
+  template <CoroutineHandler F> void post(std::string route, BodyOptions body, F handler) {
+    post(std::move(route), body, AsyncHandler(std::move(handler)));
+  }
+  template <CoroutineHandler F> void put(std::string route, BodyOptions body, F handler) {
+    put(std::move(route), body, AsyncHandler(std::move(handler)));
+  }
+
+  // Removes the handlers of a route, or the middleware registered at a path, e.g. to turn off a
+  // feature-flagged route. Patterns and paths are written as when they were registered.
+  // Returns whether anything was removed; remove_route throws on an unknown method.
+  bool remove_route(std::string_view method, std::string_view route);
+  bool remove_middleware(std::string path);
+
+  // Sub-router registration. The router's middleware, route tables and routes are copied into
+  // this one under the mount path, so dispatch stays a single lookup however deeply routers nest.
+  // Changes made to the router after mounting it are not seen.
   void use(std::string subroute, Router router);
 
+  // Mounts a route table, e.g. one built at compile time by express::routes. Mounted tables are
+  // consulted in mount order, before the routes registered on this router, and their routes
+  // answer HEAD and OPTIONS requests like the router's own.
+  void use(std::string prefix, std::shared_ptr<const RouteTable> table);
+  template <typename T>
+    requires std::derived_from<T, RouteTable>
+  void use(std::string prefix, T table) {
+    std::shared_ptr<const RouteTable> shared = std::make_shared<const T>(std::move(table));
+    use(std::move(prefix), std::move(shared));
+  }
+
+  // Middleware registration, optionally scoped to requests under a path. Middleware runs in
+  // registration order before routing, and the chain stops at the first middleware that does
+  // not call next() or that sends the response headers.
+  void use(Middleware middleware);
+  void use(std::string path, Middleware middleware);
+  void use(AsyncMiddleware middleware);
+  void use(std::string path, AsyncMiddleware middleware);
+
+  // Coroutine lambdas convert to both middleware types, so pick AsyncMiddleware explicitly
+  template <CoroutineMiddleware F> void use(F middleware) {
+    use(AsyncMiddleware(std::move(middleware)));
+  }
+  template <CoroutineMiddleware F> void use(std::string path, F middleware) {
+    use(std::move(path), AsyncMiddleware(std::move(middleware)));
+  }
+
 private:
-  std::map<HttpVerb::Value, std::vector<Handler>> handlers_;
-  void register_handler(HttpVerb::Value verb, Handler new_handler);
-  std::map<std::string, Router> subrouters_;
-  // TODO: Middleware stack
+  using RouteHandler = CompiledRouter::RouteHandler;
+  struct Route {
+    std::vector<RouteHandler> handlers;
+    // Path of the router each handler was registered on, relative to this one
+    std::vector<std::string> mounts;
+    // How the route receives bodies, if not with the defaults
+    std::optional<BodyOptions> body;
+  };
+  // One tree per verb, indexed by HttpVerb::Value
+  std::array<RouteTree<Route>, HttpVerb::COUNT> routes_;
+  RouteTree<Route> &routes(HttpVerb::Value verb) { return routes_[static_cast<size_t>(verb)]; }
+  const RouteTree<Route> &routes(HttpVerb::Value verb) const {
+    return routes_[static_cast<size_t>(verb)];
+  }
+  void register_handler(HttpVerb::Value verb, std::string_view route, RouteHandler new_handler);
+  void register_body(HttpVerb::Value verb, std::string_view route, BodyOptions body);
+
+  struct MountedTable {
+    std::string prefix;
+    std::shared_ptr<const RouteTable> table;
+  };
+  std::vector<MountedTable> tables_;
+
+  // Middleware chain, in registration order
+  using MiddlewareHandler = CompiledRouter::MiddlewareHandler;
+  struct MiddlewareEntry {
+    std::string path;
+    MiddlewareHandler middleware;
+  };
+  std::vector<MiddlewareEntry> middleware_;
+  void register_middleware(std::string path, MiddlewareHandler middleware);
+
+  // Gives a mount or middleware path a leading slash and no trailing one, so "/" becomes ""
+  static std::string normalize_prefix(std::string prefix);
 };
 } // namespace express
 
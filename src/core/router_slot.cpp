@@ -0,0 +1,17 @@
+#include "router_slot.h"
+#include <utility>
+
+express::RouterSlot::RouterSlot(std::shared_ptr<const CompiledRouter> router)
+    : router_(std::move(router)) {
+}
+
+void express::RouterSlot::publish(std::shared_ptr<const CompiledRouter> router) {
+  // Stored before the version moves, so a reader seeing the new version loads the new table
+  std::shared_ptr<const CompiledRouter> replaced = router_.exchange(std::move(router));
+  version_.fetch_add(1, std::memory_order_release);
+  // The replaced table is freed here or by the last server still holding it
+}
+
+std::shared_ptr<const express::CompiledRouter> express::RouterSlot::load() const {
+  return router_.load(std::memory_order_acquire);
+}
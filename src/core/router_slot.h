@@ -0,0 +1,50 @@
+#ifndef EXPRESS_ROUTER_SLOT_H
+#define EXPRESS_ROUTER_SLOT_H
+
+#include "core/compiled_router.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace express {
+/**
+ * @brief Publishes the dispatch table servers route with, so it can be replaced while they run.
+ *
+ * A new table is compiled on the side and published whole, without a lock. Each server pins the
+ * current table and compares the version counter once per event loop iteration, picking up a
+ * new table between events. The server keeps a replaced table until every request still using
+ * it finished, then frees it.
+ */
+class RouterSlot {
+public:
+  explicit RouterSlot(std::shared_ptr<const CompiledRouter> router);
+
+  /**
+   * Replaces the current table. Requests already running keep the table they started with.
+   */
+  void publish(std::shared_ptr<const CompiledRouter> router);
+
+  /**
+   * @returns Number of tables published so far, changing whenever the table is replaced.
+   */
+  uint64_t version() const noexcept { return version_.load(std::memory_order_acquire); }
+
+  /**
+   * @returns The current table, at least as recent as the last version() read.
+   */
+  std::shared_ptr<const CompiledRouter> load() const;
+
+  // Rule of 5
+  ~RouterSlot() = default;
+  RouterSlot(const RouterSlot &) = delete;
+  RouterSlot &operator=(const RouterSlot &) = delete;
+  RouterSlot(RouterSlot &&) = delete;
+  RouterSlot &operator=(RouterSlot &&) = delete;
+
+private:
+  std::atomic<std::shared_ptr<const CompiledRouter>> router_;
+  std::atomic<uint64_t> version_{0};
+};
+} // namespace express
+
+#endif
@@ -0,0 +1,81 @@
+#include "body_stream.h"
+#include "http/http_status.h"
+#include <express/request.h>
+#include <utility>
+
+express::BodyStream::BodyStream(std::function<void()> on_drained)
+    : on_drained_(std::move(on_drained)) {
+}
+
+size_t express::BodyStream::room() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (abandoned_)
+    return MAX_PENDING_; // Dropped as it arrives
+  if (pending_.size() < MAX_PENDING_)
+    return MAX_PENDING_ - pending_.size();
+  stalled_ = true;
+  return 0;
+}
+
+std::coroutine_handle<> express::BodyStream::append(std::string_view bytes) {
+  if (bytes.empty())
+    return nullptr;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (abandoned_)
+    return nullptr;
+  pending_.insert(pending_.end(), bytes.begin(), bytes.end());
+  return release_waiter();
+}
+
+std::coroutine_handle<> express::BodyStream::finish() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  finished_ = true;
+  return release_waiter();
+}
+
+std::coroutine_handle<> express::BodyStream::fail(int status) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  error_status_ = status;
+  return release_waiter();
+}
+
+bool express::BodyStream::wait(std::coroutine_handle<> handler) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!pending_.empty() || finished_ || error_status_ != 0)
+    return false;
+  waiter_ = handler;
+  return true;
+}
+
+std::string_view express::BodyStream::take() {
+  bool drained;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_status_ != 0)
+      throw BodyError(error_status_, HttpStatus::get_message(error_status_));
+    taken_.swap(pending_);
+    pending_.clear();
+    drained = std::exchange(stalled_, false);
+  }
+  if (drained) {
+    on_drained_(); // Outside the lock, as the server may append straight away
+  }
+  return std::string_view(taken_.data(), taken_.size());
+}
+
+void express::BodyStream::abandon() {
+  bool drained;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    abandoned_ = true;
+    pending_.clear();
+    drained = std::exchange(stalled_, false);
+  }
+  if (drained) {
+    on_drained_();
+  }
+}
+
+std::coroutine_handle<> express::BodyStream::release_waiter() {
+  return std::exchange(waiter_, nullptr);
+}
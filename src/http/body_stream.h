@@ -0,0 +1,115 @@
+#ifndef EXPRESS_BODY_STREAM_H
+#define EXPRESS_BODY_STREAM_H
+
+#include "utils/constants.h"
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace express {
+/**
+ * @brief Body of a streamed request, handed from the I/O thread to the handler as it arrives.
+ *
+ * The server appends each decoded piece of the body, and the handler takes everything appended
+ * since its last call in one chunk. At most MAX_PENDING_ bytes wait for the handler: past that
+ * the server stops appending, and so stops reading from the client, until the handler caught
+ * up. The two sides may run on different threads.
+ */
+class BodyStream {
+public:
+  /** Bytes buffered ahead of the handler before the server stops reading (64KB) */
+  static constexpr size_t MAX_PENDING_ = 64 * constants::KB_;
+
+  /**
+   * @param on_drained Called once the handler took the pending bytes after the server stopped
+   * at MAX_PENDING_, from the handler's thread, so the server resumes reading.
+   */
+  explicit BodyStream(std::function<void()> on_drained);
+
+  /**
+   * @returns How many more bytes of the body the handler has room for. Once there is none, the
+   * server is told through on_drained when there is again.
+   */
+  size_t room();
+
+  /**
+   * Appends the next piece of the body, or drops it if the handler is gone.
+   * @returns The handler to resume, if it was waiting for the body.
+   */
+  std::coroutine_handle<> append(std::string_view bytes);
+
+  /**
+   * Marks the body as complete.
+   * @returns The handler to resume, if it was waiting for the body.
+   */
+  std::coroutine_handle<> finish();
+
+  /**
+   * Ends the body early; the handler's next take() throws BodyError with the given status.
+   * @returns The handler to resume, if it was waiting for the body.
+   */
+  std::coroutine_handle<> fail(int status);
+
+  /**
+   * Registers the handler to resume once there is something to take.
+   * @returns False, without registering, if there already is.
+   */
+  bool wait(std::coroutine_handle<> handler);
+
+  /**
+   * Takes every byte appended since the last call.
+   * @returns The bytes, valid until the next call, or an empty view once the body is complete.
+   * @throws BodyError if the body ended early.
+   */
+  std::string_view take();
+
+  /**
+   * Marks the handler as gone, e.g. once it answered without reading the whole body. The rest
+   * of the body is dropped as it arrives.
+   */
+  void abandon();
+
+  // Rule of 5
+  ~BodyStream() = default;
+  BodyStream(const BodyStream &) = delete;
+  BodyStream &operator=(const BodyStream &) = delete;
+  BodyStream(BodyStream &&) = delete;
+  BodyStream &operator=(BodyStream &&) = delete;
+
+private:
+  std::mutex mutex_;
+
+  /** Bytes appended since the handler last took some */
+  std::vector<char> pending_;
+
+  /** Bytes the handler took last, which its chunk views; swapped with pending_ to reuse both */
+  std::vector<char> taken_;
+
+  /** Handler suspended until there is something to take */
+  std::coroutine_handle<> waiter_;
+
+  bool finished_ = false;
+
+  /** Status the body failed with, or 0 */
+  int error_status_ = 0;
+
+  /** Set once room() turned the server away, until the handler takes the pending bytes */
+  bool stalled_ = false;
+
+  /** Set once the handler is gone, so appended bytes are dropped */
+  bool abandoned_ = false;
+
+  std::function<void()> on_drained_;
+
+  /**
+   * Clears the waiting handler, to be resumed by the caller. Requires the mutex.
+   * @private
+   */
+  std::coroutine_handle<> release_waiter();
+};
+} // namespace express
+
+#endif
@@ -0,0 +1,151 @@
+#include "byte_scanner.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define EXPRESS_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace express {
+
+ByteScanner::Isa ByteScanner::isa() {
+  static const Isa best = supports(Isa::AVX2)    ? Isa::AVX2
+                          : supports(Isa::SSE42) ? Isa::SSE42
+                                                 : Isa::SCALAR;
+  return best;
+}
+
+bool ByteScanner::supports(Isa isa) {
+#ifdef EXPRESS_SCANNER_X86
+  __builtin_cpu_init(); // Needed if called from a static initializer
+#endif
+  switch (isa) {
+#ifdef EXPRESS_SCANNER_X86
+    case Isa::AVX2:
+      return __builtin_cpu_supports("avx2");
+    case Isa::SSE42:
+      return __builtin_cpu_supports("sse4.2");
+#endif
+    case Isa::SCALAR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+size_t ByteScanner::find(std::string_view text, std::string_view set, size_t from) {
+  if (from >= text.size() || set.empty())
+    return std::string_view::npos;
+  static const Finder selected = finder(isa());
+  Finder chosen = set.size() > MAX_SET_SIZE ? find_scalar : selected; // Too many for a register
+  return add_offset(from, chosen(text.data() + from, text.data() + text.size(), set));
+}
+
+size_t ByteScanner::find(Isa isa, std::string_view text, std::string_view set, size_t from) {
+  if (from >= text.size() || set.empty())
+    return std::string_view::npos;
+  Finder chosen = set.size() > MAX_SET_SIZE ? find_scalar : finder(isa);
+  return add_offset(from, chosen(text.data() + from, text.data() + text.size(), set));
+}
+
+ByteScanner::Finder ByteScanner::finder(Isa isa) {
+  switch (isa) {
+    case Isa::AVX2:
+      return find_avx2;
+    case Isa::SSE42:
+      return find_sse42;
+    default:
+      return find_scalar;
+  }
+}
+
+size_t ByteScanner::add_offset(size_t offset, size_t found) {
+  return found == std::string_view::npos ? found : offset + found;
+}
+
+size_t ByteScanner::find_scalar(const char *begin, const char *end, std::string_view set) {
+  for (const char *it = begin; it < end; it++) {
+    if (std::memchr(set.data(), *it, set.size()) != nullptr)
+      return it - begin;
+  }
+  return std::string_view::npos;
+}
+
+#ifdef EXPRESS_SCANNER_X86
+
+/**
+ * Whether a vector load of `bytes` at `at` stays within one page, so reading past the end of the
+ * text cannot fault. Bytes past the end are loaded but never reported.
+ */
+static bool within_page(const char *at, size_t bytes) {
+  constexpr uintptr_t PAGE_SIZE = 4096;
+  return (reinterpret_cast<uintptr_t>(at) & (PAGE_SIZE - 1)) <= PAGE_SIZE - bytes;
+}
+
+__attribute__((target("sse4.2"))) size_t ByteScanner::find_sse42(const char *begin,
+                                                                 const char *end,
+                                                                 std::string_view set) {
+  char padded[MAX_SET_SIZE] = {};
+  std::memcpy(padded, set.data(), set.size());
+  __m128i needles = _mm_loadu_si128(reinterpret_cast<const __m128i *>(padded));
+  int needle_count = static_cast<int>(set.size());
+
+  for (const char *it = begin; it < end; it += 16) {
+    size_t remaining = end - it;
+    if (remaining < 16 && !within_page(it, 16))
+      return add_offset(it - begin, find_scalar(it, end, set));
+    // The explicit length keeps bytes past the end out of the comparison
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(it));
+    int length = static_cast<int>(std::min<size_t>(remaining, 16));
+    int index = _mm_cmpestri(needles, needle_count, block, length,
+                             _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+    if (index < length)
+      return it - begin + index;
+  }
+  return std::string_view::npos;
+}
+
+__attribute__((target("avx2"))) size_t ByteScanner::find_avx2(const char *begin,
+                                                              const char *end,
+                                                              std::string_view set) {
+  if (set.size() > 4)
+    return find_sse42(begin, end, set); // One comparison per delimiter stops paying off
+
+  // Sets of up to four delimiters, padded by repeating the first, compare without a loop
+  __m256i first = _mm256_set1_epi8(set[0]);
+  __m256i second = _mm256_set1_epi8(set[std::min<size_t>(1, set.size() - 1)]);
+  __m256i third = _mm256_set1_epi8(set[std::min<size_t>(2, set.size() - 1)]);
+  __m256i fourth = _mm256_set1_epi8(set[std::min<size_t>(3, set.size() - 1)]);
+
+  for (const char *it = begin; it < end; it += 32) {
+    size_t remaining = end - it;
+    if (remaining < 32 && !within_page(it, 32))
+      return add_offset(it - begin, find_sse42(it, end, set));
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(it));
+    __m256i matches = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, first), _mm256_cmpeq_epi8(block, second)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, third), _mm256_cmpeq_epi8(block, fourth)));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(matches));
+    if (remaining < 32)
+      mask &= (uint32_t(1) << remaining) - 1;
+    if (mask != 0)
+      return it - begin + __builtin_ctz(mask);
+  }
+  return std::string_view::npos;
+}
+
+#else
+
+size_t ByteScanner::find_sse42(const char *begin, const char *end, std::string_view set) {
+  return find_scalar(begin, end, set);
+}
+
+size_t ByteScanner::find_avx2(const char *begin, const char *end, std::string_view set) {
+  return find_scalar(begin, end, set);
+}
+
+#endif
+
+} // namespace express
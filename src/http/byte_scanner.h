@@ -0,0 +1,60 @@
+#ifndef EXPRESS_BYTE_SCANNER_H
+#define EXPRESS_BYTE_SCANNER_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace express {
+/**
+ * @brief Finds the first of a few delimiter bytes, e.g. CR, ':' or ' ', many bytes at a time.
+ *
+ * Compares 32 bytes per step with AVX2 or 16 with SSE4.2, in the style of picohttpparser, and
+ * falls back to a byte loop elsewhere. The variant is picked once from CPUID, so the library
+ * needs no special compiler flags. The vector variants may load up to a vector past the end of
+ * the text, never across a page boundary, and ignore those bytes.
+ */
+class ByteScanner {
+public:
+  enum class Isa { SCALAR, SSE42, AVX2 };
+
+  /**
+   * @returns The variant find() uses on this CPU.
+   */
+  static Isa isa();
+
+  /**
+   * @returns True if this CPU can run the given variant.
+   */
+  static bool supports(Isa isa);
+
+  /**
+   * Finds the first byte of `text`, from `from` on, that is one of the bytes in `set`.
+   * @param set Delimiters to look for. Sets larger than MAX_SET_SIZE are searched a byte at a
+   * time.
+   * @returns Index of the byte, or std::string_view::npos if there is none.
+   */
+  static size_t find(std::string_view text, std::string_view set, size_t from = 0);
+
+  /**
+   * Same as find(), with the given variant, for tests and benchmarks. The CPU must support it.
+   */
+  static size_t find(Isa isa, std::string_view text, std::string_view set, size_t from = 0);
+
+  /** Most delimiters the vector variants compare at once, as one SSE register of them */
+  static constexpr size_t MAX_SET_SIZE = 16;
+
+private:
+  using Finder = size_t (*)(const char *begin, const char *end, std::string_view set);
+
+  static Finder finder(Isa isa);
+
+  /** Offsets a found index, leaving npos as it is */
+  static size_t add_offset(size_t offset, size_t found);
+
+  static size_t find_scalar(const char *begin, const char *end, std::string_view set);
+  static size_t find_sse42(const char *begin, const char *end, std::string_view set);
+  static size_t find_avx2(const char *begin, const char *end, std::string_view set);
+};
+} // namespace express
+
+#endif
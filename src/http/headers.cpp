@@ -0,0 +1,116 @@
+#include <express/headers.h>
+
+namespace {
+constexpr char to_lower(char c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+} // namespace
+
+std::optional<express::Header> express::Headers::id(std::string_view name) {
+  constexpr size_t MAX_LENGTH = 17;
+
+  // Well-known names bucketed by length, so a name is compared with at most a few of them
+  static constexpr auto by_length = [] {
+    struct {
+      std::array<uint8_t, WELL_KNOWN_COUNT> ids{};
+      std::array<uint8_t, MAX_LENGTH + 2> starts{};
+    } index;
+    for (std::string_view known : names_) {
+      if (known.size() > MAX_LENGTH)
+        throw "MAX_LENGTH is shorter than a well-known header name";
+      index.starts[known.size() + 1]++;
+    }
+    for (size_t length = 1; length < index.starts.size(); length++) {
+      index.starts[length] += index.starts[length - 1];
+    }
+    std::array<uint8_t, MAX_LENGTH + 2> next = index.starts;
+    for (size_t i = 0; i < names_.size(); i++) {
+      index.ids[next[names_[i].size()]++] = static_cast<uint8_t>(i);
+    }
+    return index;
+  }();
+
+  if (name.size() > MAX_LENGTH)
+    return std::nullopt;
+  for (size_t i = by_length.starts[name.size()]; i < by_length.starts[name.size() + 1]; i++) {
+    if (equals(name, names_[by_length.ids[i]]))
+      return static_cast<Header>(by_length.ids[i]);
+  }
+  return std::nullopt;
+}
+
+std::string_view express::Headers::name(Header id) {
+  return names_[static_cast<size_t>(id)];
+}
+
+bool express::Headers::equals(std::string_view a, std::string_view b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (to_lower(a[i]) != to_lower(b[i]))
+      return false;
+  }
+  return true;
+}
+
+std::string_view express::Headers::get(Header id) const {
+  uint32_t slot = slots_[static_cast<size_t>(id)];
+  return slot == 0 ? std::string_view() : data()[slot - 1].value;
+}
+
+std::string_view express::Headers::get(std::string_view name) const {
+  std::optional<size_t> position = find(name);
+  return position ? data()[*position].value : std::string_view();
+}
+
+bool express::Headers::contains(Header id) const {
+  return slots_[static_cast<size_t>(id)] != 0;
+}
+
+bool express::Headers::contains(std::string_view name) const {
+  return find(name).has_value();
+}
+
+void express::Headers::add(std::string_view name, std::string_view value) {
+  if (size_ < INLINE_CAPACITY) {
+    inline_fields_[size_] = Field{name, value};
+  } else {
+    if (size_ == INLINE_CAPACITY) {
+      spilled_fields_.assign(inline_fields_.begin(), inline_fields_.end());
+    }
+    spilled_fields_.push_back(Field{name, value});
+  }
+  size_++;
+  if (std::optional<Header> known = id(name)) {
+    slots_[static_cast<size_t>(*known)] = size_;
+  }
+}
+
+void express::Headers::set(std::string_view name, std::string_view value) {
+  std::optional<size_t> position = find(name);
+  if (!position) {
+    add(name, value);
+    return;
+  }
+  data()[*position].value = value;
+}
+
+const express::Headers::Field *express::Headers::data() const {
+  return size_ > INLINE_CAPACITY ? spilled_fields_.data() : inline_fields_.data();
+}
+
+express::Headers::Field *express::Headers::data() {
+  return size_ > INLINE_CAPACITY ? spilled_fields_.data() : inline_fields_.data();
+}
+
+std::optional<size_t> express::Headers::find(std::string_view name) const {
+  if (std::optional<Header> known = id(name)) {
+    uint32_t slot = slots_[static_cast<size_t>(*known)];
+    return slot == 0 ? std::nullopt : std::optional<size_t>(slot - 1);
+  }
+  for (size_t i = size_; i > 0; i--) {
+    if (equals(data()[i - 1].name, name))
+      return i - 1;
+  }
+  return std::nullopt;
+}
@@ -1,45 +1,88 @@
 #ifndef EXPRESS_HTTP_VERB_H
 #define EXPRESS_HTTP_VERB_H
 
+#include <array>
+#include <cstdint>
+#include <optional>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace express {
 struct HttpVerb {
 public:
-  enum class Value { GET, POST, PUT, DELETE };
+  enum class Value { GET, POST, PUT, DELETE, HEAD, PATCH, OPTIONS, CONNECT, TRACE };
 
-  static inline const std::string toString(Value value) { return enum_to_string.at(value); }
+  /** Number of verbs, for tables indexed by Value */
+  static constexpr size_t COUNT = 9;
 
-  static inline Value toEnum(const std::string &str) {
-    try {
-      return string_to_enum.at(str);
-    } catch (const std::out_of_range &e) {
+  static inline const std::string toString(Value value) {
+    return std::string(names_[static_cast<size_t>(value)]);
+  }
+
+  static inline Value toEnum(std::string_view str) {
+    std::optional<Value> value = decode(str);
+    if (!value)
       throw std::runtime_error("String is not a valid HttpVerb");
-    }
+    return *value;
   }
 
+  /**
+   * Decodes a method without allocating: the method's bytes are packed into one word and
+   * compared against the packed names of the known verbs.
+   * @param method Method token from the request line, e.g. "GET".
+   * @returns The verb, or nothing if the method is unknown.
+   */
+  static constexpr std::optional<Value> decode(std::string_view method);
+
 private:
-  static const std::unordered_map<Value, std::string> enum_to_string;
-  static const std::unordered_map<std::string, Value> string_to_enum;
+  static constexpr std::array<std::string_view, COUNT> names_ = {
+      "GET", "POST", "PUT", "DELETE", "HEAD", "PATCH", "OPTIONS", "CONNECT", "TRACE"};
+
+  static constexpr size_t MAX_LENGTH_ = 7;
+
+  /**
+   * Packs a token of up to seven bytes into one little-endian word, with the length in the top
+   * byte so that tokens differing only by trailing NUL bytes stay distinct.
+   * @private
+   */
+  static constexpr uint64_t pack(std::string_view token) {
+    uint64_t word = 0;
+    for (size_t i = 0; i < token.size(); i++) {
+      word |= static_cast<uint64_t>(static_cast<unsigned char>(token[i])) << (8 * i);
+    }
+    return word | static_cast<uint64_t>(token.size()) << 56;
+  }
 };
 
-// Define the static members
-inline const std::unordered_map<HttpVerb::Value, std::string> HttpVerb::enum_to_string = {
-    {HttpVerb::Value::GET, "GET"},
-    {HttpVerb::Value::POST, "POST"},
-    {HttpVerb::Value::PUT, "PUT"},
-    {HttpVerb::Value::DELETE, "DELETE"}};
-
-inline const std::unordered_map<std::string, HttpVerb::Value> HttpVerb::string_to_enum = []() {
-  std::unordered_map<std::string, HttpVerb::Value> result;
-  for (const auto &[value, str] : enum_to_string) {
-    result[str] = value;
+// Defined once the class is complete, so the case labels can call pack()
+constexpr std::optional<HttpVerb::Value> HttpVerb::decode(std::string_view method) {
+  if (method.empty() || method.size() > MAX_LENGTH_)
+    return std::nullopt;
+  switch (pack(method)) {
+    case pack("GET"):
+      return Value::GET;
+    case pack("POST"):
+      return Value::POST;
+    case pack("PUT"):
+      return Value::PUT;
+    case pack("DELETE"):
+      return Value::DELETE;
+    case pack("HEAD"):
+      return Value::HEAD;
+    case pack("PATCH"):
+      return Value::PATCH;
+    case pack("OPTIONS"):
+      return Value::OPTIONS;
+    case pack("CONNECT"):
+      return Value::CONNECT;
+    case pack("TRACE"):
+      return Value::TRACE;
+    default:
+      return std::nullopt;
   }
-  return result;
-}();
+}
 
 } // namespace express
 
-#endif
\ No newline at end of file
+#endif
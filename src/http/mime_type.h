@@ -0,0 +1,64 @@
+#ifndef EXPRESS_MIME_TYPE_H
+#define EXPRESS_MIME_TYPE_H
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+namespace express {
+class MimeType {
+public:
+  /**
+   * Infers the Content-Type of a file from its extension, case-insensitively.
+   * @returns The media type, or "application/octet-stream" for unknown extensions.
+   */
+  static std::string from_path(const std::filesystem::path &path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    auto it = types_.find(extension);
+    if (it != types_.end()) {
+      return it->second;
+    }
+    return "application/octet-stream";
+  }
+
+private:
+  static inline const std::unordered_map<std::string, std::string> types_ = {
+      {".html", "text/html; charset=utf-8"},
+      {".htm", "text/html; charset=utf-8"},
+      {".css", "text/css; charset=utf-8"},
+      {".js", "text/javascript; charset=utf-8"},
+      {".mjs", "text/javascript; charset=utf-8"},
+      {".json", "application/json; charset=utf-8"},
+      {".map", "application/json; charset=utf-8"},
+      {".txt", "text/plain; charset=utf-8"},
+      {".csv", "text/csv; charset=utf-8"},
+      {".xml", "application/xml"},
+      {".svg", "image/svg+xml"},
+      {".png", "image/png"},
+      {".jpg", "image/jpeg"},
+      {".jpeg", "image/jpeg"},
+      {".gif", "image/gif"},
+      {".webp", "image/webp"},
+      {".avif", "image/avif"},
+      {".ico", "image/x-icon"},
+      {".woff", "font/woff"},
+      {".woff2", "font/woff2"},
+      {".ttf", "font/ttf"},
+      {".otf", "font/otf"},
+      {".wasm", "application/wasm"},
+      {".pdf", "application/pdf"},
+      {".zip", "application/zip"},
+      {".gz", "application/gzip"},
+      {".mp3", "audio/mpeg"},
+      {".wav", "audio/wav"},
+      {".mp4", "video/mp4"},
+      {".webm", "video/webm"},
+  };
+};
+} // namespace express
+
+#endif
@@ -0,0 +1,288 @@
+#include "http/http_status.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <express/multipart.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+constexpr std::string_view CRLF = "\r\n";
+constexpr std::string_view HEADERS_END = "\r\n\r\n";
+constexpr std::string_view FORM_DATA_MEDIA_TYPE = "multipart/form-data";
+
+std::string_view trim(std::string_view text) {
+  size_t start = text.find_first_not_of(" \t");
+  if (start == std::string_view::npos)
+    return std::string_view();
+  return text.substr(start, text.find_last_not_of(" \t") - start + 1);
+}
+
+/**
+ * @returns Value of a `key=value` parameter following the first ';' of a header value, such as
+ * the boundary of a Content-Type or the name of a Content-Disposition, without its quotes.
+ */
+std::string_view header_parameter(std::string_view value, std::string_view key) {
+  size_t separator = value.find(';');
+  while (separator != std::string_view::npos) {
+    size_t next = value.find(';', separator + 1);
+    std::string_view parameter = value.substr(separator + 1, next - separator - 1);
+    separator = next;
+
+    size_t equals = parameter.find('=');
+    if (equals == std::string_view::npos ||
+        !express::Headers::equals(trim(parameter.substr(0, equals)), key))
+      continue;
+    std::string_view parameter_value = trim(parameter.substr(equals + 1));
+    if (parameter_value.size() >= 2 && parameter_value.front() == '"') {
+      // Quoted values may hold ';', so take everything up to the closing quote
+      size_t value_start = static_cast<size_t>(parameter_value.data() - value.data()) + 1;
+      size_t closing = value.find('"', value_start);
+      return closing == std::string_view::npos
+                 ? std::string_view()
+                 : value.substr(value_start, closing - value_start);
+    }
+    return parameter_value;
+  }
+  return std::string_view();
+}
+} // namespace
+
+std::string_view express::MultipartParser::boundary(std::string_view content_type) {
+  if (!Headers::equals(trim(content_type.substr(0, content_type.find(';'))),
+                       FORM_DATA_MEDIA_TYPE))
+    return std::string_view();
+  return header_parameter(content_type, "boundary");
+}
+
+express::MultipartParser::MultipartParser(std::string_view boundary, Callbacks callbacks)
+    : callbacks_(std::move(callbacks)), held_(CRLF) {
+  if (boundary.empty() || boundary.size() > MAX_BOUNDARY_SIZE_)
+    fail(400);
+  delimiter_.reserve(CRLF.size() + 2 + boundary.size());
+  delimiter_.append(CRLF).append("--").append(boundary);
+
+  // Bytes not in the delimiter, or only as its last byte, skip the delimiter's whole length
+  shifts_.fill(static_cast<uint8_t>(delimiter_.size()));
+  for (size_t i = 0; i + 1 < delimiter_.size(); i++) {
+    shifts_[static_cast<unsigned char>(delimiter_[i])] =
+        static_cast<uint8_t>(delimiter_.size() - 1 - i);
+  }
+}
+
+void express::MultipartParser::feed(std::string_view chunk) {
+  size_t offset = 0;
+  while (offset < chunk.size()) {
+    switch (state_) {
+      case State::PREAMBLE:
+      case State::CONTENT:
+        offset = parse_content(chunk, offset);
+        break;
+      case State::HEADERS:
+        offset = parse_headers(chunk, offset);
+        break;
+      case State::EPILOGUE:
+        return;
+      case State::FAILED:
+        fail(400);
+      default:
+        offset = parse_delimiter_end(chunk, offset);
+        break;
+    }
+  }
+}
+
+void express::MultipartParser::finish() {
+  if (state_ != State::EPILOGUE)
+    fail(400);
+}
+
+bool express::MultipartParser::done() const {
+  return state_ == State::EPILOGUE;
+}
+
+void express::MultipartParser::write_to(int fd) {
+  fd_ = fd;
+}
+
+express::Task<> express::MultipartParser::parse(Request &req) {
+  std::string_view chunk;
+  while (!(chunk = co_await req.body_chunk()).empty()) {
+    feed(chunk);
+  }
+  finish();
+}
+
+size_t express::MultipartParser::parse_content(std::string_view chunk, size_t offset) {
+  std::string_view rest = chunk.substr(offset);
+
+  if (!held_.empty()) {
+    // A delimiter may begin in the held bytes and end in this chunk, so look at both together
+    size_t held_size = held_.size();
+    size_t borrowed = std::min(rest.size(), delimiter_.size() - 1);
+    held_.append(rest.substr(0, borrowed));
+    size_t start = 0;
+    for (; start < held_size; start++) {
+      size_t compared = std::min(held_.size() - start, delimiter_.size());
+      if (held_.compare(start, compared, delimiter_, 0, compared) == 0)
+        break;
+    }
+
+    if (start < held_size && held_.size() - start < delimiter_.size()) {
+      // Still only the beginning of a delimiter, which the whole chunk went into
+      emit(std::string_view(held_).substr(0, start));
+      held_.erase(0, start);
+      return chunk.size();
+    }
+    emit(std::string_view(held_).substr(0, std::min(start, held_size)));
+    held_.clear();
+    if (start < held_size) {
+      end_content();
+      return offset + start + delimiter_.size() - held_size;
+    }
+  }
+
+  size_t found = find_delimiter(rest);
+  if (found != std::string_view::npos) {
+    emit(rest.substr(0, found));
+    end_content();
+    return offset + found + delimiter_.size();
+  }
+  size_t partial = partial_delimiter(rest);
+  emit(rest.substr(0, rest.size() - partial));
+  held_.assign(rest.substr(rest.size() - partial));
+  return chunk.size();
+}
+
+size_t express::MultipartParser::parse_delimiter_end(std::string_view chunk, size_t offset) {
+  for (; offset < chunk.size(); offset++) {
+    char c = chunk[offset];
+    if (state_ == State::AFTER_DELIMITER && c == '-') {
+      state_ = State::CLOSING;
+    } else if (state_ == State::AFTER_DELIMITER && (c == ' ' || c == '\t')) {
+      continue; // Transport padding
+    } else if (state_ == State::AFTER_DELIMITER && c == '\r') {
+      state_ = State::DELIMITER_LF;
+    } else if (state_ == State::CLOSING && c == '-') {
+      state_ = State::EPILOGUE;
+      return offset + 1;
+    } else if (state_ == State::DELIMITER_LF && c == '\n') {
+      state_ = State::HEADERS;
+      part_headers_.assign(CRLF); // So a part without headers ends at the first blank line
+      return offset + 1;
+    } else {
+      fail(400);
+    }
+  }
+  return offset;
+}
+
+size_t express::MultipartParser::parse_headers(std::string_view chunk, size_t offset) {
+  size_t collected = part_headers_.size();
+  size_t search_from = collected - std::min(collected, HEADERS_END.size() - 1);
+  size_t capacity = MAX_HEADER_SIZE_ + CRLF.size();
+  part_headers_.append(chunk.substr(offset, capacity - std::min(capacity, collected)));
+
+  size_t headers_end = part_headers_.find(HEADERS_END, search_from);
+  if (headers_end == std::string::npos) {
+    if (part_headers_.size() >= capacity)
+      fail(431);
+    return chunk.size();
+  }
+  part_headers_.resize(headers_end + HEADERS_END.size());
+  begin_part(std::string_view(part_headers_).substr(CRLF.size(), headers_end));
+  return offset + part_headers_.size() - collected;
+}
+
+void express::MultipartParser::begin_part(std::string_view header_lines) {
+  part_ = MultipartPart();
+  size_t line_start = 0;
+  while (line_start < header_lines.size()) {
+    size_t line_end = std::min(header_lines.find(CRLF, line_start), header_lines.size());
+    std::string_view line = header_lines.substr(line_start, line_end - line_start);
+    line_start = line_end + CRLF.size();
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0)
+      fail(400);
+    part_.headers.add(line.substr(0, colon), trim(line.substr(colon + 1)));
+  }
+
+  std::string_view disposition = part_.headers.get("Content-Disposition");
+  part_.name = header_parameter(disposition, "name");
+  part_.filename = header_parameter(disposition, "filename");
+  part_.content_type = part_.headers.get(Header::ContentType);
+
+  state_ = State::CONTENT;
+  fd_ = -1;
+  if (callbacks_.on_part) {
+    callbacks_.on_part(part_);
+  }
+}
+
+void express::MultipartParser::end_content() {
+  if (state_ == State::CONTENT && callbacks_.on_part_end) {
+    callbacks_.on_part_end();
+  }
+  fd_ = -1;
+  state_ = State::AFTER_DELIMITER;
+}
+
+void express::MultipartParser::emit(std::string_view content) {
+  if (state_ != State::CONTENT || content.empty())
+    return;
+  if (fd_ < 0) {
+    if (callbacks_.on_data) {
+      callbacks_.on_data(content);
+    }
+    return;
+  }
+  while (!content.empty()) {
+    ssize_t written = ::write(fd_, content.data(), content.size());
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written < 0)
+      throw std::runtime_error("Failed to write multipart content: " +
+                               std::string(std::strerror(errno)));
+    content.remove_prefix(static_cast<size_t>(written));
+  }
+}
+
+size_t express::MultipartParser::find_delimiter(std::string_view text) const {
+  size_t length = delimiter_.size();
+  if (text.size() < length)
+    return std::string_view::npos;
+
+  // Compare the byte under the delimiter's end first, and shift by what it allows on mismatch
+  const char *data = text.data();
+  char last = delimiter_.back();
+  size_t position = 0;
+  size_t last_position = text.size() - length;
+  while (position <= last_position) {
+    char c = data[position + length - 1];
+    if (c == last && std::memcmp(data + position, delimiter_.data(), length - 1) == 0)
+      return position;
+    position += shifts_[static_cast<unsigned char>(c)];
+  }
+  return std::string_view::npos;
+}
+
+size_t express::MultipartParser::partial_delimiter(std::string_view text) const {
+  // Every delimiter begins with CR, so only CRs near the end need comparing
+  size_t start = text.size() - std::min(text.size(), delimiter_.size() - 1);
+  while (start < text.size()) {
+    const void *cr = std::memchr(text.data() + start, '\r', text.size() - start);
+    if (cr == nullptr)
+      return 0;
+    start = static_cast<const char *>(cr) - text.data();
+    if (delimiter_.compare(0, text.size() - start, text.substr(start)) == 0)
+      return text.size() - start;
+    start++;
+  }
+  return 0;
+}
+
+void express::MultipartParser::fail(int status) {
+  state_ = State::FAILED;
+  throw BodyError(status, HttpStatus::get_message(status));
+}
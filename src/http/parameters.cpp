@@ -0,0 +1,123 @@
+#include "http/url_codec.h"
+#include <algorithm>
+#include <express/parameters.h>
+
+express::Parameters::Parameters(std::string_view source, Syntax syntax)
+    : source_(source), syntax_(syntax) {
+}
+
+std::string_view express::Parameters::get(std::string_view key) const {
+  size_t position = find(key);
+  return position < fields_.size() ? fields_[position].value : std::string_view();
+}
+
+bool express::Parameters::contains(std::string_view key) const {
+  return find(key) < fields_.size();
+}
+
+size_t express::Parameters::size() const {
+  parse();
+  return fields_.size();
+}
+
+express::Parameters::const_iterator express::Parameters::begin() const {
+  parse();
+  return fields_.begin();
+}
+
+express::Parameters::const_iterator express::Parameters::end() const {
+  parse();
+  return fields_.end();
+}
+
+void express::Parameters::parse() const {
+  if (parsed_)
+    return;
+  parsed_ = true;
+
+  char separator = syntax_ == Syntax::COOKIE ? ';' : '&';
+  auto trim = [this](std::string_view text) {
+    if (syntax_ != Syntax::COOKIE)
+      return text;
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string_view::npos)
+      return std::string_view();
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+  };
+
+  size_t start = 0;
+  while (start < source_.size()) {
+    size_t end = std::min(source_.find(separator, start), source_.size());
+    std::string_view pair = source_.substr(start, end - start);
+    start = end + 1;
+
+    size_t equals = pair.find('=');
+    if (equals == std::string_view::npos)
+      continue;
+    std::string_view key = trim(pair.substr(0, equals));
+    std::string_view value = trim(pair.substr(equals + 1));
+    if (key.empty())
+      continue;
+    if (syntax_ == Syntax::COOKIE && value.size() >= 2 && value.front() == '"' &&
+        value.back() == '"') {
+      value = value.substr(1, value.size() - 2);
+    }
+    key = decode(key);
+    size_t existing = find_parsed(key);
+    if (existing < fields_.size()) {
+      fields_[existing].value = decode(value); // The last value of a repeated key wins
+    } else {
+      fields_.push_back(Field{key, decode(value)});
+      index_field(fields_.size() - 1);
+    }
+  }
+}
+
+std::string_view express::Parameters::decode(std::string_view raw) const {
+  std::string_view escapes = syntax_ == Syntax::COOKIE ? "%" : "%+";
+  if (raw.find_first_of(escapes) == std::string_view::npos)
+    return raw;
+
+  // Decoding never lengthens text, so everything decoded fits in a buffer the size of the source
+  if (!decoded_) {
+    decoded_ = std::make_unique_for_overwrite<char[]>(source_.size());
+  }
+  char *destination = decoded_.get() + decoded_size_;
+  UrlCodec::DecodeResult result =
+      UrlCodec::decode(raw, destination, syntax_ == Syntax::URL_ENCODED);
+  if (result.error != UrlCodec::Error::NONE)
+    return raw; // Malformed escapes are kept as sent
+  decoded_size_ += result.size;
+  return std::string_view(destination, result.size);
+}
+
+size_t express::Parameters::find(std::string_view key) const {
+  parse();
+  return find_parsed(key);
+}
+
+void express::Parameters::index_field(size_t position) const {
+  if (!index_.empty()) {
+    index_.emplace(fields_[position].key, position);
+    return;
+  }
+  if (fields_.size() <= INDEX_THRESHOLD_)
+    return;
+  // Many fields, e.g. a large form body: scanning them for every key would be quadratic
+  index_.reserve(fields_.size() * 2);
+  for (size_t i = 0; i < fields_.size(); i++) {
+    index_.emplace(fields_[i].key, i);
+  }
+}
+
+size_t express::Parameters::find_parsed(std::string_view key) const {
+  if (!index_.empty()) {
+    auto it = index_.find(key);
+    return it != index_.end() ? it->second : fields_.size();
+  }
+  for (size_t i = 0; i < fields_.size(); i++) {
+    if (fields_[i].key == key)
+      return i;
+  }
+  return fields_.size();
+}
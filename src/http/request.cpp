@@ -1,14 +1,19 @@
-#include "http/url_codec.h"
+#include "http/body_stream.h"
+#include "http/byte_scanner.h"
+#include <algorithm>
 #include <express/request.h>
 
 namespace express {
 class RequestParser {
 public:
   static void parse(Request &request, std::string_view raw_request) {
-    SplitRequest split = split_request(raw_request);
-    parse_request_line(request, split.request_line);
-    parse_headers(request, split.headers);
-    request.body = split.body;
+    size_t headers_start = parse_request_line(request, raw_request);
+    size_t body_start = parse_headers(request, raw_request, headers_start);
+    request.body = raw_request.substr(std::min(body_start, raw_request.size()));
+    request.cookies = Parameters(request.header(Header::Cookie), Parameters::Syntax::COOKIE);
+    if (is_form(request.header(Header::ContentType))) {
+      request.form = Parameters(request.body, Parameters::Syntax::URL_ENCODED);
+    }
   }
 
 private:
@@ -17,90 +22,95 @@ private:
   static constexpr char REQUEST_LINE_DELIMITER = ' ';
   static constexpr char HEADER_DELIMITER = ':';
 
-  struct SplitRequest {
-    std::string_view request_line;
-    std::vector<std::string_view> headers;
-    std::string_view body;
-  };
-
-  struct SplitUrl {
-    std::string_view path;
-    std::string_view params;
-  };
-
-  static SplitRequest split_request(std::string_view raw_request) {
-    std::string_view request_line;
-    std::vector<std::string_view> headers;
-    int left = 0;
-    bool is_first_line = true;
-    for (int i = 0; i < raw_request.length(); i++) {
-      char c = raw_request.at(i);
-      if (is_crlf(raw_request, i)) {
-        if (is_crlf(raw_request, left))
-          break; // left is CRLF
-        std::string_view line = raw_request.substr(left, i - left);
-        left = i + 2;
-        if (is_first_line) {
-          request_line = line;
-          is_first_line = false;
-          continue;
-        }
-        headers.push_back(line);
-      }
-    }
-    int body_start_index = left + 2;
-    std::string_view body =
-        raw_request.substr(body_start_index, raw_request.length() - body_start_index);
+  // Delimiter sets handed to the scanner, which compares against all of them at once
+  static constexpr std::string_view REQUEST_LINE_STOPS_ = " \r";
+  static constexpr std::string_view HEADER_NAME_STOPS_ = ":\r";
+  static constexpr std::string_view LINE_STOPS_ = "\r";
+
+  static constexpr std::string_view FORM_MEDIA_TYPE_ = "application/x-www-form-urlencoded";
+
+  /**
+   * Parses the request line, the method, target and version separated by single spaces.
+   * @returns Index of the first header line.
+   * @throws std::invalid_argument if the line does not have exactly three components.
+   */
+  static size_t parse_request_line(Request &request, std::string_view raw_request) {
+    size_t method_end = ByteScanner::find(raw_request, REQUEST_LINE_STOPS_);
+    size_t target_end = next_space(raw_request, method_end);
+    size_t line_end = next_space(raw_request, target_end);
+    if (line_end != std::string_view::npos && raw_request[line_end] == REQUEST_LINE_DELIMITER)
+      throw std::invalid_argument("Request line does not have exactly three components");
+    line_end = std::min(line_end, raw_request.size());
 
-    return SplitRequest{request_line, headers, body};
+    request.method = raw_request.substr(0, method_end);
+    request.original_url = raw_request.substr(method_end + 1, target_end - method_end - 1);
+    request.http_version = raw_request.substr(target_end + 1, line_end - target_end - 1);
+    request.query = Parameters(split_url(request), Parameters::Syntax::URL_ENCODED);
+    return line_end + 2;
   }
 
-  static void parse_request_line(Request &request, std::string_view request_line) {
-    int left = 0;
-    std::vector<std::string_view> parts;
-    for (int i = 0; i < request_line.length(); i++) {
-      char c = request_line.at(i);
-      if (c == REQUEST_LINE_DELIMITER) {
-        std::string_view segment = request_line.substr(left, i - left);
-        parts.push_back(segment);
-        left = i + 1;
-      }
-    }
-    parts.push_back(request_line.substr(left, request_line.length() - left));
-    if (parts.size() != 3)
+  /**
+   * @returns Index of the space or CR following the space at `space`.
+   * @throws std::invalid_argument if `space` is not a space, so the line ended early.
+   */
+  static size_t next_space(std::string_view raw_request, size_t space) {
+    if (space == std::string_view::npos || raw_request[space] != REQUEST_LINE_DELIMITER)
       throw std::invalid_argument("Request line does not have exactly three components");
-    request.method = parts[0];
-    request.original_url = parts[1];
-    request.http_version = parts[2];
-
-    parse_url(request);
+    return ByteScanner::find(raw_request, REQUEST_LINE_STOPS_, space + 1);
   }
 
-  static void parse_url(Request &request) {
-    std::string_view query = split_url(request);
-    size_t param_start = 0;
-    size_t param_end;
-
-    while (param_start < query.length()) {
-      param_end = query.find('&', param_start);
-      if (param_end == std::string::npos) {
-        param_end = query.length();
+  /**
+   * Parses the header lines up to the blank line. Lines without a colon are skipped, and leading
+   * whitespace is dropped from values.
+   * @returns Index of the first body byte.
+   */
+  static size_t parse_headers(Request &request, std::string_view raw_request, size_t position) {
+    while (position < raw_request.size()) {
+      if (is_crlf(raw_request, position))
+        return position + 2; // Blank line ending the headers
+
+      size_t name_end = ByteScanner::find(raw_request, HEADER_NAME_STOPS_, position);
+      if (name_end == std::string_view::npos)
+        break;
+      if (raw_request[name_end] == CR) {
+        position = name_end + 2;
+        continue;
       }
 
-      std::string_view param = query.substr(param_start, param_end - param_start);
-
-      size_t equals_pos = param.find('=');
-      if (equals_pos != std::string::npos) {
-        std::string_view key = param.substr(0, equals_pos);
-        std::string_view value = param.substr(equals_pos + 1);
-
-        if (!key.empty()) {
-          request.params[UrlCodec::decode(key)] = UrlCodec::decode(value);
-        }
+      size_t value_start = name_end + 1;
+      while (value_start < raw_request.size() &&
+             (raw_request[value_start] == ' ' || raw_request[value_start] == '\t')) {
+        value_start++;
       }
+      size_t line_end = find_line_end(raw_request, value_start);
+      request.headers.add(raw_request.substr(position, name_end - position),
+                          raw_request.substr(value_start, line_end - value_start));
+      position = line_end + 2;
+    }
+    return raw_request.size();
+  }
+
+  /**
+   * @returns Index of the CR of the next CRLF from `from` on, or the end of the request.
+   */
+  static size_t find_line_end(std::string_view raw_request, size_t from) {
+    size_t cr = ByteScanner::find(raw_request, LINE_STOPS_, from);
+    while (cr != std::string_view::npos && !is_crlf(raw_request, cr)) {
+      cr = ByteScanner::find(raw_request, LINE_STOPS_, cr + 1);
+    }
+    return std::min(cr, raw_request.size());
+  }
 
-      param_start = param_end + 1;
+  /**
+   * @returns True if the content type is application/x-www-form-urlencoded, in any case and
+   * with or without parameters such as a charset.
+   */
+  static bool is_form(std::string_view content_type) {
+    std::string_view media_type = content_type.substr(0, content_type.find(';'));
+    while (!media_type.empty() && (media_type.back() == ' ' || media_type.back() == '\t')) {
+      media_type.remove_suffix(1);
     }
+    return Headers::equals(media_type, FORM_MEDIA_TYPE_);
   }
 
   static std::string_view split_url(Request &request) {
@@ -111,38 +121,71 @@ private:
     }
     request.path = request.original_url.substr(0, question_mark_index);
 
-    std::string_view query = std::string_view(request.original_url).substr(question_mark_index + 1);
-    return query;
+    return request.original_url.substr(question_mark_index + 1);
   }
 
-  static void parse_headers(Request &request, std::vector<std::string_view> header_lines) {
-    for (std::string_view header : header_lines) {
-      for (int i = 0; i < header.length(); i++) {
-        char c = header.at(i);
-        if (c == HEADER_DELIMITER) {
-          std::string key = std::string(header.substr(0, i));
-          int value_start_index = i + 2;
-          std::string value =
-              std::string(header.substr(value_start_index, header.length() - value_start_index));
-          request.headers[key] = value;
-          break;
-        }
-      }
-    }
-  }
-
-  static bool is_crlf(std::string_view str, int i) {
-    if (i < 0 || i + 1 >= str.length())
-      return false;
-    char a = str.at(i);
-    char b = str.at(i + 1);
-    return a == CR && b == LF;
+  static bool is_crlf(std::string_view str, size_t i) {
+    return i + 1 < str.size() && str[i] == CR && str[i + 1] == LF;
   }
 };
 
 // Constructor
-Request::Request(std::string_view raw_request) {
-  RequestParser::parse(*this, raw_request);
+Request::Request(std::string_view raw_request)
+    : buffer_(std::make_unique_for_overwrite<char[]>(raw_request.size())) {
+  std::copy(raw_request.begin(), raw_request.end(), buffer_.get());
+  RequestParser::parse(*this, std::string_view(buffer_.get(), raw_request.size()));
+}
+
+Request::Request(std::string_view head, std::shared_ptr<BodyStream> body) : Request(head) {
+  body_stream_ = std::move(body);
+}
+
+Request::~Request() {
+  if (body_stream_) {
+    body_stream_->abandon(); // The server drops whatever part of the body was not read
+  }
+}
+
+OwnedRequest Request::to_owned() const {
+  OwnedRequest owned;
+  owned.method = method;
+  owned.original_url = original_url;
+  owned.path = path;
+  for (const auto &[key, value] : params) {
+    owned.params.emplace(key, value);
+  }
+  for (const auto &[key, value] : query) {
+    owned.query.insert_or_assign(std::string(key), std::string(value));
+  }
+  owned.base_url = base_url;
+  owned.http_version = http_version;
+  for (const auto &[name, value] : headers) {
+    owned.headers.insert_or_assign(std::string(name), std::string(value));
+  }
+  owned.body = body;
+  return owned;
+}
+
+std::string_view Request::header(Header id) const {
+  return headers.get(id);
+}
+
+std::string_view Request::header(std::string_view name) const {
+  return headers.get(name);
+}
+
+Request::BodyChunkAwaitable Request::body_chunk() {
+  std::string_view chunk = std::string_view(body).substr(body_offset_);
+  body_offset_ = body.size();
+  return BodyChunkAwaitable(chunk, body_stream_.get());
+}
+
+bool Request::BodyChunkAwaitable::await_suspend(std::coroutine_handle<> handle) {
+  return stream_->wait(handle);
+}
+
+std::string_view Request::BodyChunkAwaitable::await_resume() {
+  return stream_ == nullptr ? chunk_ : stream_->take();
 }
 
 } // namespace express
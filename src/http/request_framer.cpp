@@ -0,0 +1,299 @@
+#include "request_framer.h"
+#include "utils/constants.h"
+#include <express/headers.h>
+#include <algorithm>
+#include <cstring>
+
+express::RequestFramer::RequestFramer(size_t max_body_size)
+    : default_body_limit_(max_body_size), body_limit_(max_body_size) {
+}
+
+express::RequestFramer::Status express::RequestFramer::advance(char *data, size_t size) {
+  std::string_view buffered(data, size);
+
+  while (true) {
+    switch (state_) {
+      case State::HEADERS: {
+        // Back up so a terminator split across two reads is still found
+        size_t search_from = scan_offset_ >= HEADERS_END.size() - 1
+                                 ? scan_offset_ - (HEADERS_END.size() - 1)
+                                 : 0;
+        size_t headers_end = buffered.find(HEADERS_END, search_from);
+        if (headers_end == std::string_view::npos) {
+          scan_offset_ = size;
+          if (size > constants::MAX_HEADER_SIZE_)
+            return fail(431);
+          return Status::INCOMPLETE;
+        }
+
+        header_length_ = headers_end + HEADERS_END.size();
+        if (header_length_ > constants::MAX_HEADER_SIZE_)
+          return fail(431);
+        return begin_body(buffered.substr(0, headers_end));
+      }
+
+      case State::BODY: {
+        if (content_length_ > body_limit_)
+          return fail(413);
+        size_t available = std::min(size - scan_offset_, remaining_);
+        if (available < remaining_ && !streaming_)
+          return Status::INCOMPLETE; // A buffered body is only framed once it arrived whole
+        scan_offset_ += available;
+        write_offset_ = scan_offset_;
+        remaining_ -= available;
+        if (remaining_ > 0)
+          return Status::INCOMPLETE;
+        state_ = State::DONE;
+        continue;
+      }
+
+      case State::DONE:
+        return Status::COMPLETE;
+
+      default:
+        return advance_chunked(data, size);
+    }
+  }
+}
+
+void express::RequestFramer::reset() {
+  state_ = State::HEADERS;
+  scan_offset_ = 0;
+  header_length_ = 0;
+  remaining_ = 0;
+  write_offset_ = 0;
+  error_status_ = 0;
+  content_length_ = 0;
+  body_limit_ = default_body_limit_;
+  streaming_ = false;
+  released_ = 0;
+}
+
+bool express::RequestFramer::limit_body(size_t max_size) {
+  body_limit_ = max_size;
+  if (content_length_ > body_limit_) {
+    fail(413);
+    return false;
+  }
+  return true;
+}
+
+size_t express::RequestFramer::body_limit() {
+  return body_limit_;
+}
+
+void express::RequestFramer::stream_body() {
+  streaming_ = true;
+  scan_offset_ -= header_length_;
+  write_offset_ -= header_length_;
+  header_length_ = 0;
+}
+
+void express::RequestFramer::release_body() {
+  released_ += write_offset_;
+  if (state_ == State::TRAILERS) {
+    remaining_ -= std::min(remaining_, scan_offset_); // Trailers seen so far still count
+  }
+  scan_offset_ = 0;
+  write_offset_ = 0;
+}
+
+size_t express::RequestFramer::header_length() {
+  return header_length_;
+}
+
+size_t express::RequestFramer::message_length() {
+  return write_offset_;
+}
+
+size_t express::RequestFramer::consumed_length() {
+  return scan_offset_;
+}
+
+int express::RequestFramer::error_status() {
+  return error_status_;
+}
+
+express::RequestFramer::Status express::RequestFramer::begin_body(std::string_view headers) {
+  bool has_content_length = false;
+  bool chunked = false;
+  size_t content_length = 0;
+
+  // Skip the request line, then look at each header line
+  size_t line_start = headers.find(CRLF);
+  while (line_start != std::string_view::npos) {
+    line_start += CRLF.size();
+    size_t line_end = headers.find(CRLF, line_start);
+    std::string_view line = headers.substr(line_start, line_end - line_start);
+    line_start = line_end;
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos)
+      continue;
+    std::string_view name = line.substr(0, colon);
+    std::string_view value = line.substr(colon + 1);
+    size_t value_start = value.find_first_not_of(" \t");
+    size_t value_end = value.find_last_not_of(" \t");
+    value = value_start == std::string_view::npos
+                ? std::string_view()
+                : value.substr(value_start, value_end - value_start + 1);
+
+    if (Headers::equals(name, "Content-Length")) {
+      size_t parsed;
+      if (!parse_decimal(value, parsed) || (has_content_length && parsed != content_length))
+        return fail(400);
+      has_content_length = true;
+      content_length = parsed;
+    } else if (Headers::equals(name, "Transfer-Encoding")) {
+      // Chunked must be the final coding, e.g. "gzip, chunked"
+      size_t last_comma = value.rfind(',');
+      std::string_view last_coding =
+          last_comma == std::string_view::npos ? value : value.substr(last_comma + 1);
+      last_coding.remove_prefix(std::min(last_coding.find_first_not_of(" \t"), last_coding.size()));
+      if (!Headers::equals(last_coding, "chunked"))
+        return fail(400);
+      chunked = true;
+    }
+  }
+
+  if (chunked && has_content_length)
+    return fail(400); // Ambiguous framing is how requests get smuggled
+
+  scan_offset_ = header_length_;
+  write_offset_ = header_length_;
+  if (chunked) {
+    state_ = State::CHUNK_SIZE;
+    return Status::HEADERS;
+  }
+  if (content_length == 0) {
+    state_ = State::DONE;
+    return Status::COMPLETE;
+  }
+
+  // The limit is checked once the caller had a chance to pick the route's
+  state_ = State::BODY;
+  remaining_ = content_length;
+  content_length_ = content_length;
+  return Status::HEADERS;
+}
+
+express::RequestFramer::Status express::RequestFramer::advance_chunked(char *data, size_t size) {
+  std::string_view buffered(data, size);
+
+  while (true) {
+    switch (state_) {
+      case State::CHUNK_SIZE: {
+        size_t line_end = buffered.find(CRLF, scan_offset_);
+        if (line_end == std::string_view::npos) {
+          if (size - scan_offset_ > MAX_CHUNK_LINE_)
+            return fail(400);
+          return Status::INCOMPLETE;
+        }
+
+        size_t chunk_size;
+        if (!parse_chunk_size(buffered.substr(scan_offset_, line_end - scan_offset_), chunk_size))
+          return fail(400);
+        scan_offset_ = line_end + CRLF.size();
+
+        if (chunk_size == 0) {
+          state_ = State::TRAILERS;
+          remaining_ = scan_offset_; // Start of the trailer section, to bound its size
+          continue;
+        }
+        size_t body_length = released_ + write_offset_ - header_length_;
+        if (chunk_size > body_limit_ - std::min(body_limit_, body_length))
+          return fail(413);
+        remaining_ = chunk_size;
+        state_ = State::CHUNK_DATA;
+        continue;
+      }
+
+      case State::CHUNK_DATA: {
+        size_t available = std::min(size - scan_offset_, remaining_);
+        if (available > 0 && write_offset_ != scan_offset_) {
+          std::memmove(data + write_offset_, data + scan_offset_, available);
+        }
+        write_offset_ += available;
+        scan_offset_ += available;
+        remaining_ -= available;
+        if (remaining_ > 0)
+          return Status::INCOMPLETE;
+        state_ = State::CHUNK_DATA_END;
+        continue;
+      }
+
+      case State::CHUNK_DATA_END:
+        if (size - scan_offset_ < CRLF.size())
+          return Status::INCOMPLETE;
+        if (buffered.substr(scan_offset_, CRLF.size()) != CRLF)
+          return fail(400);
+        scan_offset_ += CRLF.size();
+        state_ = State::CHUNK_SIZE;
+        continue;
+
+      case State::TRAILERS: {
+        size_t line_end = buffered.find(CRLF, scan_offset_);
+        if (line_end == std::string_view::npos) {
+          if (size - remaining_ > constants::MAX_HEADER_SIZE_)
+            return fail(431);
+          return Status::INCOMPLETE;
+        }
+        bool blank_line = line_end == scan_offset_;
+        scan_offset_ = line_end + CRLF.size(); // Trailer fields are not exposed, only skipped
+        if (blank_line) {
+          state_ = State::DONE;
+          return Status::COMPLETE;
+        }
+        continue;
+      }
+
+      default:
+        return Status::ERROR;
+    }
+  }
+}
+
+express::RequestFramer::Status express::RequestFramer::fail(int status) {
+  error_status_ = status;
+  return Status::ERROR;
+}
+
+bool express::RequestFramer::parse_decimal(std::string_view digits, size_t &value) {
+  if (digits.empty())
+    return false;
+  value = 0;
+  for (char c : digits) {
+    if (c < '0' || c > '9')
+      return false;
+    size_t digit = c - '0';
+    if (value > (SIZE_MAX - digit) / 10)
+      return false;
+    value = value * 10 + digit;
+  }
+  return true;
+}
+
+bool express::RequestFramer::parse_chunk_size(std::string_view line, size_t &value) {
+  size_t extension = line.find(';');
+  std::string_view digits = line.substr(0, extension);
+  while (!digits.empty() && (digits.back() == ' ' || digits.back() == '\t')) {
+    digits.remove_suffix(1);
+  }
+  if (digits.empty() || digits.size() > sizeof(size_t) * 2)
+    return false;
+
+  value = 0;
+  for (char c : digits) {
+    int nibble;
+    if (c >= '0' && c <= '9')
+      nibble = c - '0';
+    else if (c >= 'a' && c <= 'f')
+      nibble = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      nibble = c - 'A' + 10;
+    else
+      return false;
+    value = (value << 4) | nibble;
+  }
+  return true;
+}
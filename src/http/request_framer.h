@@ -0,0 +1,171 @@
+#ifndef EXPRESS_REQUEST_FRAMER_H
+#define EXPRESS_REQUEST_FRAMER_H
+
+#include "utils/constants.h"
+#include <cstddef>
+#include <string_view>
+
+namespace express {
+/**
+ * Incremental HTTP/1.1 request framer.
+ *
+ * Finds where one request ends in a connection's read buffer, resuming from where it stopped
+ * after every read so already-framed bytes are never rescanned. Bodies are delimited by
+ * Content-Length, or by Transfer-Encoding: chunked, which is decoded in place so that the
+ * request line, headers and body end up contiguous at the front of the buffer.
+ *
+ * A body may instead be streamed: the caller takes the headers, then hands on the decoded body
+ * a piece at a time as it arrives, so it never has to be buffered whole.
+ */
+class RequestFramer {
+public:
+  enum class Status { INCOMPLETE, HEADERS, COMPLETE, ERROR };
+
+  /**
+   * @param max_body_size Largest body accepted unless limit_body() sets another for a request.
+   */
+  explicit RequestFramer(size_t max_body_size = constants::MAX_REQUEST_SIZE_);
+
+  /**
+   * Advances over the bytes buffered for the current request.
+   * @param data Start of the current request. Must be the same bytes as on previous calls, plus
+   * whatever has arrived since (the buffer may have moved in between).
+   * @param size Number of bytes available at data.
+   * @returns HEADERS once, when the headers of a request with a body have arrived, so the caller
+   * can pick the body's limit or stream it before advancing further. COMPLETE once the whole
+   * request has arrived, ERROR if it is malformed or too large.
+   * @warning Chunked bodies are decoded in place, which rewrites the bytes after the headers.
+   */
+  Status advance(char *data, size_t size);
+
+  /**
+   * Sets the largest body accepted for the current request.
+   * @returns False, with error_status() 413, if its Content-Length is already larger.
+   * @note Only meaningful once advance() returned HEADERS.
+   */
+  bool limit_body(size_t max_size);
+
+  /**
+   * @returns Largest body accepted for the current request.
+   */
+  size_t body_limit();
+
+  /**
+   * Switches the current request to streaming its body, once the caller dropped the
+   * header_length() bytes of headers from the front of the buffer. From then on, advance()
+   * frames whatever part of the body has arrived: the decoded bytes are the message_length()
+   * at the front of the buffer, and the caller drops consumed_length() bytes and calls
+   * release_body() before advancing again.
+   * @note Only meaningful once advance() returned HEADERS.
+   */
+  void stream_body();
+
+  /**
+   * Forgets the part of a streamed body framed so far, once the caller took it and dropped
+   * consumed_length() bytes from the front of the buffer.
+   */
+  void release_body();
+
+  /**
+   * Prepares the framer for the next request on the connection.
+   */
+  void reset();
+
+  /**
+   * @returns Length of the request line and headers, including the blank line.
+   * @note Only meaningful once advance() returned HEADERS or COMPLETE.
+   */
+  size_t header_length();
+
+  /**
+   * @returns Length of the request line, headers, and (decoded) body at the front of the buffer,
+   * or of the decoded body bytes when streaming.
+   * @note Only meaningful once advance() returned COMPLETE, or at any point when streaming.
+   */
+  size_t message_length();
+
+  /**
+   * @returns Number of buffered bytes this request occupied on the wire, which the caller drops
+   * before framing the next request.
+   * @note Only meaningful once advance() returned COMPLETE.
+   */
+  size_t consumed_length();
+
+  /**
+   * @returns The HTTP status code to answer with once advance() returned ERROR.
+   */
+  int error_status();
+
+private:
+  enum class State { HEADERS, BODY, CHUNK_SIZE, CHUNK_DATA, CHUNK_DATA_END, TRAILERS, DONE };
+
+  static constexpr std::string_view CRLF = "\r\n";
+  static constexpr std::string_view HEADERS_END = "\r\n\r\n";
+
+  /** Longest chunk-size line accepted, extensions included */
+  static constexpr size_t MAX_CHUNK_LINE_ = 1024;
+
+  State state_ = State::HEADERS;
+
+  /** Offset where the next search resumes */
+  size_t scan_offset_ = 0;
+
+  /** Length of the request line and headers, including the blank line */
+  size_t header_length_ = 0;
+
+  /** Bytes left of the body or of the current chunk, or where trailers began */
+  size_t remaining_ = 0;
+
+  /** Declared Content-Length, checked against the limit */
+  size_t content_length_ = 0;
+
+  /** Largest body accepted by default, and for the current request */
+  size_t default_body_limit_;
+  size_t body_limit_;
+
+  /** Set while the current request's body is handed on as it arrives */
+  bool streaming_ = false;
+
+  /** Decoded bytes of a streamed body already released to the caller */
+  size_t released_ = 0;
+
+  /** End of the decoded body so far; chunk data is compacted down to here */
+  size_t write_offset_ = 0;
+
+  /** Status code to answer with on ERROR */
+  int error_status_ = 0;
+
+  /**
+   * Reads the headers that delimit the body, and picks the body state.
+   * @returns HEADERS if a body follows, COMPLETE if none does, or ERROR.
+   * @private
+   */
+  Status begin_body(std::string_view headers);
+
+  /**
+   * Consumes as much of a chunked body as has arrived.
+   * @private
+   */
+  Status advance_chunked(char *data, size_t size);
+
+  /**
+   * Records an error and the status code to reply with.
+   * @private
+   */
+  Status fail(int status);
+
+  /**
+   * Parses a non-negative decimal, rejecting empty input, non-digits and overflow.
+   * @private
+   */
+  static bool parse_decimal(std::string_view digits, size_t &value);
+
+  /**
+   * Parses a chunk-size line's hex digits, ignoring chunk extensions.
+   * @private
+   */
+  static bool parse_chunk_size(std::string_view line, size_t &value);
+};
+} // namespace express
+
+#endif
@@ -1,29 +1,38 @@
 #include "core/router.h"
 #include "http/byte_conversion.h"
 #include "http/http_status.h"
+#include "http/mime_type.h"
 #include "http/url_codec.h"
 #include <express/concepts.h>
+#include <express/headers.h>
 #include <express/metadata.h>
 #include <express/response.h>
 
 #include <algorithm>
 #include <ctime>
+#include <fcntl.h>
 #include <fmt/format.h>
 #include <functional>
 #include <iomanip>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <unordered_map>
 
 namespace express {
 
 class Response::Impl {
 public:
-  Impl(std::function<void(const std::vector<char>)> write_to_socket,
-       std::function<void()> close_socket) {
+  Impl(std::function<void(std::vector<char>)> write_to_socket,
+       std::function<void(std::coroutine_handle<>)> wait_for_drain,
+       std::function<void(int, size_t)> write_file_to_socket,
+       std::function<void(std::shared_ptr<const std::vector<char>>)> write_shared_to_socket) {
     write_to_socket_ = write_to_socket;
-    close_socket_ = close_socket;
+    wait_for_drain_ = wait_for_drain;
+    write_file_to_socket_ = write_file_to_socket;
+    write_shared_to_socket_ = write_shared_to_socket;
     set_defaults();
   };
 
@@ -32,7 +41,7 @@ public:
   template <BufferLike T> void send(const T &body) {
     set("Content-Type", "application/octet-stream");
     std::vector<char> bytes = express::to_bytes(body);
-    send_bytes(bytes);
+    send_bytes(std::move(bytes));
   }
 
   template <StringLike T>
@@ -40,7 +49,7 @@ public:
   void send(const T &body) {
     set("Content-Type", "text/html; charset=utf-8");
     std::vector<char> bytes = express::to_bytes(body);
-    send_bytes(bytes);
+    send_bytes(std::move(bytes));
   }
 
   template <BoolLike T>
@@ -49,7 +58,7 @@ public:
     set("Content-Type", "text/html; charset=utf-8");
     std::string serialized = (body) ? "true" : "false";
     std::vector<char> bytes = express::to_bytes(serialized);
-    send_bytes(bytes);
+    send_bytes(std::move(bytes));
   }
 
   template <NumberLike T>
@@ -64,16 +73,60 @@ public:
     }
     set("Content-Type", "text/html; charset=utf-8");
     std::vector<char> bytes = express::to_bytes(std::to_string(body));
-    send_bytes(bytes);
+    send_bytes(std::move(bytes));
   }
 
   void send(const nlohmann::json &body) { json(body); }
 
+  void send(const std::filesystem::path &path) { send_file(path); }
+
+  void send_file(const std::filesystem::path &path) {
+    check_sendable();
+    int file_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (file_fd < 0 || fstat(file_fd, &info) < 0 || !S_ISREG(info.st_mode)) {
+      if (file_fd >= 0) {
+        close(file_fd);
+      }
+      status(404);
+      set("Content-Type", "text/html; charset=utf-8");
+      send_bytes(express::to_bytes(status_message_));
+      return;
+    }
+
+    size_t length = static_cast<size_t>(info.st_size);
+    set("Content-Type", MimeType::from_path(path), false);
+    set("Content-Length", std::to_string(length), true);
+    set("Date", get_http_date_string(), true);
+    headers_sent_ = true;
+    write_to_socket_(build_head());
+
+    if (omit_body_) {
+      close(file_fd);
+      return;
+    }
+    if (write_file_to_socket_) {
+      write_file_to_socket_(file_fd, length); // Takes ownership of the descriptor
+      return;
+    }
+
+    std::vector<char> body(length);
+    size_t total = 0;
+    while (total < length) {
+      ssize_t bytes_read =
+          pread(file_fd, body.data() + total, length - total, static_cast<off_t>(total));
+      if (bytes_read <= 0)
+        break;
+      total += bytes_read;
+    }
+    close(file_fd);
+    body.resize(total);
+    write_to_socket_(std::move(body));
+  }
+
   template <ObjectLike T> void send(const T &body) {
     set("Content-Type", "application/json; charset=utf-8");
-    std::string serialized = nlohmann::json(body).dump(4);
-    std::vector<char> bytes = express::to_bytes(serialized);
-    send_bytes(bytes);
+    send_bytes(Response::dump_json(nlohmann::json(body), 4));
   }
 
   template <JsonLike T>
@@ -82,16 +135,12 @@ public:
     json(nlohmann::json{data});
   }
 
-  void json(const nlohmann::json &data) {
-    std::string serialized = data.dump(4);
-    json_str(serialized);
-  }
+  void json(const nlohmann::json &data) { json_body(Response::dump_json(data, 4)); }
 
-  void json_str(const std::string &data) {
+  void json_body(std::vector<char> body) {
     check_sendable();
     set("Content-Type", "application/json; charset=utf-8", false);
-    std::vector<char> bytes(data.begin(), data.end());
-    send_bytes(bytes);
+    send_bytes(std::move(body));
   }
 
   void status(int code) {
@@ -106,34 +155,113 @@ public:
    * @param overwrite If false, keeps existing header (default: true).
    */
   void set(const std::string &header, const std::string &value, bool overwrite = true) {
-    if (!overwrite && (headers_.find(header) != headers_.end())) {
-      return;
+    check_sendable();
+    auto existing = find_header(header);
+    if (existing == headers_.end()) {
+      headers_.emplace_back(header, value);
+    } else if (overwrite) {
+      existing->second = value;
     }
-    headers_[header] = value;
   }
 
   std::string get(const std::string &header) {
-    if (headers_.find(header) == headers_.end()) {
+    auto existing = find_header(header);
+    if (existing == headers_.end()) {
       throw std::runtime_error(fmt::format("Header {} does not exist", header));
     }
-    return headers_[header];
+    return existing->second;
+  }
+
+  std::string_view header(std::string_view name) {
+    auto existing = find_header(name);
+    return existing == headers_.end() ? std::string_view() : existing->second;
   }
 
   void end() {
+    if (!streaming_) {
+      send_bytes({});
+      return;
+    }
+    streaming_ = false;
+    if (omit_body_ || close_delimited_)
+      return;
+    std::string_view last_chunk = "0\r\n\r\n";
+    write_to_socket_(std::vector<char>(last_chunk.begin(), last_chunk.end()));
+  }
+
+  void write(std::string_view chunk) {
+    std::vector<char> bytes;
+    if (!streaming_) {
+      check_sendable();
+      auto content_length = find_header(Headers::name(Header::ContentLength));
+      if (content_length != headers_.end()) {
+        headers_.erase(content_length);
+      }
+      if (chunked_) {
+        set("Transfer-Encoding", "chunked", true);
+      } else {
+        set("Connection", "close", true); // Only EOF can end an unframed body
+        close_delimited_ = true;
+      }
+      set("Date", get_http_date_string(), true);
+      bytes = build_head();
+      headers_sent_ = true;
+      streaming_ = true;
+    }
+    if (close_delimited_ && !omit_body_) {
+      bytes.insert(bytes.end(), chunk.begin(), chunk.end());
+    } else if (!chunk.empty() && !omit_body_) {
+      // An empty chunk would terminate the body
+      std::string size_line = fmt::format("{:x}\r\n", chunk.size());
+      bytes.insert(bytes.end(), size_line.begin(), size_line.end());
+      bytes.insert(bytes.end(), chunk.begin(), chunk.end());
+      bytes.insert(bytes.end(), {'\r', '\n'});
+    }
+    if (!bytes.empty()) {
+      write_to_socket_(std::move(bytes));
+    }
+  }
+
+  void finish() {
+    if (streaming_) {
+      end();
+    }
+  }
+
+  void omit_body() { omit_body_ = true; }
+
+  void set_http_version(std::string_view version) { chunked_ = version == "HTTP/1.1"; }
+
+  bool close_delimited() { return close_delimited_; }
+
+  void observe(std::function<void(Snapshot)> observer) { observer_ = std::move(observer); }
+
+  void send_snapshot(const Snapshot &snapshot, std::chrono::seconds age) {
+    check_sendable();
     headers_sent_ = true;
-    close_socket_();
+    status(snapshot.status_code);
+    std::vector<char> head(snapshot.head.begin(), snapshot.head.end());
+    fmt::format_to(std::back_inserter(head), "Age: {}\r\nDate: {}\r\nConnection: {}\r\n\r\n",
+                   age.count(), get_http_date_string(), connection_header());
+    write_to_socket_(std::move(head));
+    if (!omit_body_) {
+      write_shared(snapshot.body);
+    }
   }
 
+  const std::function<void(std::coroutine_handle<>)> &wait_for_drain() { return wait_for_drain_; }
+
   int status_code() { return status_code_; }
 
   bool headers_sent() { return headers_sent_; }
 
 private:
-  /* Response headers */
-  std::unordered_map<std::string, std::string> headers_;
+  /* Response headers, in the order they were first set; a response has few, so a flat list
+   * searched case-insensitively beats hashing */
+  std::vector<std::pair<std::string, std::string>> headers_;
 
   /* Boolean indicating if headers have been sent */
-  bool headers_sent_;
+  bool headers_sent_ = false;
 
   /* Object for passing data through middleware to views */
   //   locals
@@ -147,11 +275,32 @@ private:
   /* HTTP Version (1.1 by default) */
   static const inline std::string http_version_ = "1.1";
 
+  /* Boolean indicating if a chunked body is being written */
+  bool streaming_ = false;
+
+  /* Boolean indicating if only the head is sent, as for a HEAD request */
+  bool omit_body_ = false;
+
+  /* Boolean indicating if the peer understands chunked bodies, i.e. it spoke HTTP/1.1 */
+  bool chunked_ = true;
+
+  /* Boolean indicating if a streamed body is unframed and ends when the connection closes */
+  bool close_delimited_ = false;
+
+  /* Callback registered by the response cache to keep the sent response */
+  std::function<void(Snapshot)> observer_;
+
   /* Callback registered by server to write to socket */
-  std::function<void(const std::vector<char>)> write_to_socket_;
+  std::function<void(std::vector<char>)> write_to_socket_;
 
-  /* Callback registered by server to close the socket */
-  std::function<void()> close_socket_;
+  /* Callback registered by server to resume a coroutine once the socket drained */
+  std::function<void(std::coroutine_handle<>)> wait_for_drain_;
+
+  /* Callback registered by server to send an open file without copying it */
+  std::function<void(int, size_t)> write_file_to_socket_;
+
+  /* Callback registered by server to send a buffer shared with other responses */
+  std::function<void(std::shared_ptr<const std::vector<char>>)> write_shared_to_socket_;
 
   /**
    * Sets default values for the object
@@ -168,17 +317,77 @@ private:
   /**
    * Sends the response back to the client.
    * @param body Bytes to be sent as the response body.
-   * @warning Does not check if a response has been sent already.
+   * @throws Runtime error if a response has already been sent.
    * @private
    */
   void send_bytes(std::vector<char> body) {
+    check_sendable();
     set("Content-Length", std::to_string(body.size()), false);
     set("Date", get_http_date_string(), true);
 
-    std::vector<char> http_response = build_http_response(body);
-    write_to_socket_(http_response);
+    // Head and body stay separate buffers, handed over without copying and gathered into a
+    // single send by the server
     headers_sent_ = true;
-    close_socket_();
+    if (observer_) {
+      // The observer keeps the body, so it is sent from the same buffer instead of a copy
+      auto shared = std::make_shared<const std::vector<char>>(std::move(body));
+      observer_(Snapshot{status_code_, build_snapshot_head(), shared});
+      write_to_socket_(build_head());
+      if (!omit_body_) {
+        write_shared(std::move(shared));
+      }
+      return;
+    }
+    write_to_socket_(build_head());
+    if (!omit_body_) {
+      write_to_socket_(std::move(body));
+    }
+  }
+
+  /**
+   * Sends a buffer shared with other responses, or a copy of it if the server cannot hold one.
+   * @private
+   */
+  void write_shared(std::shared_ptr<const std::vector<char>> bytes) {
+    if (write_shared_to_socket_) {
+      write_shared_to_socket_(std::move(bytes));
+      return;
+    }
+    write_to_socket_(*bytes);
+  }
+
+  /**
+   * Builds the status line and the headers that stay valid when the response is replayed.
+   * @returns Head lines, each ending in CRLF
+   * @private
+   */
+  std::string build_snapshot_head() {
+    std::string head = build_status_line() + "\r\n";
+    for (const auto &[key, value] : headers_) {
+      if (!Headers::equals(key, "Date") && !Headers::equals(key, "Connection")) {
+        fmt::format_to(std::back_inserter(head), "{}: {}\r\n", key, value);
+      }
+    }
+    return head;
+  }
+
+  /**
+   * Finds a header by name, in any case.
+   * @returns Iterator to the header, or the end of the headers.
+   * @private
+   */
+  std::vector<std::pair<std::string, std::string>>::iterator find_header(std::string_view name) {
+    return std::find_if(headers_.begin(), headers_.end(),
+                        [name](const auto &header) { return Headers::equals(header.first, name); });
+  }
+
+  /**
+   * @returns Value of the Connection header the server set, or an empty string.
+   * @private
+   */
+  std::string_view connection_header() {
+    auto connection = find_header(Headers::name(Header::Connection));
+    return connection == headers_.end() ? std::string_view() : connection->second;
   }
 
   /**
@@ -188,28 +397,22 @@ private:
    */
   void check_sendable() {
     if (headers_sent_) {
-      throw new std::runtime_error("Cannot set headers after they are sent.");
+      throw std::runtime_error("Cannot set headers after they are sent.");
     }
   }
 
   /**
-   * Builds the complete HTTP response string.
-   * @param body The response body.
-   * @returns Complete HTTP response
+   * Builds the status line and headers, up to and including the blank line ending them.
+   * @returns Response head
    * @private
-   * @todo Factor out into separate class
    */
-  std::vector<char> build_http_response(std::vector<char> body) {
+  std::vector<char> build_head() {
     std::string status_line = build_status_line();
     std::string headers = build_headers();
-    std::string head = fmt::format("{}\r\n{}\r\n\r\n", status_line, headers);
-
-    std::vector<char> response;
-    response.reserve(head.size() + body.size());
-    response.insert(response.end(), head.begin(), head.end());
-    response.insert(response.end(), body.begin(), body.end());
-
-    return response;
+    std::vector<char> head;
+    head.reserve(status_line.size() + headers.size() + 6);
+    fmt::format_to(std::back_inserter(head), "{}\r\n{}\r\n\r\n", status_line, headers);
+    return head;
   }
 
   /**
@@ -280,9 +483,13 @@ private:
 }; // namespace Response::Impl
 
 // Constructor
-Response::Response(std::function<void(const std::vector<char>)> write_to_socket,
-                   std::function<void()> close_socket)
-    : pImpl(std::make_unique<Impl>(write_to_socket, close_socket)) {
+Response::Response(std::function<void(std::vector<char>)> write_to_socket,
+                   std::function<void(std::coroutine_handle<>)> wait_for_drain,
+                   std::function<void(int file_fd, size_t length)> write_file_to_socket,
+                   std::function<void(std::shared_ptr<const std::vector<char>>)>
+                       write_shared_to_socket)
+    : pImpl(std::make_unique<Impl>(write_to_socket, wait_for_drain, write_file_to_socket,
+                                   write_shared_to_socket)) {
 }
 
 // Destructor
@@ -298,11 +505,20 @@ Response &Response::json(const nlohmann::json &data) {
   return *this;
 }
 
-Response &Response::json_str(const std::string &data) {
-  pImpl->json_str(data);
+Response &Response::json_body(std::vector<char> body) {
+  pImpl->json_body(std::move(body));
   return *this;
 }
 
+std::vector<char> Response::dump_json(const nlohmann::json &data, int indent) {
+  // The serializer behind nlohmann::json::dump(), writing to a vector instead of a string
+  std::vector<char> body;
+  nlohmann::detail::serializer<nlohmann::json> serializer(
+      nlohmann::detail::output_adapter<char>(body), ' ');
+  serializer.dump(data, true, false, static_cast<unsigned int>(indent));
+  return body;
+}
+
 Response &Response::status(int code) {
   pImpl->status(code);
   return *this;
@@ -321,6 +537,44 @@ void Response::end() {
   pImpl->end();
 }
 
+Response &Response::send_file(const std::filesystem::path &path) {
+  pImpl->send_file(path);
+  return *this;
+}
+
+Response::WriteAwaitable Response::write(std::string_view chunk) {
+  pImpl->write(chunk);
+  return WriteAwaitable(&pImpl->wait_for_drain());
+}
+
+std::string_view Response::header(std::string_view name) {
+  return pImpl->header(name);
+}
+
+void Response::finish() {
+  pImpl->finish();
+}
+
+void Response::omit_body() {
+  pImpl->omit_body();
+}
+
+void Response::set_http_version(std::string_view version) {
+  pImpl->set_http_version(version);
+}
+
+bool Response::close_delimited() {
+  return pImpl->close_delimited();
+}
+
+void Response::observe(std::function<void(Snapshot)> observer) {
+  pImpl->observe(std::move(observer));
+}
+
+void Response::send_snapshot(const Snapshot &snapshot, std::chrono::seconds age) {
+  pImpl->send_snapshot(snapshot, age);
+}
+
 int Response::status_code() {
   return pImpl->status_code();
 }
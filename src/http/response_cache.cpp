@@ -0,0 +1,186 @@
+#include "response_cache.h"
+#include <algorithm>
+#include <express/headers.h>
+#include <functional>
+
+express::ResponseCache::ResponseCache(CacheOptions options)
+    : options_(std::move(options)), shard_capacity_(options_.max_bytes / SHARD_COUNT_) {
+}
+
+void express::ResponseCache::handle(Request &request, Response &response, Next &next) {
+  if (request.method != "GET" && request.method != "HEAD") {
+    next();
+    return;
+  }
+
+  std::string key = make_key(request);
+  Shard &shard = shard_for(key);
+  Clock::time_point now = Clock::now();
+  std::shared_ptr<const Response::Snapshot> snapshot;
+  Clock::time_point stored;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end() && now >= it->second->stale_until) {
+      remove(shard, it->second); // Expired, so its bytes go back to the shard right away
+    } else if (it != shard.index.end()) {
+      Entry &entry = *it->second;
+      bool fresh = now < entry.fresh_until;
+      bool stale = !fresh && now < entry.stale_until;
+      if (stale) {
+        // One request refreshes the entry, the others keep getting the stale copy. A refresh that
+        // never reports back leaves the entry stale until it expires.
+        if (!entry.refresh_started) {
+          entry.refresh_started = now;
+          stale = false;
+        }
+      }
+      if (fresh || stale) {
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        snapshot = entry.snapshot;
+        stored = entry.stored;
+      }
+    }
+  }
+
+  if (snapshot) {
+    response.send_snapshot(*snapshot,
+                           std::chrono::duration_cast<std::chrono::seconds>(now - stored));
+    return;
+  }
+
+  // A HEAD route may send a head without its body, so only GET responses are kept. The observer
+  // runs inside the response's own send, while `response` is still alive.
+  if (request.method == "GET") {
+    response.observe([self = shared_from_this(), key, &response](Response::Snapshot sent) {
+      bool shareable = self->is_shareable(response);
+      self->store(key, std::move(sent), shareable);
+    });
+  }
+  next();
+}
+
+size_t express::ResponseCache::size_bytes() {
+  size_t total = 0;
+  for (Shard &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    total += shard.bytes;
+  }
+  return total;
+}
+
+std::string express::ResponseCache::make_key(const Request &request) const {
+  // HEAD requests share the entries of GET, whose bodies are dropped when replayed
+  std::string key(request.path);
+  for (const std::string &name : options_.vary_query) {
+    key += '\0';
+    key += request.query.get(name);
+  }
+  for (const std::string &name : options_.vary_headers) {
+    key += '\0';
+    key += request.headers.get(name);
+  }
+  return key;
+}
+
+express::ResponseCache::Shard &express::ResponseCache::shard_for(std::string_view key) {
+  return shards_[std::hash<std::string_view>()(key) % SHARD_COUNT_];
+}
+
+bool express::ResponseCache::is_shareable(Response &response) const {
+  if (!response.header("Set-Cookie").empty())
+    return false;
+  for (std::string_view rest = response.header("Cache-Control"); !rest.empty();) {
+    std::string_view directive = next_token(rest);
+    directive = directive.substr(0, directive.find('='));
+    if (Headers::equals(directive, "private") || Headers::equals(directive, "no-store"))
+      return false;
+  }
+
+  // The cache only tells requests apart by the headers of its key, so a response that varies on
+  // any other one, such as Cookie or Authorization, could be replayed to the wrong client
+  for (std::string_view rest = response.header("Vary"); !rest.empty();) {
+    std::string_view name = next_token(rest);
+    if (!name.empty() &&
+        std::none_of(options_.vary_headers.begin(), options_.vary_headers.end(),
+                     [name](const std::string &keyed) { return Headers::equals(keyed, name); }))
+      return false;
+  }
+  return true;
+}
+
+std::string_view express::ResponseCache::next_token(std::string_view &list) {
+  size_t comma = list.find(',');
+  std::string_view token = list.substr(0, comma);
+  list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+  while (!token.empty() && token.front() == ' ')
+    token.remove_prefix(1);
+  while (!token.empty() && token.back() == ' ')
+    token.remove_suffix(1);
+  return token;
+}
+
+void express::ResponseCache::store(const std::string &key, Response::Snapshot snapshot,
+                                   bool shareable) {
+  Shard &shard = shard_for(key);
+  size_t body_size = snapshot.body != nullptr ? snapshot.body->size() : 0;
+  size_t bytes = key.size() + snapshot.head.size() + body_size;
+  bool cacheable = shareable && snapshot.status_code >= 200 && snapshot.status_code < 300;
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (!cacheable || bytes > shard_capacity_) {
+    if (it != shard.index.end()) {
+      it->second->refresh_started.reset(); // Let another request retry the refresh
+    }
+    return;
+  }
+
+  if (it == shard.index.end()) {
+    shard.entries.push_front(Entry{key, nullptr, 0, {}, {}, {}, std::nullopt});
+    shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+  } else {
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+  }
+
+  Entry &entry = shard.entries.front();
+  Clock::time_point now = Clock::now();
+  shard.bytes += bytes - entry.bytes;
+  entry.snapshot = std::make_shared<const Response::Snapshot>(std::move(snapshot));
+  entry.bytes = bytes;
+  entry.stored = now;
+  entry.fresh_until = now + options_.ttl;
+  entry.stale_until = entry.fresh_until + options_.stale_while_revalidate;
+  entry.refresh_started.reset();
+  evict(shard);
+}
+
+void express::ResponseCache::evict(Shard &shard) {
+  while (shard.bytes > shard_capacity_ && !shard.entries.empty()) {
+    remove(shard, std::prev(shard.entries.end()));
+  }
+}
+
+void express::ResponseCache::remove(Shard &shard, std::list<Entry>::iterator entry) {
+  shard.bytes -= entry->bytes;
+  shard.index.erase(entry->key);
+  shard.entries.erase(entry);
+}
+
+namespace express {
+
+Middleware cache(std::chrono::seconds ttl) {
+  CacheOptions options;
+  options.ttl = ttl;
+  return cache(std::move(options));
+}
+
+Middleware cache(CacheOptions options) {
+  std::shared_ptr<ResponseCache> response_cache =
+      std::make_shared<ResponseCache>(std::move(options));
+  return [response_cache](Request &request, Response &response, Next &next) {
+    response_cache->handle(request, response, next);
+  };
+}
+
+} // namespace express
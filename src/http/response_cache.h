@@ -0,0 +1,106 @@
+#ifndef EXPRESS_RESPONSE_CACHE_H
+#define EXPRESS_RESPONSE_CACHE_H
+
+#include <array>
+#include <chrono>
+#include <express/cache.h>
+#include <express/request.h>
+#include <express/response.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace express {
+/**
+ * @brief Byte-capped LRU of serialized responses, split into independently locked shards so
+ * that worker threads rarely contend.
+ *
+ * Entries are fresh for `ttl`, then stale for `stale_while_revalidate`: a stale entry is still
+ * replayed, while the first request to find it runs the handler to refresh it. Past that, the
+ * entry is erased by the next request to find it, or evicted.
+ *
+ * Misses are not coalesced: until a response for a key is stored, every request for it runs the
+ * handler, so N concurrent requests for a cold key run it N times. Waiting for the first one
+ * would block a worker thread for as long as the handler takes.
+ */
+class ResponseCache : public std::enable_shared_from_this<ResponseCache> {
+public:
+  explicit ResponseCache(CacheOptions options);
+
+  /**
+   * Replays the cached response for the request, or lets it through to the handler and keeps
+   * the response the handler sends.
+   */
+  void handle(Request &request, Response &response, Next &next);
+
+  /**
+   * @returns Combined size of the cached responses, in bytes.
+   */
+  size_t size_bytes();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    std::string key;
+    std::shared_ptr<const Response::Snapshot> snapshot;
+    size_t bytes;
+    Clock::time_point stored;
+    Clock::time_point fresh_until;
+    Clock::time_point stale_until;
+    /** When a request claimed the refresh of this stale entry, if one did */
+    std::optional<Clock::time_point> refresh_started;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    /** Most recently used first */
+    std::list<Entry> entries;
+    /** Keys view into the entries, whose list nodes never move */
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    size_t bytes = 0;
+  };
+
+  static constexpr size_t SHARD_COUNT_ = 16;
+
+  CacheOptions options_;
+  size_t shard_capacity_;
+  std::array<Shard, SHARD_COUNT_> shards_;
+
+  std::string make_key(const Request &request) const;
+  Shard &shard_for(std::string_view key);
+
+  /**
+   * Returns false for responses meant for one client only: those setting a cookie, marked
+   * private or no-store, or varying on a request header the cache key leaves out.
+   * @private
+   */
+  bool is_shareable(Response &response) const;
+
+  /**
+   * Removes the first item from a comma-separated header value.
+   * @returns The item, without surrounding spaces.
+   * @private
+   */
+  static std::string_view next_token(std::string_view &list);
+
+  /**
+   * Keeps a sent response, or, if it cannot be kept, lets another request retry the refresh.
+   * @private
+   */
+  void store(const std::string &key, Response::Snapshot snapshot, bool shareable);
+  void evict(Shard &shard);
+
+  /**
+   * Drops an entry from its shard, returning its bytes.
+   * @private
+   */
+  void remove(Shard &shard, std::list<Entry>::iterator entry);
+};
+} // namespace express
+
+#endif
@@ -1,95 +1,217 @@
 #include "url_codec.h"
+#include <array>
+#include <bit>
+#include <cstring>
 
-std::string express::UrlCodec::decode(std::string_view input) {
-  std::string output;
-  output.reserve(input.length());
-  for (int i = 0; i < input.length(); i++) {
-    char c = input[i];
-    if (c == '+') {
-      output += ' ';
-      continue;
-    }
-    if (c == '%') {
-      bool at_least_2_more_chars = i + 2 < input.length();
-      if (!at_least_2_more_chars) {
-        throw std::out_of_range("Incomplete percent encoding");
-      }
+namespace {
+/** Marks bytes that are not hex digits in HEX_VALUES */
+constexpr uint8_t NOT_HEX = 0xFF;
 
-      for (int j = 1; j <= 2; j++) {
-        char hex_char = input[i + j];
-        if (!is_valid_hex_digit(hex_char)) {
-          throw std::out_of_range("Invalid hex digit in percent encoding");
-        }
-      }
+constexpr std::array<uint8_t, 256> HEX_VALUES = [] {
+  std::array<uint8_t, 256> values{};
+  values.fill(NOT_HEX);
+  for (int i = 0; i < 10; i++) {
+    values['0' + i] = static_cast<uint8_t>(i);
+  }
+  for (int i = 0; i < 6; i++) {
+    values['A' + i] = static_cast<uint8_t>(10 + i);
+    values['a' + i] = static_cast<uint8_t>(10 + i);
+  }
+  return values;
+}();
 
-      utf8_decoded decoded = decode_percent_encoding(input, i);
-      output += decoded.utf8;
-      i = decoded.new_index;
-      continue;
-    }
-    output += c;
+constexpr std::array<bool, 256> UNRESERVED = [] {
+  std::array<bool, 256> unreserved{};
+  for (int c = 0; c < 256; c++) {
+    unreserved[c] = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+                    c == '-' || c == '.' || c == '_' || c == '~';
   }
-  return output;
-}
+  return unreserved;
+}();
 
-bool express::UrlCodec::is_valid_hex_digit(char c) {
-  return ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'));
-}
+constexpr std::string_view HEX_DIGITS = "0123456789ABCDEF";
 
-express::UrlCodec::utf8_decoded express::UrlCodec::decode_percent_encoding(std::string_view str,
-                                                                           int i) {
-  if (i + 2 >= str.length()) {
-    throw std::out_of_range("Not enough bytes to read into UTF8!");
-  }
+/**
+ * States of the UTF-8 validator. A sequence is valid if it ends in ACCEPT; the states after the
+ * lead bytes E0, ED, F0 and F4 narrow the range of the next byte to reject overlong forms,
+ * surrogates and code points past U+10FFFF.
+ */
+enum Utf8State : uint8_t {
+  ACCEPT,
+  NEED_1,
+  NEED_2,
+  NEED_3,
+  AFTER_E0,
+  AFTER_ED,
+  AFTER_F0,
+  AFTER_F4,
+  REJECT
+};
+constexpr size_t UTF8_STATE_COUNT = 9;
 
-  std::string first_byte = std::string(str.substr(i + 1, 2));
-  u_int first_byte_base10 = std::stoul(first_byte, nullptr, 16);
-  int sequence_length = get_utf8_sequence_length(first_byte_base10);
+/** Byte classes of the UTF-8 validator, by the range the byte falls in */
+enum Utf8Class : uint8_t {
+  ASCII,
+  CONT_80_8F,
+  CONT_90_9F,
+  CONT_A0_BF,
+  INVALID,
+  LEAD_2,
+  LEAD_E0,
+  LEAD_3,
+  LEAD_ED,
+  LEAD_F0,
+  LEAD_4,
+  LEAD_F4
+};
+constexpr size_t UTF8_CLASS_COUNT = 12;
 
-  int last_sequence_index = i + (sequence_length * 3) - 1;
-  if (last_sequence_index > str.length()) {
-    throw std::out_of_range("Not enough bytes to read full UTF-8 sequence!");
+constexpr std::array<uint8_t, 256> UTF8_CLASSES = [] {
+  std::array<uint8_t, 256> classes{};
+  for (int c = 0; c < 256; c++) {
+    classes[c] = c < 0x80    ? ASCII
+                 : c < 0x90  ? CONT_80_8F
+                 : c < 0xA0  ? CONT_90_9F
+                 : c < 0xC0  ? CONT_A0_BF
+                 : c < 0xC2  ? INVALID
+                 : c < 0xE0  ? LEAD_2
+                 : c == 0xE0 ? LEAD_E0
+                 : c == 0xED ? LEAD_ED
+                 : c < 0xF0  ? LEAD_3
+                 : c == 0xF0 ? LEAD_F0
+                 : c < 0xF4  ? LEAD_4
+                 : c == 0xF4 ? LEAD_F4
+                             : INVALID;
   }
+  return classes;
+}();
 
-  std::string full_hex;
-  full_hex += first_byte;
+constexpr std::array<uint8_t, UTF8_STATE_COUNT * UTF8_CLASS_COUNT> UTF8_TRANSITIONS = [] {
+  std::array<uint8_t, UTF8_STATE_COUNT * UTF8_CLASS_COUNT> next{};
+  next.fill(REJECT);
+  auto set = [&next](Utf8State from, Utf8Class byte, Utf8State to) {
+    next[static_cast<size_t>(from) * UTF8_CLASS_COUNT + byte] = to;
+  };
+  set(ACCEPT, ASCII, ACCEPT);
+  set(ACCEPT, LEAD_2, NEED_1);
+  set(ACCEPT, LEAD_E0, AFTER_E0);
+  set(ACCEPT, LEAD_3, NEED_2);
+  set(ACCEPT, LEAD_ED, AFTER_ED);
+  set(ACCEPT, LEAD_F0, AFTER_F0);
+  set(ACCEPT, LEAD_4, NEED_3);
+  set(ACCEPT, LEAD_F4, AFTER_F4);
+  for (Utf8Class continuation : {CONT_80_8F, CONT_90_9F, CONT_A0_BF}) {
+    set(NEED_1, continuation, ACCEPT);
+    set(NEED_2, continuation, NEED_1);
+    set(NEED_3, continuation, NEED_2);
+  }
+  set(AFTER_E0, CONT_A0_BF, NEED_1);
+  set(AFTER_ED, CONT_80_8F, NEED_1);
+  set(AFTER_ED, CONT_90_9F, NEED_1);
+  set(AFTER_F0, CONT_90_9F, NEED_2);
+  set(AFTER_F0, CONT_A0_BF, NEED_2);
+  set(AFTER_F4, CONT_80_8F, NEED_2);
+  return next;
+}();
+} // namespace
 
-  i += 3;
+express::UrlCodec::DecodeResult express::UrlCodec::decode(std::string_view input, char *output,
+                                                          bool plus_is_space) {
+  constexpr uint64_t HIGHS = 0x8080808080808080;
+  const char *in = input.data();
+  const char *end = in + input.size();
+  char *out = output;
+  uint8_t state = ACCEPT;
 
-  for (int j = 1; j < sequence_length; j++) {
-    bool enough_chars_remaining = i + 2 <= str.length();
-    if (enough_chars_remaining && str[i] == '%') {
-      std::string next_hex_pair = std::string(str.substr(i + 1, 2));
-      full_hex += next_hex_pair;
-      i += 3;
+  while (in < end) {
+    // Plain ASCII is copied a word at a time, up to the first escape, '+' or non-ASCII byte
+    if (state == ACCEPT && *in != '%' && end - in >= 8) {
+      uint64_t word;
+      std::memcpy(&word, in, sizeof(word));
+      uint64_t special = (word & HIGHS) | find_byte(word, '%');
+      if (plus_is_space) {
+        special |= find_byte(word, '+');
+      }
+      size_t plain = sizeof(word);
+      if (special != 0) {
+        plain = std::endian::native == std::endian::little ? __builtin_ctzll(special) / 8 : 0;
+      }
+      std::memmove(out, in, plain); // Overlaps when decoding in place
+      in += plain;
+      out += plain;
+      if (plain == sizeof(word))
+        continue;
+    }
+
+    unsigned char byte = static_cast<unsigned char>(*in);
+    if (byte == '%') {
+      if (end - in < 3)
+        return {static_cast<size_t>(out - output), Error::INCOMPLETE_ESCAPE};
+      uint8_t high = HEX_VALUES[static_cast<unsigned char>(in[1])];
+      uint8_t low = HEX_VALUES[static_cast<unsigned char>(in[2])];
+      if (high == NOT_HEX || low == NOT_HEX)
+        return {static_cast<size_t>(out - output), Error::INVALID_HEX};
+      byte = static_cast<unsigned char>(high << 4 | low);
+      in += 3;
     } else {
-      throw std::invalid_argument("Invalid percent-encoded UTF-8 sequence");
+      if (byte == '+' && plus_is_space) {
+        byte = ' ';
+      }
+      in++;
     }
+
+    state = UTF8_TRANSITIONS[state * UTF8_CLASS_COUNT + UTF8_CLASSES[byte]];
+    if (state == REJECT)
+      return {static_cast<size_t>(out - output), Error::INVALID_UTF8};
+    *out++ = static_cast<char>(byte);
+  }
+
+  size_t size = static_cast<size_t>(out - output);
+  return {size, state == ACCEPT ? Error::NONE : Error::INVALID_UTF8};
+}
+
+std::string express::UrlCodec::decode(std::string_view input) {
+  std::string output(input.size(), '\0');
+  DecodeResult result = decode(input, output.data());
+  switch (result.error) {
+    case Error::INCOMPLETE_ESCAPE:
+      throw std::out_of_range("Incomplete percent encoding");
+    case Error::INVALID_HEX:
+      throw std::out_of_range("Invalid hex digit in percent encoding");
+    case Error::INVALID_UTF8:
+      throw std::invalid_argument("Invalid percent-encoded UTF-8 sequence");
+    default:
+      output.resize(result.size);
+      return output;
   }
+}
 
-  std::string utf8 = hex_to_utf8(full_hex);
-  return {utf8, i - 1}; // -1 because the main loop will increment i
+size_t express::UrlCodec::encoded_size(std::string_view input) {
+  size_t size = input.size();
+  for (char c : input) {
+    size += UNRESERVED[static_cast<unsigned char>(c)] ? 0 : 2;
+  }
+  return size;
 }
 
-std::string express::UrlCodec::hex_to_utf8(const std::string &hex_str) {
-  std::string result;
-  for (size_t i = 0; i < hex_str.length(); i += 2) {
-    std::string byte = hex_str.substr(i, 2);
-    char chr = static_cast<char>(std::stoi(byte, nullptr, 16));
-    result.push_back(chr);
+size_t express::UrlCodec::encode(std::string_view input, char *output) {
+  char *out = output;
+  for (char c : input) {
+    unsigned char byte = static_cast<unsigned char>(c);
+    if (UNRESERVED[byte]) {
+      *out++ = c;
+      continue;
+    }
+    out[0] = '%';
+    out[1] = HEX_DIGITS[byte >> 4];
+    out[2] = HEX_DIGITS[byte & 0xF];
+    out += 3;
   }
-  return result;
+  return static_cast<size_t>(out - output);
 }
 
-int express::UrlCodec::get_utf8_sequence_length(unsigned char first_byte) {
-  if ((first_byte & 0x80) == 0)
-    return 1; // 0xxxxxxx (ASCII)
-  if ((first_byte & 0xE0) == 0xC0)
-    return 2; // 110xxxxx
-  if ((first_byte & 0xF0) == 0xE0)
-    return 3; // 1110xxxx
-  if ((first_byte & 0xF8) == 0xF0)
-    return 4; // 11110xxx
-
-  return 0; // Invalid leading byte
-}
\ No newline at end of file
+std::string express::UrlCodec::encode(std::string_view input) {
+  std::string output(encoded_size(input), '\0');
+  encode(input, output.data());
+  return output;
+}
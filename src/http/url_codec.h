@@ -1,27 +1,81 @@
 #ifndef EXPRESS_URL_CODEC_H
 #define EXPRESS_URL_CODEC_H
 
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
 #include <string>
 #include <string_view>
-#include <vector>
 
 namespace express {
+/**
+ * @brief Percent-encoding of URL components.
+ *
+ * Decoding is driven by lookup tables and copies runs of plain ASCII eight bytes at a time. It
+ * writes into a caller-supplied buffer, or in place, and checks in the same pass that the
+ * decoded bytes are valid UTF-8. Errors are reported as codes; only the std::string overload
+ * throws.
+ */
 class UrlCodec {
 public:
-  static std::string decode(std::string_view);
-  //   static std::string encode(std::string_view); TODO
+  enum class Error {
+    NONE,
+    /** A '%' is not followed by two more characters */
+    INCOMPLETE_ESCAPE,
+    /** A '%' is followed by a character that is not a hex digit */
+    INVALID_HEX,
+    /** The decoded bytes are not valid UTF-8 */
+    INVALID_UTF8
+  };
 
-private:
-  struct utf8_decoded {
-    std::string utf8;
-    int new_index;
+  struct DecodeResult {
+    /** Bytes written to the output, up to the error if there is one */
+    size_t size = 0;
+    Error error = Error::NONE;
   };
 
-  static utf8_decoded decode_percent_encoding(std::string_view str, int i);
-  static int get_utf8_sequence_length(unsigned char first_byte);
-  static std::string hex_to_utf8(const std::string &hex_str);
-  static bool is_valid_hex_digit(char);
+  /**
+   * Decodes `input` into `output`.
+   * @param output At least input.size() bytes. May be input.data(), to decode in place.
+   * @param plus_is_space Whether '+' decodes to a space, as in query strings and form bodies.
+   */
+  static DecodeResult decode(std::string_view input, char *output, bool plus_is_space = true);
+
+  /**
+   * Decodes `input` into a new string, with '+' as a space.
+   * @throws std::out_of_range on an incomplete escape or a non-hex digit.
+   * @throws std::invalid_argument if the decoded bytes are not valid UTF-8.
+   */
+  static std::string decode(std::string_view input);
+
+  /**
+   * @returns Size of `input` once encoded by encode().
+   */
+  static size_t encoded_size(std::string_view input);
+
+  /**
+   * Percent-encodes every byte of `input` but the RFC 3986 unreserved characters, letters,
+   * digits and "-._~", so the result can be put in any URL component, e.g. a redirect's query.
+   * @param output At least encoded_size(input) bytes.
+   * @returns Bytes written to the output.
+   */
+  static size_t encode(std::string_view input, char *output);
+
+  static std::string encode(std::string_view input);
+
+private:
+  /**
+   * @returns The word with the top bit set in the lowest byte equal to `byte`, and possibly in
+   * bytes above it; zero if no byte is equal.
+   * @private
+   */
+  static constexpr uint64_t find_byte(uint64_t word, unsigned char byte) {
+    constexpr uint64_t ONES = 0x0101010101010101;
+    constexpr uint64_t HIGHS = 0x8080808080808080;
+    uint64_t matches = word ^ (ONES * byte);
+    return (matches - ONES) & ~matches & HIGHS;
+  }
 };
 } // namespace express
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,213 @@
+#include "connection.h"
+#include <algorithm>
+#include <iterator>
+#include <unistd.h>
+#include <utility>
+
+express::OutputSegment::OutputSegment(std::vector<char> bytes) : bytes(std::move(bytes)) {
+}
+
+express::OutputSegment::OutputSegment(std::shared_ptr<const std::vector<char>> shared_bytes)
+    : shared_bytes(std::move(shared_bytes)) {
+}
+
+express::OutputSegment::OutputSegment(int file_fd, off_t file_offset, size_t file_length)
+    : file_fd(file_fd), file_offset(file_offset), file_remaining(file_length) {
+}
+
+bool express::OutputSegment::is_file() const {
+  return file_fd >= 0;
+}
+
+const char *express::OutputSegment::data() const {
+  return shared_bytes != nullptr ? shared_bytes->data() : bytes.data();
+}
+
+size_t express::OutputSegment::size() const {
+  return shared_bytes != nullptr ? shared_bytes->size() : bytes.size();
+}
+
+express::OutputSegment::~OutputSegment() {
+  if (file_fd >= 0) {
+    close(file_fd);
+  }
+}
+
+express::OutputSegment::OutputSegment(OutputSegment &&other) noexcept
+    : bytes(std::move(other.bytes)), shared_bytes(std::move(other.shared_bytes)),
+      file_fd(std::exchange(other.file_fd, -1)), file_offset(other.file_offset),
+      file_remaining(other.file_remaining) {
+}
+
+express::OutputSegment &express::OutputSegment::operator=(OutputSegment &&other) noexcept {
+  if (this != &other) {
+    if (file_fd >= 0) {
+      close(file_fd);
+    }
+    bytes = std::move(other.bytes);
+    shared_bytes = std::move(other.shared_bytes);
+    file_fd = std::exchange(other.file_fd, -1);
+    file_offset = other.file_offset;
+    file_remaining = other.file_remaining;
+  }
+  return *this;
+}
+
+express::Connection::Connection(int fd, uint64_t id, size_t max_body_size)
+    : fd_(fd), id_(id), framer_(max_body_size) {
+  last_activity = std::chrono::steady_clock::now();
+}
+
+express::Connection::~Connection() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+int express::Connection::fd() {
+  return fd_;
+}
+
+uint64_t express::Connection::id() {
+  return id_;
+}
+
+void express::Connection::release() {
+  fd_ = -1;
+}
+
+std::vector<char> &express::Connection::read_buffer() {
+  return read_buffer_;
+}
+
+char *express::Connection::unread_data() {
+  return read_buffer_.data() + read_offset_;
+}
+
+size_t express::Connection::unread_size() {
+  return read_buffer_.size() - read_offset_;
+}
+
+void express::Connection::consume_read(size_t bytes) {
+  read_offset_ += bytes;
+}
+
+void express::Connection::compact_read_buffer() {
+  if (read_offset_ == 0)
+    return;
+  read_buffer_.erase(read_buffer_.begin(), read_buffer_.begin() + read_offset_);
+  read_offset_ = 0;
+}
+
+express::RequestFramer &express::Connection::framer() {
+  return framer_;
+}
+
+std::deque<express::OutputSegment> &express::Connection::output() {
+  return output_;
+}
+
+size_t express::Connection::write_offset() {
+  return write_offset_;
+}
+
+void express::Connection::consume_written(size_t bytes) {
+  while (bytes > 0 && !output_.empty()) {
+    OutputSegment &front = output_.front();
+    if (front.is_file()) {
+      size_t sent = std::min(bytes, front.file_remaining);
+      front.file_offset += sent;
+      front.file_remaining -= sent;
+      bytes -= sent;
+      if (front.file_remaining == 0) {
+        output_.pop_front(); // Closes the file
+      }
+      continue;
+    }
+
+    size_t sent = std::min(bytes, front.size() - write_offset_);
+    write_offset_ += sent;
+    bytes -= sent;
+    if (write_offset_ == front.size()) {
+      output_.pop_front();
+      write_offset_ = 0;
+    }
+  }
+}
+
+size_t express::Connection::gather_output(iovec *iovecs, size_t max_iovecs) {
+  size_t count = 0;
+  size_t offset = write_offset_;
+  for (auto it = output_.begin(); it != output_.end() && count < max_iovecs; ++it) {
+    if (it->is_file())
+      break;
+    // The kernel only reads from the buffer, so shared bytes are safe to hand over
+    iovecs[count].iov_base = const_cast<char *>(it->data()) + offset;
+    iovecs[count].iov_len = it->size() - offset;
+    count++;
+    offset = 0;
+  }
+  return count;
+}
+
+void express::Connection::take_output(std::vector<OutputSegment> &destination,
+                                      size_t max_segments) {
+  OutputSegment &front = output_.front();
+  if (write_offset_ > 0 && front.shared_bytes != nullptr) {
+    // Shared bytes cannot be trimmed in place, so the unsent rest is copied out
+    front.bytes.assign(front.data() + write_offset_, front.data() + front.size());
+    front.shared_bytes = nullptr;
+  } else if (write_offset_ > 0) {
+    front.bytes.erase(front.bytes.begin(), front.bytes.begin() + write_offset_);
+  }
+  write_offset_ = 0;
+  for (size_t taken = 0; taken < max_segments && !output_.empty(); taken++) {
+    if (output_.front().is_file())
+      break;
+    destination.push_back(std::move(output_.front()));
+    output_.pop_front();
+  }
+}
+
+void express::Connection::discard_output() {
+  output_.clear();
+  write_offset_ = 0;
+}
+
+bool express::Connection::has_pending_writes() {
+  return !output_.empty() || !ring.sending.empty();
+}
+
+uint64_t express::Connection::start_response() {
+  return next_sequence_++;
+}
+
+void express::Connection::queue_response(uint64_t sequence, OutputSegment segment) {
+  bool empty = segment.is_file() ? segment.file_remaining == 0 : segment.size() == 0;
+  if (empty)
+    return;
+  std::deque<OutputSegment> &target =
+      sequence == write_sequence_ ? output_ : held_responses_[sequence].output;
+  target.push_back(std::move(segment));
+}
+
+size_t express::Connection::finish_response(uint64_t sequence) {
+  if (sequence != write_sequence_) {
+    held_responses_[sequence].finished = true;
+    return 0;
+  }
+
+  size_t released = 1;
+  write_sequence_++;
+  auto it = held_responses_.begin();
+  while (it != held_responses_.end() && it->first == write_sequence_) {
+    std::move(it->second.output.begin(), it->second.output.end(), std::back_inserter(output_));
+    bool finished = it->second.finished;
+    it = held_responses_.erase(it);
+    if (!finished)
+      break; // Now at the head of the order, the rest of its bytes go straight to the buffer
+    write_sequence_++;
+    released++;
+  }
+  return released;
+}
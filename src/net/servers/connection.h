@@ -0,0 +1,265 @@
+#ifndef EXPRESS_CONNECTION_H
+#define EXPRESS_CONNECTION_H
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
+
+#include "http/body_stream.h"
+#include "http/request_framer.h"
+
+namespace express {
+/**
+ * Part of the output queued for a client: either bytes, owned or shared with other responses, or
+ * a range of an open file that is sent without copying it through user space. Owns the file
+ * descriptor.
+ */
+struct OutputSegment {
+  std::vector<char> bytes;
+
+  /** Immutable bytes sent in place of `bytes`, e.g. a cached body replayed to many clients */
+  std::shared_ptr<const std::vector<char>> shared_bytes;
+
+  /** Open file whose next `file_remaining` bytes, from `file_offset`, are sent; -1 for bytes */
+  int file_fd = -1;
+  off_t file_offset = 0;
+  size_t file_remaining = 0;
+
+  OutputSegment() = default;
+  OutputSegment(std::vector<char> bytes);
+  OutputSegment(std::shared_ptr<const std::vector<char>> shared_bytes);
+  OutputSegment(int file_fd, off_t file_offset, size_t file_length);
+
+  /**
+   * Returns true if the segment is a file range rather than bytes.
+   */
+  bool is_file() const;
+
+  /**
+   * Returns the bytes of a byte segment, whether it owns or shares them.
+   */
+  const char *data() const;
+
+  /**
+   * Returns the number of bytes of a byte segment.
+   */
+  size_t size() const;
+
+  // Rule of 5
+  ~OutputSegment();
+  OutputSegment(const OutputSegment &) = delete;
+  OutputSegment &operator=(const OutputSegment &) = delete;
+  OutputSegment(OutputSegment &&other) noexcept;
+  OutputSegment &operator=(OutputSegment &&other) noexcept;
+};
+
+/**
+ * State for a single client connection multiplexed by the Server's event loop.
+ * Owns the client file descriptor and the bytes buffered in each direction.
+ */
+class Connection {
+public:
+  /**
+   * @param max_body_size Largest request body accepted on routes without their own limit.
+   */
+  Connection(int fd, uint64_t id, size_t max_body_size = constants::MAX_REQUEST_SIZE_);
+  ~Connection();
+
+  /** Set once the connection should be closed after pending writes drain */
+  bool close_after_write = false;
+
+  /** Set once the client closed its side of the connection; nothing more will be read */
+  bool peer_closed = false;
+
+  /** Cleared once a response announced "Connection: close"; no further requests are read */
+  bool keep_alive = true;
+
+  /** Number of requests dispatched to the router whose response has not been written out yet */
+  size_t requests_in_flight = 0;
+
+  /** Number of requests answered on this connection */
+  size_t requests_served = 0;
+
+  /** Last time a request arrived or a response completed, for idle timeouts */
+  std::chrono::steady_clock::time_point last_activity;
+
+  /** Set when reading stopped because the read buffer is full, rather than drained */
+  bool read_paused = false;
+
+  /** Body of the request being streamed to its handler, while it arrives; null otherwise */
+  std::shared_ptr<BodyStream> body_stream;
+
+  /** Coroutine handlers waiting for the queued output to be sent, resumed once it is */
+  std::vector<std::coroutine_handle<>> drain_waiters;
+
+  /** Operations submitted to io_uring on behalf of this connection; unused with epoll */
+  struct RingState {
+    /** Submissions whose final completion has not arrived; the connection outlives them */
+    size_t pending_operations = 0;
+
+    /** Set while a multishot receive is armed */
+    bool receiving = false;
+
+    /** Set once the connection is being torn down; nothing new is submitted */
+    bool closing = false;
+
+    /** Segments handed to the kernel by the in-flight send, left untouched until it completes */
+    std::vector<OutputSegment> sending;
+
+    /** Gather list and header describing the unsent part of `sending` to the kernel */
+    std::vector<iovec> iovecs;
+    msghdr message = {};
+
+    /** Number of bytes of `sending` already sent */
+    size_t sent = 0;
+  };
+  RingState ring;
+
+  /**
+   * Returns the client file descriptor.
+   */
+  int fd();
+
+  /**
+   * Returns the server-unique id of this connection.
+   * Unlike the descriptor, an id is never reused once the connection closes.
+   */
+  uint64_t id();
+
+  /**
+   * Gives up ownership of the client file descriptor, once something else closed it.
+   */
+  void release();
+
+  /**
+   * Returns the bytes read from the client, including requests already handled but not yet
+   * compacted away. New data is appended at the end.
+   */
+  std::vector<char> &read_buffer();
+
+  /**
+   * Returns the start of the bytes read from the client that have not been handled yet.
+   */
+  char *unread_data();
+
+  /**
+   * Returns the number of bytes read from the client that have not been handled yet.
+   */
+  size_t unread_size();
+
+  /**
+   * Marks bytes at the front of the unread data as handled. They stay valid until the next
+   * compact_read_buffer().
+   */
+  void consume_read(size_t bytes);
+
+  /**
+   * Drops handled bytes from the front of the read buffer, making room for the next read.
+   */
+  void compact_read_buffer();
+
+  /**
+   * Returns the framer tracking how much of the request at the front of the read buffer arrived.
+   */
+  RequestFramer &framer();
+
+  /**
+   * Returns the output queued for the client that could not be written yet, in order.
+   * Buffers are queued as they were produced, without being merged, so they go out gathered.
+   */
+  std::deque<OutputSegment> &output();
+
+  /**
+   * Returns the number of bytes of the leading byte segment already sent.
+   */
+  size_t write_offset();
+
+  /**
+   * Records that more of the output has been sent, releasing every fully drained segment.
+   */
+  void consume_written(size_t bytes);
+
+  /**
+   * Describes the unsent part of the leading byte segments, up to the first file range.
+   * @return Number of entries filled in, at most `max_iovecs`.
+   */
+  size_t gather_output(iovec *iovecs, size_t max_iovecs);
+
+  /**
+   * Moves up to `max_segments` leading byte segments into `destination`, stopping at the first
+   * file range, which the caller reads itself.
+   */
+  void take_output(std::vector<OutputSegment> &destination, size_t max_segments);
+
+  /**
+   * Drops every queued segment, once the client can no longer receive them.
+   */
+  void discard_output();
+
+  /**
+   * Returns true if there are queued or in-flight bytes still waiting to be written.
+   */
+  bool has_pending_writes();
+
+  /**
+   * Reserves the next position in the response order for a newly dispatched request.
+   * @return Sequence number to pass to queue_response() and finish_response().
+   */
+  uint64_t start_response();
+
+  /**
+   * Queues part of the response to the request with the given sequence number: a buffer, taken
+   * over without copying, or a file range. Empty segments are dropped.
+   * Responses go out in request order: output of a response whose predecessors are still being
+   * handled is held back until they finish.
+   */
+  void queue_response(uint64_t sequence, OutputSegment segment);
+
+  /**
+   * Marks the response with the given sequence number as complete, and releases any held back
+   * responses that were only waiting on it into the write buffer.
+   * @return Number of responses, in request order, that are now fully queued for writing.
+   */
+  size_t finish_response(uint64_t sequence);
+
+  // Rule of 5
+  Connection(const Connection &) = delete;
+  Connection &operator=(const Connection &) = delete;
+  Connection(Connection &&) = delete;
+  Connection &operator=(Connection &&) = delete;
+
+private:
+  int fd_;
+  uint64_t id_;
+  std::vector<char> read_buffer_;
+  size_t read_offset_ = 0;
+  RequestFramer framer_;
+  std::deque<OutputSegment> output_;
+  size_t write_offset_ = 0;
+
+  /** Response finished by a worker before every earlier response on the connection was */
+  struct HeldResponse {
+    std::deque<OutputSegment> output;
+    bool finished = false;
+  };
+
+  /** Sequence number handed to the next dispatched request */
+  uint64_t next_sequence_ = 0;
+
+  /** Sequence number of the response currently at the head of the write order */
+  uint64_t write_sequence_ = 0;
+
+  /** Responses that cannot be written yet, keyed by sequence number */
+  std::map<uint64_t, HeldResponse> held_responses_;
+};
+} // namespace express
+
+#endif
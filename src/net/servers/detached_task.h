@@ -0,0 +1,23 @@
+#ifndef EXPRESS_DETACHED_TASK_H
+#define EXPRESS_DETACHED_TASK_H
+
+#include <coroutine>
+#include <exception>
+
+namespace express {
+/**
+ * Fire-and-forget coroutine: runs as soon as it is called, and frees its own frame on
+ * completion. Owns the request state of a suspended handler, so nothing else has to.
+ */
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+} // namespace express
+
+#endif
@@ -0,0 +1,223 @@
+#include "io_uring.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+int io_uring_setup(unsigned entries, struct io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg,
+                   size_t arg_size) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+int io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+unsigned load_acquire(unsigned *value) {
+  return std::atomic_ref<unsigned>(*value).load(std::memory_order_acquire);
+}
+
+void store_release(unsigned *value, unsigned new_value) {
+  std::atomic_ref<unsigned>(*value).store(new_value, std::memory_order_release);
+}
+
+std::string error_message(const std::string &step) {
+  return "io_uring " + step + " failed: " + std::strerror(errno);
+}
+} // namespace
+
+express::IoUring::IoUring(unsigned entries, uint16_t buffer_count, uint32_t buffer_size) {
+  buffer_count_ = buffer_count;
+  buffer_size_ = buffer_size;
+  try {
+    map_rings(entries);
+    register_buffers();
+  } catch (const IoUringError &) {
+    release();
+    throw;
+  }
+}
+
+express::IoUring::~IoUring() {
+  release();
+}
+
+void express::IoUring::map_rings(unsigned entries) {
+  struct io_uring_params params = {};
+  params.flags = IORING_SETUP_COOP_TASKRUN; // Completions are reaped by the same thread anyway
+  ring_fd_ = io_uring_setup(entries, &params);
+  if (ring_fd_ < 0 && errno == EINVAL) {
+    params = {};
+    ring_fd_ = io_uring_setup(entries, &params);
+  }
+  if (ring_fd_ < 0)
+    throw IoUringError(error_message("setup"));
+
+  unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+  if ((params.features & required) != required)
+    throw IoUringError("io_uring setup failed: kernel lacks single mmap, nodrop or ext arg");
+
+  // Multishot receive has no probe bit of its own; it shipped with zero-copy send in Linux 6.0
+  std::vector<char> probe_memory(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+  auto *probe = reinterpret_cast<io_uring_probe *>(probe_memory.data());
+  if (io_uring_register(ring_fd_, IORING_REGISTER_PROBE, probe, 256) < 0)
+    throw IoUringError(error_message("probe"));
+  if (probe->last_op < IORING_OP_SEND_ZC ||
+      !(probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED))
+    throw IoUringError("io_uring setup failed: kernel predates multishot receive");
+
+  sq_entries_ = params.sq_entries;
+  size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  ring_memory_size_ = std::max(sq_size, cq_size);
+  ring_memory_ = mmap(nullptr, ring_memory_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (ring_memory_ == MAP_FAILED) {
+    ring_memory_ = nullptr;
+    throw IoUringError(error_message("ring mmap"));
+  }
+
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+    throw IoUringError(error_message("sqe mmap"));
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  char *base = static_cast<char *>(ring_memory_);
+  sq_head_ = reinterpret_cast<unsigned *>(base + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(base + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+  cq_head_ = reinterpret_cast<unsigned *>(base + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(base + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+  sqe_tail_ = *sq_tail_;
+
+  // Submission slots map one-to-one onto the sqe array
+  unsigned *array = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+  for (unsigned i = 0; i < params.sq_entries; i++) {
+    array[i] = i;
+  }
+}
+
+void express::IoUring::register_buffers() {
+  buffer_ring_size_ = buffer_count_ * sizeof(io_uring_buf);
+  void *ring = mmap(nullptr, buffer_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ring == MAP_FAILED)
+    throw IoUringError(error_message("buffer ring mmap"));
+  buffer_ring_ = static_cast<io_uring_buf_ring *>(ring);
+
+  struct io_uring_buf_reg registration = {};
+  registration.ring_addr = reinterpret_cast<uint64_t>(buffer_ring_);
+  registration.ring_entries = buffer_count_;
+  registration.bgid = BUFFER_GROUP_;
+  if (io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &registration, 1) < 0)
+    throw IoUringError(error_message("buffer ring registration"));
+
+  // Mapped rather than heap-allocated, so the kernel can never write into reused memory
+  void *buffers = mmap(nullptr, static_cast<size_t>(buffer_count_) * buffer_size_,
+                       PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buffers == MAP_FAILED)
+    throw IoUringError(error_message("buffer mmap"));
+  buffers_ = static_cast<char *>(buffers);
+  for (uint16_t id = 0; id < buffer_count_; id++) {
+    recycle_buffer(id);
+  }
+}
+
+void express::IoUring::release() {
+  if (ring_fd_ >= 0) {
+    close(ring_fd_); // Also cancels whatever is still in flight
+    ring_fd_ = -1;
+  }
+  if (buffers_ != nullptr) {
+    munmap(buffers_, static_cast<size_t>(buffer_count_) * buffer_size_);
+    buffers_ = nullptr;
+  }
+  if (buffer_ring_ != nullptr) {
+    munmap(buffer_ring_, buffer_ring_size_);
+    buffer_ring_ = nullptr;
+  }
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (ring_memory_ != nullptr) {
+    munmap(ring_memory_, ring_memory_size_);
+    ring_memory_ = nullptr;
+  }
+}
+
+io_uring_sqe *express::IoUring::get_sqe() {
+  if (sqe_tail_ - load_acquire(sq_head_) >= sq_entries_) {
+    enter(0, nullptr, 0, 0);
+  }
+  io_uring_sqe *sqe = &sqes_[sqe_tail_ & sq_mask_];
+  sqe_tail_++;
+  std::memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+int express::IoUring::enter(unsigned wait_for, void *argument, size_t argument_size,
+                            unsigned flags) {
+  store_release(sq_tail_, sqe_tail_);
+  unsigned to_submit = sqe_tail_ - load_acquire(sq_head_); // Includes any a busy kernel left
+  int result;
+  do {
+    result = io_uring_enter(ring_fd_, to_submit, wait_for, flags, argument, argument_size);
+  } while (result < 0 && errno == EINTR && to_submit > 0);
+  return result;
+}
+
+void express::IoUring::submit_and_wait(std::chrono::milliseconds timeout) {
+  struct __kernel_timespec timespec = {};
+  timespec.tv_sec = timeout.count() / 1000;
+  timespec.tv_nsec = (timeout.count() % 1000) * 1000000;
+
+  struct io_uring_getevents_arg argument = {};
+  argument.ts = reinterpret_cast<uint64_t>(&timespec);
+
+  // Returns -ETIME on timeout, which the caller treats like an empty wakeup
+  enter(1, &argument, sizeof(argument), IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG);
+}
+
+bool express::IoUring::next_completion(io_uring_cqe &completion) {
+  unsigned head = *cq_head_;
+  if (head == load_acquire(cq_tail_))
+    return false;
+  completion = cqes_[head & cq_mask_];
+  store_release(cq_head_, head + 1);
+  return true;
+}
+
+char *express::IoUring::buffer(uint16_t id) {
+  return buffers_ + static_cast<size_t>(id) * buffer_size_;
+}
+
+void express::IoUring::recycle_buffer(uint16_t id) {
+  unsigned short *tail = &buffer_ring_->tail;
+  unsigned short current = std::atomic_ref<unsigned short>(*tail).load(std::memory_order_relaxed);
+
+  // Not buffer_ring_->bufs: in C++ the uapi flex array macro shifts it past an empty member
+  io_uring_buf *slots = reinterpret_cast<io_uring_buf *>(buffer_ring_);
+  io_uring_buf &slot = slots[current & (buffer_count_ - 1)];
+  slot.addr = reinterpret_cast<uint64_t>(buffer(id));
+  slot.len = buffer_size_;
+  slot.bid = id;
+  std::atomic_ref<unsigned short>(*tail).store(current + 1, std::memory_order_release);
+}
@@ -0,0 +1,117 @@
+#ifndef EXPRESS_IO_URING_H
+#define EXPRESS_IO_URING_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "net/servers/io_uring_error.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+namespace express {
+/**
+ * Minimal io_uring instance driven through the raw syscalls, without liburing.
+ * Owns the submission and completion rings, and one ring of provided receive buffers.
+ * Not thread-safe: used only by the thread running the owning Server's event loop.
+ */
+class IoUring {
+public:
+  /**
+   * Sets up a ring with room for `entries` submissions and registers `buffer_count` provided
+   * buffers of `buffer_size` bytes each under buffer group 0. `buffer_count` must be a power of 2.
+   * @throws IoUringError if io_uring is unavailable, or the kernel predates multishot receive.
+   */
+  IoUring(unsigned entries, uint16_t buffer_count, uint32_t buffer_size);
+  ~IoUring();
+
+  /** Buffer group the provided receive buffers are registered under */
+  static constexpr uint16_t BUFFER_GROUP_ = 0;
+
+  /**
+   * Returns a zeroed submission entry to fill in, submitting queued ones first if the
+   * submission ring is full.
+   */
+  io_uring_sqe *get_sqe();
+
+  /**
+   * Submits every queued entry and waits until at least one completion is ready or the timeout
+   * passes, in a single io_uring_enter call.
+   */
+  void submit_and_wait(std::chrono::milliseconds timeout);
+
+  /**
+   * Copies out the oldest unread completion.
+   * @return False if the completion ring is empty.
+   */
+  bool next_completion(io_uring_cqe &completion);
+
+  /**
+   * Returns the provided buffer with the given id, as reported by a receive completion.
+   */
+  char *buffer(uint16_t id);
+
+  /**
+   * Hands a provided buffer back to the kernel once its data has been consumed.
+   */
+  void recycle_buffer(uint16_t id);
+
+  // Rule of 5
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+  IoUring(IoUring &&) = delete;
+  IoUring &operator=(IoUring &&) = delete;
+
+private:
+  int ring_fd_ = -1;
+
+  void *ring_memory_ = nullptr;
+  size_t ring_memory_size_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  unsigned *sq_head_ = nullptr;
+  unsigned *sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+
+  /** Tail including entries handed out by get_sqe() but not yet published to the kernel */
+  unsigned sqe_tail_ = 0;
+
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+
+  io_uring_buf_ring *buffer_ring_ = nullptr;
+  size_t buffer_ring_size_ = 0;
+  char *buffers_ = nullptr;
+  uint16_t buffer_count_ = 0;
+  uint32_t buffer_size_ = 0;
+
+  /**
+   * Publishes queued submissions and enters the kernel.
+   * @return Result of io_uring_enter.
+   */
+  int enter(unsigned wait_for, void *argument, size_t argument_size, unsigned flags);
+
+  /**
+   * Creates the ring, checks kernel support, and maps the submission and completion rings.
+   */
+  void map_rings(unsigned entries);
+
+  /**
+   * Allocates the provided receive buffers and registers them as buffer group 0.
+   */
+  void register_buffers();
+
+  /**
+   * Unmaps and closes everything set up so far.
+   */
+  void release();
+};
+} // namespace express
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef EXPRESS_IO_URING_ERROR_H
+#define EXPRESS_IO_URING_ERROR_H
+
+#include <stdexcept>
+#include <string>
+
+namespace express {
+
+// Exception class for io_uring setup failures, including kernels lacking a required feature
+class IoUringError : public std::runtime_error {
+public:
+  explicit IoUringError(const std::string &message) : std::runtime_error(message) {}
+};
+
+} // namespace express
+
+#endif
@@ -0,0 +1,23 @@
+#include "scheduler.h"
+#include <express/task.h>
+#include <stdexcept>
+
+namespace {
+thread_local express::Scheduler *current_scheduler = nullptr;
+} // namespace
+
+express::Scheduler *express::Scheduler::current() {
+  return current_scheduler;
+}
+
+void express::Scheduler::set_current(Scheduler *scheduler) {
+  current_scheduler = scheduler;
+}
+
+void express::SleepAwaitable::await_suspend(std::coroutine_handle<> handle) const {
+  Scheduler *scheduler = Scheduler::current();
+  if (scheduler == nullptr) {
+    throw std::logic_error("express::sleep_for awaited outside a handler run by a server");
+  }
+  scheduler->resume_after(duration_, handle);
+}
@@ -0,0 +1,34 @@
+#ifndef EXPRESS_SCHEDULER_H
+#define EXPRESS_SCHEDULER_H
+
+#include <chrono>
+#include <coroutine>
+
+namespace express {
+/**
+ * Event loop side of the awaitables handed to coroutine handlers.
+ * Implemented by Server; the one running the current handler is found through current().
+ */
+class Scheduler {
+public:
+  virtual ~Scheduler() = default;
+
+  /**
+   * Resumes the coroutine once the duration has passed. Safe to call from any thread.
+   */
+  virtual void resume_after(std::chrono::steady_clock::duration duration,
+                            std::coroutine_handle<> handle) = 0;
+
+  /**
+   * Returns the scheduler whose handler is running on this thread, or nullptr.
+   */
+  static Scheduler *current();
+
+  /**
+   * Marks the scheduler whose handlers run on this thread until the next call.
+   */
+  static void set_current(Scheduler *scheduler);
+};
+} // namespace express
+
+#endif
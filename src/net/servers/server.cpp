@@ -1,74 +1,813 @@
 #include "server.h"
+#include <algorithm>
+#include <cerrno>
+#include <fmt/format.h>
+#include <optional>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
 
-express::Server::Server(SocketConfig config, Router router) {
+express::Server::Server(SocketConfig config, std::shared_ptr<RouterSlot> router,
+                        ListenOptions options, WorkerPool *worker_pool) {
   socket_ = new ListeningSocket(config);
-  router_ = router;
+  socket_->set_non_blocking();
+  router_slot_ = std::move(router);
+  router_version_ = router_slot_->version();
+  router_ = router_slot_->load();
+  options_ = options;
+  worker_pool_ = worker_pool;
+
+  wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  socket_->test_connection(wake_fd_);
+
+#ifdef EXPRESS_WITH_IO_URING
+  if (options_.backend == IoBackend::IO_URING) {
+    try {
+      ring_ = std::make_unique<IoUring>(RING_ENTRIES_, RING_BUFFERS_, CHUNK_SIZE_);
+      return;
+    } catch (const IoUringError &) {
+      ring_ = nullptr; // Kernel too old or io_uring disabled, serve with epoll instead
+    }
+  }
+#endif
+
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  socket_->test_connection(epoll_fd_);
+
+  struct epoll_event event = {};
+  event.events = EPOLLIN | EPOLLET;
+  event.data.u64 = LISTENER_ID_;
+  socket_->test_connection(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_->sock(), &event));
+  event.data.u64 = WAKE_ID_;
+  socket_->test_connection(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event));
 }
 
 express::Server::~Server() {
   stop();
+#ifdef EXPRESS_WITH_IO_URING
+  if (ring_ != nullptr) {
+    drain_ring();
+  }
+#endif
+  ring_ = nullptr; // Cancels in-flight operations before the buffers they point at go away
+  for (auto &[id, connection] : connections_) {
+    wake_drain_waiters(*connection);
+    fail_body(*connection, 503);
+  }
+  connections_.clear();
+  resume_abandoned();
+  close(wake_fd_);
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
   delete socket_;
 }
 
-std::unique_ptr<express::Request> express::Server::read_request() {
-  struct sockaddr_in address = socket()->address();
-  int addrlen = sizeof(address);
-  new_socket_ = accept(socket()->sock(), (struct sockaddr *)&address, (socklen_t *)&addrlen);
+express::Request express::Server::read_request(Connection &connection,
+                                              std::shared_ptr<BodyStream> body) {
+  RequestFramer &framer = connection.framer();
+  if (body != nullptr) {
+    std::string_view head(connection.unread_data(), framer.header_length());
+    connection.consume_read(head.size());
+    framer.stream_body(); // The body follows as it arrives, framed by receive_body()
+    return Request(head, std::move(body));
+  }
 
-  std::vector<char> buffer;
-  read_socket(buffer);
+  std::string_view message(connection.unread_data(), framer.message_length());
+  size_t consumed = framer.consumed_length();
+  framer.reset();
+  connection.consume_read(consumed); // Before parsing, so a malformed request is still dropped
 
-  std::string raw_request = std::string(buffer.begin(), buffer.end());
-  return std::make_unique<Request>(raw_request);
+  return Request(message);
 }
 
-int express::Server::read_socket(std::vector<char> &buffer) {
+int express::Server::read_socket(Connection &connection) {
+  std::vector<char> &buffer = connection.read_buffer();
   int total_bytes_read = 0;
-  std::vector<char> chunk(CHUNK_SIZE_);
+  connection.read_paused = false;
+  connection.compact_read_buffer();
+  size_t max_buffer = max_read_buffer(connection);
 
   while (true) {
-    ssize_t bytes_read = read(new_socket_, chunk.data(), CHUNK_SIZE_);
-    total_bytes_read += bytes_read;
+    if (buffer.size() >= max_buffer) {
+      connection.read_paused = true; // Resumed once the buffered requests are consumed
+      break;
+    }
 
+    // Read straight into the tail of the buffer
+    size_t used = buffer.size();
+    size_t chunk_size = std::min(CHUNK_SIZE_, max_buffer - used);
+    buffer.resize(used + chunk_size);
+    ssize_t bytes_read = read(connection.fd(), buffer.data() + used, chunk_size);
+    buffer.resize(used + std::max<ssize_t>(bytes_read, 0));
+
+    if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break; // Drained, wait for the next readiness event
+    if (bytes_read < 0 && errno == EINTR)
+      continue;
     if (bytes_read <= 0)
-      break;
+      return -1; // Peer closed or the read failed
 
-    if (buffer.size() + bytes_read > express::constants::MAX_REQUEST_SIZE_)
-      break;
+    total_bytes_read += bytes_read;
+    counters_.bytes_read.fetch_add(bytes_read, std::memory_order_relaxed);
+  }
 
-    buffer.insert(buffer.end(), chunk.begin(), chunk.begin() + bytes_read);
+  return total_bytes_read;
+}
 
-    if (bytes_read < CHUNK_SIZE_)
+void express::Server::flush_socket(Connection &connection) {
+#ifdef EXPRESS_WITH_IO_URING
+  if (ring_ != nullptr) {
+    flush_ring(connection);
+    return;
+  }
+#endif
+
+  // Every buffer queued since the last flush goes out in one gathered send, straight from where
+  // the responses built it; files go out with one sendfile each
+  iovec iovecs[MAX_IOVECS_];
+  while (connection.has_pending_writes()) {
+    OutputSegment &segment = connection.output().front();
+    ssize_t bytes_written;
+    if (segment.is_file()) {
+      off_t offset = segment.file_offset;
+      bytes_written = sendfile(connection.fd(), segment.file_fd, &offset, segment.file_remaining);
+      if (bytes_written == 0) {
+        errno = EIO; // File shrank below the Content-Length already sent
+        bytes_written = -1;
+      }
+    } else {
+      msghdr message = {};
+      message.msg_iov = iovecs;
+      message.msg_iovlen = connection.gather_output(iovecs, MAX_IOVECS_);
+      bytes_written = sendmsg(connection.fd(), &message, MSG_NOSIGNAL);
+    }
+
+    if (bytes_written < 0 && errno == EINTR)
+      continue;
+    if (bytes_written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return; // Socket is full, the rest goes out on the next EPOLLOUT
+    if (bytes_written < 0) {
+      connection.close_after_write = true;
+      connection.discard_output(); // Drop what can never be delivered
       break;
+    }
+
+    connection.consume_written(bytes_written);
+    counters_.bytes_written.fetch_add(bytes_written, std::memory_order_relaxed);
+  }
+  if (!connection.has_pending_writes()) {
+    wake_drain_waiters(connection);
   }
 
-  return total_bytes_read;
+  if (connection.close_after_write && connection.requests_in_flight == 0) {
+    close_socket(connection);
+  }
+}
+
+void express::Server::close_socket(Connection &connection) {
+  wake_drain_waiters(connection); // Their writes are dropped from now on
+  fail_body(connection, 400);
+  accept_retry_at_ = {}; // Frees a descriptor, so a paused accept may succeed again
+
+#ifdef EXPRESS_WITH_IO_URING
+  if (ring_ != nullptr && !close_ring(connection))
+    return; // Destroyed once the kernel completes the connection's last operation
+#endif
+
+  if (epoll_fd_ >= 0) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection.fd(), nullptr);
+  }
+  connections_.erase(connection.id()); // Destroys the connection, which closes the descriptor
+  counters_.open_connections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void express::Server::process_requests(Connection &connection) {
+  RequestFramer &framer = connection.framer();
+  while (true) {
+    // A streamed body is handed on before any request pipelined behind it is framed
+    if (connection.body_stream != nullptr && !receive_body(connection))
+      return;
+    if (!connection.keep_alive || connection.requests_in_flight >= MAX_PIPELINED_REQUESTS_)
+      return;
+    if (connection.unread_size() == 0)
+      return;
+
+    RequestFramer::Status status =
+        framer.advance(connection.unread_data(), connection.unread_size());
+    if (status == RequestFramer::Status::HEADERS) {
+      const BodyOptions *body = route_body_options(connection);
+      size_t max_size =
+          body != nullptr && body->max_size ? *body->max_size : options_.max_body_size;
+      if (!framer.limit_body(max_size)) {
+        reject_request(connection, framer.error_status());
+        return;
+      }
+      if (body != nullptr && body->stream) {
+        handle_connection(connection, open_body_stream(connection));
+        continue;
+      }
+      status = framer.advance(connection.unread_data(), connection.unread_size());
+    }
+    if (status == RequestFramer::Status::INCOMPLETE)
+      return;
+    if (status == RequestFramer::Status::ERROR) {
+      reject_request(connection, framer.error_status());
+      return;
+    }
+    handle_connection(connection);
+  }
 }
 
-void express::Server::write_socket(std::vector<char> content) {
-  write(new_socket_, content.data(), content.size());
+const express::BodyOptions *express::Server::route_body_options(Connection &connection) {
+  // Only the request line is needed: the method, then the target up to the next space
+  std::string_view head(connection.unread_data(), connection.framer().header_length());
+  size_t method_end = head.find(' ');
+  if (method_end == std::string_view::npos)
+    return nullptr; // Rejected once parsed
+  std::string_view target = head.substr(method_end + 1);
+  target = target.substr(0, target.find_first_of(" \r"));
+  return router_->body_options(head.substr(0, method_end), target);
 }
 
-void express::Server::close_socket() {
-  close(new_socket_);
+std::shared_ptr<express::BodyStream> express::Server::open_body_stream(Connection &connection) {
+  uint64_t connection_id = connection.id();
+  if (worker_pool_ != nullptr) {
+    return std::make_shared<BodyStream>([this, connection_id]() {
+      // Carries no output, it only has the I/O thread service the connection and read again
+      post_completion({connection_id, 0, {}, false});
+    });
+  }
+  return std::make_shared<BodyStream>([this, connection_id]() {
+    dirty_.push_back(connection_id); // Serviced once the running handlers return
+  });
+}
+
+bool express::Server::receive_body(Connection &connection) {
+  BodyStream &body = *connection.body_stream;
+  RequestFramer &framer = connection.framer();
+  size_t room;
+  while ((room = body.room()) > 0) {
+    // A receive may have buffered more than the handler has room for; the rest waits in the
+    // buffer. One header block more is always framed, so chunk lines and trailers fit.
+    size_t size = std::min(connection.unread_size(), room + constants::MAX_HEADER_SIZE_);
+    RequestFramer::Status status = framer.advance(connection.unread_data(), size);
+    if (status == RequestFramer::Status::ERROR) {
+      fail_body(connection, framer.error_status());
+      return false;
+    }
+    if (std::coroutine_handle<> waiter =
+            body.append(std::string_view(connection.unread_data(), framer.message_length()))) {
+      ready_.push_back(waiter);
+    }
+    size_t consumed = framer.consumed_length();
+    connection.consume_read(consumed);
+
+    if (status == RequestFramer::Status::COMPLETE) {
+      if (std::coroutine_handle<> waiter = body.finish()) {
+        ready_.push_back(waiter);
+      }
+      framer.reset();
+      connection.body_stream = nullptr;
+      return true;
+    }
+    framer.release_body();
+    if (consumed == 0)
+      break; // Waiting for more of the body
+  }
+
+  if (room > 0 && connection.peer_closed) {
+    fail_body(connection, 400); // The rest of the body will never arrive
+  }
+  return false;
 }
 
-void express::Server::handle_connection() {
-  std::unique_ptr<Request> request = read_request();
-  Response response(
-      [this](const std::vector<char> &data) {
-        this->write_socket(data);
+void express::Server::fail_body(Connection &connection, int status) {
+  if (connection.body_stream == nullptr)
+    return;
+  if (std::coroutine_handle<> waiter = connection.body_stream->fail(status)) {
+    ready_.push_back(waiter);
+  }
+  connection.body_stream = nullptr;
+
+  // Where the body would have ended is unknown, so no request can follow it
+  connection.keep_alive = false;
+  connection.close_after_write = true;
+  connection.consume_read(connection.unread_size());
+}
+
+size_t express::Server::max_read_buffer(Connection &connection) {
+  // A streamed body is handed on as it arrives, so it needs no room of its own
+  size_t body = connection.body_stream != nullptr ? 0 : connection.framer().body_limit();
+  return constants::MAX_HEADER_SIZE_ + body + CHUNK_SIZE_;
+}
+
+void express::Server::reject_request(Connection &connection, int status) {
+  connection.keep_alive = false;
+  connection.close_after_write = true;
+  connection.consume_read(connection.unread_size());
+
+  // Queued behind any pipelined requests still being handled
+  uint64_t sequence = connection.start_response();
+  connection.requests_in_flight++;
+  Response response([&connection, sequence](std::vector<char> data) {
+    connection.queue_response(sequence, std::move(data));
+  });
+  response.set("Connection", "close");
+  response.send(status);
+  complete_response(connection, sequence);
+}
+
+void express::Server::handle_connection(Connection &connection,
+                                        std::shared_ptr<BodyStream> body) {
+  std::optional<Request> request;
+  try {
+    request.emplace(read_request(connection, body));
+  } catch (const std::exception &) {
+    reject_request(connection, 400); // Malformed request line
+    return;
+  }
+  connection.body_stream = std::move(body);
+  connection.last_activity = std::chrono::steady_clock::now();
+  counters_.requests_handled.fetch_add(1, std::memory_order_relaxed);
+
+  bool keep_alive = should_keep_alive(connection, *request);
+  if (!keep_alive) {
+    connection.keep_alive = false;
+    connection.close_after_write = true;
+  }
+
+  uint64_t sequence = connection.start_response();
+  connection.requests_in_flight++;
+
+  // One allocation holds the request and response for as long as a coroutine handler needs them
+  std::unique_ptr<Exchange> exchange(new Exchange{connection.id(), sequence, std::move(*request),
+                                                  make_response(connection.id(), sequence),
+                                                  router_.get()});
+  exchange->response.set("Connection", keep_alive ? "keep-alive" : "close");
+  exchange->response.set_http_version(exchange->request.http_version);
+  if (exchange->request.method == "HEAD") {
+    exchange->response.omit_body();
+  }
+
+  if (worker_pool_ == nullptr) {
+    dispatch(std::move(exchange));
+    return;
+  }
+
+  hold_router(); // Released once the worker's final completion arrives
+  Exchange *submitted = exchange.release(); // Jobs must be copyable
+  worker_pool_->submit([this, submitted]() { dispatch(std::unique_ptr<Exchange>(submitted)); });
+}
+
+void express::Server::refresh_router() {
+  uint64_t version = router_slot_->version();
+  if (version == router_version_)
+    return;
+  router_version_ = version;
+  std::shared_ptr<const CompiledRouter> replaced = std::exchange(router_, router_slot_->load());
+  if (router_users_ > 0) {
+    retired_routers_.push_back({std::move(replaced), router_users_});
+  }
+  router_users_ = 0;
+}
+
+void express::Server::hold_router() {
+  router_users_++;
+}
+
+void express::Server::release_router(const CompiledRouter *router) {
+  if (router == router_.get()) {
+    router_users_--;
+    return;
+  }
+  auto retired = std::find_if(retired_routers_.begin(), retired_routers_.end(),
+                              [router](const RetiredRouter &entry) {
+                                return entry.router.get() == router;
+                              });
+  if (--retired->users == 0) {
+    retired_routers_.erase(retired);
+  }
+}
+
+express::Response express::Server::make_response(uint64_t connection_id, uint64_t sequence) {
+  if (worker_pool_ != nullptr) {
+    return Response(
+        [this, connection_id, sequence](std::vector<char> data) {
+          if (!data.empty()) {
+            post_completion({connection_id, sequence, std::move(data), false});
+          }
+        },
+        [this, connection_id, sequence](std::coroutine_handle<> waiter) {
+          post_completion({connection_id, sequence, {}, false, waiter});
+        },
+        [this, connection_id, sequence](int file_fd, size_t length) {
+          post_completion({connection_id, sequence, OutputSegment(file_fd, 0, length), false});
+        },
+        [this, connection_id, sequence](std::shared_ptr<const std::vector<char>> bytes) {
+          post_completion({connection_id, sequence, OutputSegment(std::move(bytes)), false});
+        });
+  }
+
+  // Coroutine handlers may write after the connection closed, so look it up on every write
+  return Response(
+      [this, connection_id, sequence](std::vector<char> data) {
+        auto it = connections_.find(connection_id);
+        if (it == connections_.end() || it->second->ring.closing)
+          return;
+        it->second->queue_response(sequence, std::move(data));
+        if (resuming_) {
+          dirty_.push_back(connection_id);
+        }
+      },
+      [this, connection_id](std::coroutine_handle<> waiter) {
+        auto it = connections_.find(connection_id);
+        if (it == connections_.end() || !it->second->has_pending_writes()) {
+          ready_.push_back(waiter);
+          return;
+        }
+        it->second->drain_waiters.push_back(waiter);
+        dirty_.push_back(connection_id);
+      },
+      [this, connection_id, sequence](int file_fd, size_t length) {
+        OutputSegment file(file_fd, 0, length); // Closes the file if the client went away
+        auto it = connections_.find(connection_id);
+        if (it == connections_.end() || it->second->ring.closing)
+          return;
+        it->second->queue_response(sequence, std::move(file));
+        if (resuming_) {
+          dirty_.push_back(connection_id);
+        }
       },
-      [this]() {
-        this->close_socket();
+      [this, connection_id, sequence](std::shared_ptr<const std::vector<char>> bytes) {
+        auto it = connections_.find(connection_id);
+        if (it == connections_.end() || it->second->ring.closing)
+          return;
+        it->second->queue_response(sequence, OutputSegment(std::move(bytes)));
+        if (resuming_) {
+          dirty_.push_back(connection_id);
+        }
       });
-  router_.run(*request, response);
+}
+
+void express::Server::dispatch(std::unique_ptr<Exchange> exchange) {
+  Scheduler::set_current(this);
+  Task<> handlers;
+  try {
+    handlers = exchange->router->run(exchange->request, exchange->response);
+  } catch (const std::exception &error) {
+    answer_exception(exchange->response, error); // Thrown by a synchronous handler
+  }
+  if (handlers) {
+    // Suspended on the I/O thread, so the table is held from here; workers hold it already
+    if (worker_pool_ == nullptr) {
+      hold_router();
+    }
+    serve(std::move(exchange), std::move(handlers)); // Frees itself once the handlers finish
+    return;
+  }
+  finish_exchange(*exchange);
+}
+
+express::DetachedTask express::Server::serve(std::unique_ptr<Exchange> exchange,
+                                             Task<> handlers) {
+  try {
+    co_await handlers;
+  } catch (const std::exception &error) {
+    answer_exception(exchange->response, error);
+  }
+  handlers = Task<>(); // Its frame goes before the table it ran from may be freed
+  finish_exchange(*exchange);
+  if (worker_pool_ == nullptr) {
+    release_router(exchange->router);
+  }
+}
+
+void express::Server::answer_exception(Response &response, const std::exception &error) {
+  if (response.headers_sent())
+    return;
+  const BodyError *body_error = dynamic_cast<const BodyError *>(&error);
+  if (body_error != nullptr) {
+    response.status(body_error->status()).send(std::string(error.what()));
+  } else {
+    response.status(500).send("Internal Server Error");
+  }
+}
+
+void express::Server::finish_exchange(Exchange &exchange) {
+  Request &request = exchange.request;
+  Response &response = exchange.response;
+  if (!response.headers_sent()) {
+    response.status(404).send(fmt::format("Cannot {} {}", request.method, request.path));
+  }
+  response.finish();
+
+  if (worker_pool_ != nullptr) {
+    post_completion({exchange.connection_id, exchange.sequence, {}, true, nullptr,
+                     exchange.router, response.close_delimited()});
+    return;
+  }
+  auto it = connections_.find(exchange.connection_id);
+  if (it == connections_.end() || it->second->ring.closing)
+    return; // Client went away while the handler was suspended
+  if (response.close_delimited()) {
+    it->second->keep_alive = false;
+    it->second->close_after_write = true;
+  }
+  complete_response(*it->second, exchange.sequence);
+  if (resuming_) {
+    dirty_.push_back(exchange.connection_id);
+  }
+}
+
+bool express::Server::should_keep_alive(Connection &connection, const Request &request) {
+  if (connection.close_after_write)
+    return false; // Peer already half-closed
+  size_t dispatched = connection.requests_served + connection.requests_in_flight;
+  if (dispatched + 1 >= options_.max_requests_per_connection)
+    return false;
+
+  std::string_view connection_header = request.header(Header::Connection);
+
+  // HTTP/1.1 persists by default, HTTP/1.0 only when the client asks for it
+  if (request.http_version == "HTTP/1.1")
+    return !Headers::equals(connection_header, "close");
+  return Headers::equals(connection_header, "keep-alive");
+}
+
+void express::Server::complete_response(Connection &connection, uint64_t sequence) {
+  size_t answered = connection.finish_response(sequence);
+  if (answered == 0)
+    return; // Held back behind an earlier response
+  connection.requests_in_flight -= answered;
+  connection.requests_served += answered;
+  connection.last_activity = std::chrono::steady_clock::now();
+}
+
+void express::Server::close_idle_connections() {
+  auto now = std::chrono::steady_clock::now();
+  std::vector<uint64_t> idle;
+  for (auto &[id, connection] : connections_) {
+    bool busy = connection->requests_in_flight > 0 || connection->has_pending_writes();
+    if (!busy && now - connection->last_activity > options_.keep_alive_timeout) {
+      idle.push_back(id);
+    }
+  }
+  for (uint64_t id : idle) {
+    close_socket(*connections_[id]);
+  }
+}
+
+void express::Server::post_completion(Completion completion) {
+  {
+    std::lock_guard<std::mutex> lock(completions_mutex_);
+    completions_.push_back(std::move(completion));
+  }
+  uint64_t one = 1;
+  ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+  (void)ignored; // The counter saturating still leaves the eventfd readable
+}
+
+void express::Server::drain_completions() {
+  uint64_t counter;
+  while (read(wake_fd_, &counter, sizeof(counter)) > 0) {
+  }
+
+  std::vector<Completion> ready;
+  {
+    std::lock_guard<std::mutex> lock(completions_mutex_);
+    ready.swap(completions_);
+  }
+
+  std::vector<uint64_t> touched;
+  for (Completion &completion : ready) {
+    if (completion.router != nullptr) {
+      release_router(completion.router); // Even if the client went away
+    }
+    auto it = connections_.find(completion.connection_id);
+    if (it == connections_.end() || it->second->ring.closing) {
+      if (completion.waiter) {
+        ready_.push_back(completion.waiter); // Resumed to unwind, its writes are dropped
+      }
+      continue; // Client went away while the handler ran
+    }
+    Connection &connection = *it->second;
+
+    connection.queue_response(completion.sequence, std::move(completion.output));
+    if (completion.close_connection) {
+      connection.keep_alive = false;
+      connection.close_after_write = true;
+    }
+    if (completion.finished) {
+      complete_response(connection, completion.sequence);
+    }
+    if (completion.waiter) {
+      connection.drain_waiters.push_back(completion.waiter); // Resumed by the flush below
+    }
+    touched.push_back(completion.connection_id);
+  }
+  service_connections(touched);
+}
+
+void express::Server::service_connections(std::vector<uint64_t> &touched) {
+  // One flush per connection, however many of its responses finished in this batch
+  std::sort(touched.begin(), touched.end());
+  touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+  for (uint64_t connection_id : touched) {
+    auto it = connections_.find(connection_id);
+    if (it == connections_.end())
+      continue;
+    Connection &connection = *it->second;
+
+    if (connection.read_paused && ring_ == nullptr) {
+      handle_readable(connection); // Buffer has room again, resume reading
+    } else {
+      process_requests(connection); // Requests that queued up behind the pipelining limit
+      flush_socket(connection);     // With io_uring, also resumes a paused receive
+    }
+  }
+}
+
+void express::Server::resume_after(std::chrono::steady_clock::duration duration,
+                                   std::coroutine_handle<> handle) {
+  {
+    std::lock_guard<std::mutex> lock(timers_mutex_);
+    timers_.push({std::chrono::steady_clock::now() + duration, handle});
+  }
+  if (std::this_thread::get_id() != server_thread_.get_id()) {
+    uint64_t one = 1;
+    ssize_t ignored = write(wake_fd_, &one, sizeof(one)); // Recompute the wait timeout
+    (void)ignored;
+  }
+}
+
+std::chrono::milliseconds express::Server::next_timeout() {
+  std::chrono::milliseconds timeout(constants::DEFAULT_SELECT_TIMEOUT_MS);
+  if (!ready_.empty())
+    return std::chrono::milliseconds(0);
+
+  std::lock_guard<std::mutex> lock(timers_mutex_);
+  if (timers_.empty())
+    return timeout;
+  auto remaining = timers_.top().deadline - std::chrono::steady_clock::now();
+  auto remaining_ms = std::chrono::ceil<std::chrono::milliseconds>(remaining);
+  return std::clamp(remaining_ms, std::chrono::milliseconds(0), timeout);
+}
+
+void express::Server::resume_ready() {
+  {
+    std::lock_guard<std::mutex> lock(timers_mutex_);
+    auto now = std::chrono::steady_clock::now();
+    while (!timers_.empty() && timers_.top().deadline <= now) {
+      ready_.push_back(timers_.top().handle);
+      timers_.pop();
+    }
+  }
+  if (ready_.empty() && dirty_.empty())
+    return;
+
+  // Handlers that become ready while these run wait for the next iteration
+  std::vector<std::coroutine_handle<>> resuming;
+  resuming.swap(ready_);
+  resuming_ = true;
+  for (std::coroutine_handle<> handle : resuming) {
+    if (worker_pool_ == nullptr) {
+      handle.resume();
+      continue;
+    }
+    worker_pool_->submit([this, handle]() {
+      Scheduler::set_current(this);
+      handle.resume();
+    });
+  }
+  resuming_ = false;
+
+  std::vector<uint64_t> dirty;
+  dirty.swap(dirty_);
+  service_connections(dirty);
+}
+
+void express::Server::wake_drain_waiters(Connection &connection) {
+  ready_.insert(ready_.end(), connection.drain_waiters.begin(), connection.drain_waiters.end());
+  connection.drain_waiters.clear();
+}
+
+void express::Server::resume_abandoned() {
+  Scheduler::set_current(nullptr);
+  {
+    std::lock_guard<std::mutex> lock(completions_mutex_);
+    for (Completion &completion : completions_) {
+      if (completion.waiter) {
+        ready_.push_back(completion.waiter);
+      }
+    }
+    completions_.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(timers_mutex_);
+    for (; !timers_.empty(); timers_.pop()) {
+      ready_.push_back(timers_.top().handle);
+    }
+  }
+
+  std::vector<std::coroutine_handle<>> resuming;
+  resuming.swap(ready_);
+  for (std::coroutine_handle<> handle : resuming) {
+    handle.resume();
+  }
+}
+
+void express::Server::handle_readable(Connection &connection) {
+  while (true) {
+    bool peer_closed = read_socket(connection) < 0;
+    if (peer_closed) {
+      connection.close_after_write = true; // Still answer a request that arrived before the FIN
+      connection.peer_closed = true;
+    }
+
+    process_requests(connection);
+    if (!connection.read_paused || (!connection.keep_alive && connection.body_stream == nullptr))
+      break;
+    if (connection.unread_size() < max_read_buffer(connection))
+      continue; // Requests or a streamed body made room, keep reading
+    if (connection.requests_in_flight > 0)
+      break; // Resumed once they complete, or the body's handler drains it
+    reject_request(connection, 413); // Full buffer, yet not one complete request
+    break;
+  }
+  flush_socket(connection);
+}
+
+void express::Server::accept_connections() {
+  while (true) {
+    struct sockaddr_in address = socket()->address();
+    socklen_t addrlen = sizeof(address);
+    int client_fd = accept4(socket()->sock(), (struct sockaddr *)&address, &addrlen,
+                            SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if (client_fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        pause_accept(); // The edge is spent, so resume_accept() drains the backlog later
+      }
+      return;
+    }
+
+    uint64_t id = next_connection_id_++;
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.u64 = id;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &event) < 0) {
+      close(client_fd);
+      continue;
+    }
+    connections_[id] = std::make_unique<Connection>(client_fd, id, options_.max_body_size);
+    counters_.connections_accepted.fetch_add(1, std::memory_order_relaxed);
+    counters_.open_connections.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void express::Server::pause_accept() {
+  counters_.accept_errors.fetch_add(1, std::memory_order_relaxed);
+  accept_paused_ = true;
+  accept_retry_at_ = std::chrono::steady_clock::now() + ACCEPT_BACKOFF_;
+}
+
+void express::Server::resume_accept() {
+  if (!accept_paused_ || std::chrono::steady_clock::now() < accept_retry_at_)
+    return;
+  accept_paused_ = false;
+#ifdef EXPRESS_WITH_IO_URING
+  if (ring_ != nullptr) {
+    arm_accept();
+    return;
+  }
+#endif
+  accept_connections();
 }
 
 express::ListeningSocket *express::Server::socket() {
   return socket_;
 }
 
+express::ShardStats express::Server::stats() {
+  ShardStats snapshot;
+  snapshot.connections_accepted = counters_.connections_accepted.load(std::memory_order_relaxed);
+  snapshot.accept_errors = counters_.accept_errors.load(std::memory_order_relaxed);
+  snapshot.open_connections = counters_.open_connections.load(std::memory_order_relaxed);
+  snapshot.requests_handled = counters_.requests_handled.load(std::memory_order_relaxed);
+  snapshot.bytes_read = counters_.bytes_read.load(std::memory_order_relaxed);
+  snapshot.bytes_written = counters_.bytes_written.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+express::IoBackend express::Server::backend() {
+  return ring_ != nullptr ? IoBackend::IO_URING : IoBackend::EPOLL;
+}
+
 void express::Server::launch() {
   if (is_running)
     return;
@@ -77,21 +816,57 @@ void express::Server::launch() {
 }
 
 void express::Server::run() {
+  Scheduler::set_current(this); // Inline handlers run on this thread
+#ifdef EXPRESS_WITH_IO_URING
+  if (ring_ != nullptr) {
+    run_io_uring();
+    return;
+  }
+#endif
+  run_epoll();
+}
+
+void express::Server::run_epoll() {
+  std::vector<struct epoll_event> events(MAX_EVENTS_);
+
   while (is_running) {
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    FD_SET(socket_->sock(), &readfds);
+    int ready =
+        epoll_wait(epoll_fd_, events.data(), MAX_EVENTS_, static_cast<int>(next_timeout().count()));
+    refresh_router();
+    close_idle_connections();
+    resume_accept();
+
+    for (int i = 0; i < ready; i++) {
+      uint64_t id = events[i].data.u64;
+      uint32_t flags = events[i].events;
 
-    struct timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = constants::DEFAULT_SELECT_TIMEOUT_US;
+      if (id == LISTENER_ID_) {
+        accept_connections();
+        continue;
+      }
+      if (id == WAKE_ID_) {
+        drain_completions();
+        continue;
+      }
 
-    int activity = select(socket_->sock() + 1, &readfds, NULL, NULL, &tv);
-    bool got_new_connection = activity > 0;
+      auto it = connections_.find(id);
+      if (it == connections_.end())
+        continue;
+      Connection &connection = *it->second;
 
-    if (got_new_connection) {
-      handle_connection();
+      if (flags & (EPOLLERR | EPOLLHUP)) {
+        close_socket(connection);
+        continue;
+      }
+      if (flags & (EPOLLIN | EPOLLRDHUP)) {
+        handle_readable(connection);
+        continue; // handle_readable flushes, and may have closed the connection
+      }
+      if (flags & EPOLLOUT) {
+        flush_socket(connection);
+      }
     }
+    resume_ready();
   }
 }
 
@@ -107,4 +882,4 @@ void express::Server::stop() {
   } catch (const std::exception &e) {
     throw std::runtime_error("Failed to stop server: " + std::string(e.what()));
   }
-}
\ No newline at end of file
+}
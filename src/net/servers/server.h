@@ -1,21 +1,41 @@
 #ifndef EXPRESS_SERVER_H
 #define EXPRESS_SERVER_H
 
+#include <chrono>
+#include <coroutine>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <queue>
 #include <stdio.h>
 #include <thread>
 #include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
-#include "core/router.h"
+#include "core/router_slot.h"
 #include "net/express_networking.h"
+#include "net/servers/connection.h"
+#include "net/servers/detached_task.h"
+#include "net/servers/io_uring.h"
+#include "net/servers/scheduler.h"
+#include "net/servers/worker_pool.h"
 #include "utils/constants.h"
+#include <express/listen_options.h>
+#include <express/shard_stats.h>
 #include <express/types.h>
 
 namespace express {
-class Server {
+class Server : public Scheduler {
 public:
-  Server(SocketConfig config, Router router);
+  /**
+   * @param router Slot publishing the dispatch table, usually shared with other servers. Tables
+   * published while the server runs are picked up by the next request.
+   * @param worker_pool Pool running route handlers, or nullptr to run them on the I/O thread.
+   * Must outlive the server.
+   */
+  Server(SocketConfig config, std::shared_ptr<RouterSlot> router,
+         ListenOptions options = ListenOptions(), WorkerPool *worker_pool = nullptr);
   ~Server();
 
   /** Flag indicating if server is running */
@@ -38,60 +58,493 @@ public:
    */
   ListeningSocket *socket();
 
+  /**
+   * Returns a snapshot of this server's traffic counters. Safe to call from any thread.
+   */
+  ShardStats stats();
+
+  /**
+   * Returns the I/O backend actually in use, which is EPOLL if io_uring was requested but is
+   * unavailable.
+   */
+  IoBackend backend();
+
+  /**
+   * Resumes a suspended coroutine handler on this server once the duration has passed.
+   * Safe to call from any thread.
+   */
+  void resume_after(std::chrono::steady_clock::duration duration,
+                    std::coroutine_handle<> handle) override;
+
 private:
   /** Size of each chunk when reading request data (8KB) */
   static constexpr size_t CHUNK_SIZE_ = 8 * constants::KB_;
 
+  /** Maximum number of readiness events handled per epoll_wait call */
+  static constexpr int MAX_EVENTS_ = 256;
+
+  /** Buffers gathered into a single send */
+  static constexpr size_t MAX_IOVECS_ = 64;
+
+  /** Pipelined requests per connection handled concurrently before framing pauses */
+  static constexpr size_t MAX_PIPELINED_REQUESTS_ = 64;
+
+  /** Epoll tags for the listening socket and the wakeup eventfd; connections use their id */
+  static constexpr uint64_t LISTENER_ID_ = UINT64_MAX;
+  static constexpr uint64_t WAKE_ID_ = UINT64_MAX - 1;
+
+  /** Pause after a failed accept, e.g. with the descriptor table full, before trying again */
+  static constexpr std::chrono::milliseconds ACCEPT_BACKOFF_{100};
+
+  /** Submission slots in the io_uring instance */
+  static constexpr unsigned RING_ENTRIES_ = 1024;
+
+  /** Provided receive buffers of CHUNK_SIZE_ bytes each, shared by every connection */
+  static constexpr uint16_t RING_BUFFERS_ = 256;
+
+  /** Bytes of a file response read, then sent, per io_uring round trip (64KB) */
+  static constexpr size_t FILE_CHUNK_SIZE_ = 64 * constants::KB_;
+
   /** Socket for accepting incoming connections */
   ListeningSocket *socket_;
 
-  /** Temporary socket for current client connection */
-  int new_socket_;
+  /** Epoll instance multiplexing the listening socket and every client connection, or -1 */
+  int epoll_fd_ = -1;
+
+  /** io_uring instance replacing epoll when that backend is selected and available */
+  std::unique_ptr<IoUring> ring_;
+
+  /** Open client connections, keyed by connection id */
+  std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections_;
+
+  /** Id handed to the next accepted connection */
+  uint64_t next_connection_id_ = 0;
+
+  /** Set while accepting is paused by an error, until accept_retry_at_ or a connection closes */
+  bool accept_paused_ = false;
+  std::chrono::steady_clock::time_point accept_retry_at_;
+
+  /** Output produced by a worker thread, waiting for the I/O thread to write it */
+  struct Completion {
+    uint64_t connection_id;
+    uint64_t sequence;
+    OutputSegment output;
+    bool finished;
+
+    /** Coroutine handler to resume once the connection's output drained, if any */
+    std::coroutine_handle<> waiter = nullptr;
+
+    /** Dispatch table the finished request was routed with, released on the I/O thread */
+    const CompiledRouter *router = nullptr;
+
+    /** Set when the response body was unframed, so only closing the connection ends it */
+    bool close_connection = false;
+  };
 
-  /** Router for handling requests */
-  Router router_;
+  /** A request and its response, kept alive for as long as its handlers run */
+  struct Exchange {
+    uint64_t connection_id;
+    uint64_t sequence;
+    Request request;
+    Response response;
+    /** Dispatch table the request started with, kept alive by the server until it finishes */
+    const CompiledRouter *router;
+  };
+
+  /** Coroutine handler suspended by sleep_for, resumed once its deadline passes */
+  struct Timer {
+    std::chrono::steady_clock::time_point deadline;
+    std::coroutine_handle<> handle;
+    bool operator>(const Timer &other) const { return deadline > other.deadline; }
+  };
+
+  /** Keep-alive limits, worker count and I/O backend */
+  ListenOptions options_;
+
+  /** Traffic counters, written by the I/O thread and read by stats() */
+  struct Counters {
+    std::atomic<size_t> connections_accepted{0};
+    std::atomic<size_t> accept_errors{0};
+    std::atomic<size_t> open_connections{0};
+    std::atomic<size_t> requests_handled{0};
+    std::atomic<size_t> bytes_read{0};
+    std::atomic<size_t> bytes_written{0};
+  };
+  Counters counters_;
+
+  /** Pool running route handlers, or nullptr to run them inline */
+  WorkerPool *worker_pool_;
+
+  /** Eventfd that wakes the event loop when workers post completions */
+  int wake_fd_;
+
+  /** Completions posted by workers since the last wakeup */
+  std::vector<Completion> completions_;
+  std::mutex completions_mutex_;
+
+  /** Pending sleep_for timers, earliest first. Armed from worker threads too */
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+  std::mutex timers_mutex_;
+
+  /** Coroutine handlers ready to resume at the end of the current loop iteration */
+  std::vector<std::coroutine_handle<>> ready_;
+
+  /** Set while resume_ready() runs coroutine handlers on the I/O thread */
+  bool resuming_ = false;
+
+  /** Connections given output by resumed handlers, flushed once they all ran */
+  std::vector<uint64_t> dirty_;
+
+  /** Slot publishing the dispatch table */
+  std::shared_ptr<RouterSlot> router_slot_;
+
+  /** Table new requests are dispatched with, and the slot version it was published as */
+  std::shared_ptr<const CompiledRouter> router_;
+  uint64_t router_version_ = 0;
+
+  /** Requests routed with `router_` that are still running on a worker or suspended */
+  size_t router_users_ = 0;
+
+  /** Replaced table kept for the requests still using it, freed once the last one finishes */
+  struct RetiredRouter {
+    std::shared_ptr<const CompiledRouter> router;
+    size_t users;
+  };
+  std::vector<RetiredRouter> retired_routers_;
+
+  /**
+   * Picks up a newly published dispatch table. Only called between events, when no request
+   * runs on the I/O thread, so only the requests counted in `router_users_` still use the
+   * replaced table. I/O thread only.
+   * @private
+   */
+  void refresh_router();
+
+  /**
+   * Keeps the current table alive for a request that outlives its dispatch, by running on a
+   * worker or suspending. Costs no atomic operation. I/O thread only.
+   * @private
+   */
+  void hold_router();
+
+  /**
+   * Ends a hold_router(), freeing a replaced table once no request uses it. I/O thread only.
+   * @private
+   */
+  void release_router(const CompiledRouter *router);
 
   /** Thread running the server loop */
   std::thread server_thread_;
 
   /**
-   * Starts the server if it is marked as running.
+   * Runs the event loop of the selected backend while the server is marked as running.
    * @private
    */
   void run();
 
   /**
-   * Reads from socket, processes, and writes response to socket.
+   * Runs the epoll event loop.
+   * @private
+   */
+  void run_epoll();
+
+  /**
+   * Runs the io_uring event loop. Defined in server_io_uring.cpp.
+   * @private
+   */
+  void run_io_uring();
+
+  /**
+   * Dispatches one io_uring completion to the accept, wakeup or connection it belongs to.
+   * @private
+   */
+  void handle_ring_completion(const io_uring_cqe &completion);
+
+  /**
+   * Appends the bytes of a receive completion to the read buffer, and handles the requests.
+   * @private
+   */
+  void handle_ring_receive(Connection &connection, const io_uring_cqe &completion);
+
+  /**
+   * Continues or finishes the in-flight send after its completion.
+   * @private
+   */
+  void handle_ring_send(Connection &connection, int result);
+
+  /**
+   * Sends the chunk of a file response that was just read into the send buffer.
+   * @private
+   */
+  void handle_ring_read(Connection &connection, int result);
+
+  /**
+   * Submits a multishot accept on the listening socket.
+   * @private
+   */
+  void arm_accept();
+
+  /**
+   * Submits a multishot poll on the wakeup eventfd.
+   * @private
+   */
+  void arm_wake();
+
+  /**
+   * Submits a multishot receive into the provided buffer ring.
+   * @private
+   */
+  void arm_receive(Connection &connection);
+
+  /**
+   * Sends the rest of the connection's in-flight bytes. If no response can follow, links a
+   * close to the send, so the final response and the close cost one submission.
+   * @private
+   */
+  void submit_send(Connection &connection);
+
+  /**
+   * Reads the next chunk of the leading file response into the send buffer, to be sent once
+   * the read completes.
+   * @private
+   */
+  void submit_file_read(Connection &connection);
+
+  /**
+   * io_uring counterpart of flush_socket: starts a send if none is in flight, closes a drained
+   * connection that was marked to close, and re-arms a paused or terminated receive.
+   * @private
+   */
+  void flush_ring(Connection &connection);
+
+  /**
+   * Starts tearing down a connection with operations still in flight.
+   * @private
+   * @return True if the kernel holds no more references to the connection's memory.
+   */
+  bool close_ring(Connection &connection);
+
+  /**
+   * Cancels every operation still in flight and waits, up to a second, for the kernel to finish
+   * with each connection, before the ring and the connections are destroyed.
+   * @private
+   */
+  void drain_ring();
+
+  /**
+   * Accepts every pending connection on the listening socket.
+   * @private
+   */
+  void accept_connections();
+
+  /**
+   * Counts a failed accept and stops accepting until ACCEPT_BACKOFF_ passed, so that running
+   * out of descriptors does not spin the event loop.
+   * @private
+   */
+  void pause_accept();
+
+  /**
+   * Accepts again once a paused accept's backoff passed, or a closed connection freed a
+   * descriptor.
+   * @private
+   */
+  void resume_accept();
+
+  /**
+   * Drains the client socket and handles the request once it has fully arrived.
+   * @private
+   */
+  void handle_readable(Connection &connection);
+
+  /**
+   * Frames and dispatches every complete request in the read buffer, in order, until the rest of
+   * the buffer is an incomplete request or MAX_PIPELINED_REQUESTS_ are in flight.
+   * Responses are only queued; the caller flushes them together.
+   * @private
+   */
+  void process_requests(Connection &connection);
+
+  /**
+   * Answers a request that cannot be handled with an error status, and closes the connection.
+   * @private
+   */
+  void reject_request(Connection &connection, int status);
+
+  /**
+   * Processes the buffered request, inline or on the worker pool, and queues the response.
+   * @param body Stream to hand the body on through, once only the headers arrived, or nullptr
+   * if the whole request is buffered.
+   * @private
+   */
+  void handle_connection(Connection &connection, std::shared_ptr<BodyStream> body = nullptr);
+
+  /**
+   * Returns the body options of the route the request whose headers were just framed goes to.
+   * @private
+   */
+  const BodyOptions *route_body_options(Connection &connection);
+
+  /**
+   * Creates the stream a request's body is handed to its handler through.
+   * @private
+   */
+  std::shared_ptr<BodyStream> open_body_stream(Connection &connection);
+
+  /**
+   * Hands whatever part of the streamed body arrived to the handler, unless it has yet to take
+   * what it was given before.
+   * @private
+   * @return True once the whole body was handed on, so the next request can be framed.
+   */
+  bool receive_body(Connection &connection);
+
+  /**
+   * Ends the streamed body early, so the handler's next read throws with the given status, and
+   * closes the connection once its response is written.
+   * @private
+   */
+  void fail_body(Connection &connection, int status);
+
+  /**
+   * Returns how many bytes the connection may buffer: room for a request's headers, its body
+   * unless that is streamed, and one more read.
+   * @private
+   */
+  size_t max_read_buffer(Connection &connection);
+
+  /**
+   * Decides whether the connection may stay open after answering this request, from the
+   * HTTP version, the Connection header, and the per-connection request limit.
+   * @private
+   */
+  bool should_keep_alive(Connection &connection, const Request &request);
+
+  /**
+   * Creates the response for the request with the given sequence number, writing to the
+   * connection directly on the I/O thread, or through completions from a worker thread.
+   * @private
+   */
+  Response make_response(uint64_t connection_id, uint64_t sequence);
+
+  /**
+   * Runs the router on the current thread. If a coroutine handler suspends, the exchange moves
+   * into a detached coroutine that finishes it once the handlers complete. Exceptions thrown by
+   * handlers are answered rather than let out of the I/O or worker thread.
+   * @private
+   */
+  void dispatch(std::unique_ptr<Exchange> exchange);
+
+  /**
+   * Awaits the handlers of a suspended exchange, answering any exception they throw.
+   * @private
+   */
+  DetachedTask serve(std::unique_ptr<Exchange> exchange, Task<> handlers);
+
+  /**
+   * Answers an exception thrown by a handler that did not send a response yet: BodyError with
+   * its status, anything else with 500.
+   * @private
+   */
+  static void answer_exception(Response &response, const std::exception &error);
+
+  /**
+   * Answers 404 if no handler sent a response, ends a streamed body, and completes the response.
+   * @private
+   */
+  void finish_exchange(Exchange &exchange);
+
+  /**
+   * Moves expired timers to the ready list, then resumes every ready coroutine handler, inline
+   * or on the worker pool, and flushes the connections they wrote to.
+   * @private
+   */
+  void resume_ready();
+
+  /**
+   * Returns how long the event loop may block: until the next timer, or not at all if
+   * coroutine handlers are ready to resume.
+   * @private
+   */
+  std::chrono::milliseconds next_timeout();
+
+  /**
+   * Hands every coroutine handler waiting on the connection's output to the ready list.
+   * @private
+   */
+  void wake_drain_waiters(Connection &connection);
+
+  /**
+   * Resumes handlers still suspended when the server is destroyed, once, so their frames are
+   * freed. Their writes are dropped and sleep_for throws.
+   * @private
+   */
+  void resume_abandoned();
+
+  /**
+   * Marks the response with the given sequence number as complete, and counts every request
+   * answered by it reaching the head of the response order.
+   * @private
+   */
+  void complete_response(Connection &connection, uint64_t sequence);
+
+  /**
+   * Closes persistent connections that sat idle for longer than the keep-alive timeout.
+   * @private
+   */
+  void close_idle_connections();
+
+  /**
+   * Queues a worker's output for the I/O thread and wakes the event loop.
+   * Called from worker threads.
+   * @private
+   */
+  void post_completion(Completion completion);
+
+  /**
+   * Queues every posted completion on its connection, if that connection is still open, then
+   * flushes each touched connection once.
+   * @private
+   */
+  void drain_completions();
+
+  /**
+   * Flushes each connection once, resuming reads and framing queued pipelined requests.
    * @private
    */
-  void handle_connection();
+  void service_connections(std::vector<uint64_t> &connection_ids);
 
   /**
-   * Reads the raw data chunk-by-chunk into buffer.
+   * Reads all available data chunk-by-chunk into the connection's read buffer.
+   * Stops early, setting read_paused, once the buffer reaches max_read_buffer().
    * @private
-   * @return Total number of bytes read.
+   * @return Total number of bytes read, or -1 if the peer closed or the read failed.
    */
-  int read_socket(std::vector<char> &buffer);
+  int read_socket(Connection &connection);
 
   /**
-   * Writes given bytes to the socket.
+   * Writes as much of the connection's queued bytes as the socket accepts, in a single send
+   * when the socket has room.
+   * Closes the connection if it was marked to close, once drained and no request is in flight.
    * @private
    */
-  void write_socket(std::vector<char> content);
+  void flush_socket(Connection &connection);
 
   /**
-   * Closes the socket and ends the connection.
+   * Deregisters and closes the connection. With io_uring, the connection lingers until its
+   * in-flight operations complete.
    * @private
    */
-  void close_socket();
+  void close_socket(Connection &connection);
 
   /**
-   * Reads incoming request into buffer, before returning as parsed Request object.
+   * Parses the framed request at the front of the read buffer, and drops it from the buffer.
+   * @param body Stream the body follows through, in which case only the headers are parsed.
    * @private
-   * @return Pointer to the parsed Request object.
+   * @return The parsed Request object.
    */
-  std::unique_ptr<express::Request> read_request();
+  express::Request read_request(Connection &connection, std::shared_ptr<BodyStream> body);
 };
 }; // namespace express
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,373 @@
+#include "server.h"
+#include <algorithm>
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+namespace {
+/** Operation a submission performs, kept in the low byte of its user_data */
+enum RingOperation : uint8_t { ACCEPT, WAKE, RECEIVE, SEND, READ, CLOSE, CANCEL, CANCEL_ALL };
+
+uint64_t ring_tag(uint64_t connection_id, RingOperation operation) {
+  return (connection_id << 8) | operation;
+}
+} // namespace
+
+void express::Server::run_io_uring() {
+  arm_accept();
+  arm_wake();
+
+  io_uring_cqe completion;
+  while (is_running) {
+    // Everything queued since the last wakeup goes to the kernel with the wait itself
+    ring_->submit_and_wait(next_timeout());
+    refresh_router();
+    while (ring_->next_completion(completion)) {
+      handle_ring_completion(completion);
+    }
+    close_idle_connections();
+    resume_accept();
+    resume_ready();
+  }
+}
+
+void express::Server::handle_ring_completion(const io_uring_cqe &completion) {
+  auto operation = static_cast<RingOperation>(completion.user_data & 0xff);
+  uint64_t id = completion.user_data >> 8;
+  bool more = completion.flags & IORING_CQE_F_MORE;
+
+  if (operation == ACCEPT) {
+    if (completion.res >= 0) {
+      uint64_t connection_id = next_connection_id_++;
+      connections_[connection_id] =
+          std::make_unique<Connection>(completion.res, connection_id, options_.max_body_size);
+      counters_.connections_accepted.fetch_add(1, std::memory_order_relaxed);
+      counters_.open_connections.fetch_add(1, std::memory_order_relaxed);
+      arm_receive(*connections_[connection_id]);
+    }
+    if (completion.res < 0 && !more) {
+      pause_accept(); // Re-arming right away would fail again, e.g. on EMFILE
+    } else if (completion.res < 0) {
+      counters_.accept_errors.fetch_add(1, std::memory_order_relaxed);
+    } else if (!more) {
+      arm_accept(); // Multishot accept ended, e.g. on a full completion queue
+    }
+    return;
+  }
+  if (operation == WAKE) {
+    drain_completions();
+    if (!more) {
+      arm_wake();
+    }
+    return;
+  }
+
+  auto it = connections_.find(id);
+  if (it == connections_.end()) {
+    if (completion.flags & IORING_CQE_F_BUFFER) {
+      ring_->recycle_buffer(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+    }
+    return;
+  }
+  Connection &connection = *it->second;
+  if (!more) {
+    connection.ring.pending_operations--;
+  }
+
+  switch (operation) {
+    case RECEIVE:
+      if (!more) {
+        connection.ring.receiving = false;
+      }
+      handle_ring_receive(connection, completion);
+      break;
+    case SEND:
+      handle_ring_send(connection, completion.res);
+      break;
+    case READ:
+      handle_ring_read(connection, completion.res);
+      break;
+    case CLOSE:
+      if (completion.res >= 0) {
+        connection.release(); // Closed by the linked operation, not by the destructor
+      }
+      break;
+    default:
+      break;
+  }
+
+  // Handlers may have closed the connection, so look it up again
+  it = connections_.find(id);
+  if (it != connections_.end() && it->second->ring.closing &&
+      it->second->ring.pending_operations == 0) {
+    close_socket(*it->second);
+  }
+}
+
+void express::Server::handle_ring_receive(Connection &connection,
+                                          const io_uring_cqe &completion) {
+  int result = completion.res;
+  if (completion.flags & IORING_CQE_F_BUFFER) {
+    uint16_t buffer_id = completion.flags >> IORING_CQE_BUFFER_SHIFT;
+    if (result > 0 && !connection.ring.closing) {
+      connection.compact_read_buffer();
+      std::vector<char> &buffer = connection.read_buffer();
+      char *data = ring_->buffer(buffer_id);
+      buffer.insert(buffer.end(), data, data + result);
+      counters_.bytes_read.fetch_add(result, std::memory_order_relaxed);
+    }
+    ring_->recycle_buffer(buffer_id); // Copied out, the kernel may reuse it right away
+  }
+  if (connection.ring.closing)
+    return;
+
+  // ENOBUFS: ran out of provided buffers. ECANCELED: paused. Both re-arm from flush_ring
+  if (result == 0 || (result < 0 && result != -ENOBUFS && result != -ECANCELED)) {
+    connection.close_after_write = true; // Still answer a request that arrived before the FIN
+    connection.peer_closed = true;
+  }
+
+  process_requests(connection);
+  if (connection.unread_size() >= max_read_buffer(connection)) {
+    if (connection.requests_in_flight == 0 && connection.keep_alive) {
+      reject_request(connection, 413); // Full buffer, yet not one complete request
+    } else if (!connection.read_paused) {
+      connection.read_paused = true; // Resumed by flush_ring once the requests are consumed
+      if (connection.ring.receiving) {
+        io_uring_sqe *sqe = ring_->get_sqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = ring_tag(connection.id(), RECEIVE);
+        sqe->user_data = ring_tag(connection.id(), CANCEL);
+        connection.ring.pending_operations++;
+      }
+    }
+  }
+  flush_socket(connection);
+}
+
+void express::Server::handle_ring_send(Connection &connection, int result) {
+  if (result > 0) {
+    counters_.bytes_written.fetch_add(result, std::memory_order_relaxed);
+  }
+  if (connection.ring.closing)
+    return; // Final send with a linked close, or a send cut short by close_ring
+
+  if (result < 0) {
+    connection.ring.sending.clear(); // Drop what can never be delivered
+    connection.discard_output();
+    connection.close_after_write = true;
+    flush_socket(connection);
+    return;
+  }
+
+  connection.ring.sent += result;
+  size_t total = 0;
+  for (const OutputSegment &segment : connection.ring.sending) {
+    total += segment.size();
+  }
+  if (connection.ring.sent < total) {
+    submit_send(connection);
+    return;
+  }
+  connection.ring.sending.clear();
+  flush_socket(connection);
+}
+
+void express::Server::submit_file_read(Connection &connection) {
+  // The ring has no sendfile, so files are copied through the send buffer a chunk at a time.
+  // The kernel reads them off the reactor thread, from a worker if the pages are not cached
+  OutputSegment &file = connection.output().front();
+  connection.ring.sending.emplace_back(
+      std::vector<char>(std::min(file.file_remaining, FILE_CHUNK_SIZE_)));
+  std::vector<char> &chunk = connection.ring.sending.back().bytes;
+
+  io_uring_sqe *sqe = ring_->get_sqe();
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = file.file_fd;
+  sqe->off = file.file_offset;
+  sqe->addr = reinterpret_cast<uint64_t>(chunk.data());
+  sqe->len = chunk.size();
+  sqe->user_data = ring_tag(connection.id(), READ);
+  connection.ring.pending_operations++;
+}
+
+void express::Server::handle_ring_read(Connection &connection, int result) {
+  if (connection.ring.closing)
+    return;
+  if (result <= 0) {
+    // File shrank below the Content-Length already sent
+    connection.ring.sending.clear();
+    connection.discard_output();
+    connection.close_after_write = true;
+    close_socket(connection);
+    return;
+  }
+  connection.ring.sending.back().bytes.resize(result);
+  connection.consume_written(result); // Advances the file range, closing it once read
+  connection.ring.sent = 0;
+  submit_send(connection);
+}
+
+void express::Server::arm_accept() {
+  io_uring_sqe *sqe = ring_->get_sqe();
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = socket_->sock();
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->accept_flags = SOCK_CLOEXEC;
+  sqe->user_data = ring_tag(0, ACCEPT);
+}
+
+void express::Server::arm_wake() {
+  io_uring_sqe *sqe = ring_->get_sqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = wake_fd_;
+  sqe->poll32_events = POLLIN;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = ring_tag(0, WAKE);
+}
+
+void express::Server::arm_receive(Connection &connection) {
+  io_uring_sqe *sqe = ring_->get_sqe();
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = connection.fd();
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = IoUring::BUFFER_GROUP_;
+  sqe->user_data = ring_tag(connection.id(), RECEIVE);
+  connection.ring.receiving = true;
+  connection.ring.pending_operations++;
+}
+
+void express::Server::submit_send(Connection &connection) {
+  Connection::RingState &ring = connection.ring;
+
+  // Gather the unsent part of every in-flight buffer; the kernel reads them in place
+  ring.iovecs.clear();
+  size_t skip = ring.sent;
+  for (OutputSegment &segment : ring.sending) {
+    if (skip >= segment.size()) {
+      skip -= segment.size();
+      continue;
+    }
+    ring.iovecs.push_back({const_cast<char *>(segment.data()) + skip, segment.size() - skip});
+    skip = 0;
+  }
+  ring.message = {};
+  ring.message.msg_iov = ring.iovecs.data();
+  ring.message.msg_iovlen = ring.iovecs.size();
+
+  bool last = connection.close_after_write && connection.requests_in_flight == 0 &&
+              connection.output().empty();
+
+  if (last && connection.ring.receiving) {
+    io_uring_sqe *cancel = ring_->get_sqe();
+    cancel->opcode = IORING_OP_ASYNC_CANCEL;
+    cancel->addr = ring_tag(connection.id(), RECEIVE);
+    cancel->user_data = ring_tag(connection.id(), CANCEL);
+    connection.ring.pending_operations++;
+  }
+
+  io_uring_sqe *sqe = ring_->get_sqe();
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = connection.fd();
+  sqe->addr = reinterpret_cast<uint64_t>(&ring.message);
+  sqe->len = 1;
+  sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->user_data = ring_tag(connection.id(), SEND);
+  connection.ring.pending_operations++;
+  if (!last)
+    return;
+
+  // A short send fails the link and cancels the close; the destructor closes instead
+  sqe->msg_flags |= MSG_WAITALL;
+  sqe->flags = IOSQE_IO_LINK;
+  io_uring_sqe *close_sqe = ring_->get_sqe();
+  close_sqe->opcode = IORING_OP_CLOSE;
+  close_sqe->fd = connection.fd();
+  close_sqe->user_data = ring_tag(connection.id(), CLOSE);
+  connection.ring.pending_operations++;
+  connection.ring.closing = true;
+}
+
+void express::Server::flush_ring(Connection &connection) {
+  if (connection.ring.closing)
+    return;
+  if (!connection.has_pending_writes()) {
+    wake_drain_waiters(connection);
+  }
+
+  if (connection.ring.sending.empty()) {
+    if (!connection.output().empty()) {
+      // Responses queued from now on collect in the output while these buffers are in flight
+      if (connection.output().front().is_file()) {
+        submit_file_read(connection);
+      } else {
+        connection.take_output(connection.ring.sending, MAX_IOVECS_);
+        connection.ring.sent = 0;
+        submit_send(connection);
+      }
+    } else if (connection.close_after_write && connection.requests_in_flight == 0) {
+      close_socket(connection);
+      return;
+    }
+  }
+
+  // A streamed body is still read after a request asked to close the connection
+  bool reading = !connection.close_after_write ||
+                 (connection.body_stream != nullptr && !connection.peer_closed);
+  if (!connection.ring.receiving && !connection.ring.closing && reading) {
+    connection.compact_read_buffer();
+    if (connection.unread_size() < max_read_buffer(connection)) {
+      connection.read_paused = false;
+      arm_receive(connection);
+    }
+  }
+}
+
+bool express::Server::close_ring(Connection &connection) {
+  if (!connection.ring.closing) {
+    connection.ring.closing = true;
+    if (connection.ring.pending_operations > 0) {
+      // Ends the multishot receive and any send stuck on a peer that stopped reading
+      shutdown(connection.fd(), SHUT_RDWR);
+    }
+  }
+  return connection.ring.pending_operations == 0;
+}
+
+void express::Server::drain_ring() {
+  // A close linked to a send could otherwise still run once the ring is gone, on a descriptor
+  // that the connection's destructor closed and something else has reopened since
+  io_uring_sqe *sqe = ring_->get_sqe();
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL | IORING_ASYNC_CANCEL_ANY;
+  sqe->user_data = ring_tag(0, CANCEL_ALL);
+
+  auto pending = [this]() {
+    return std::any_of(connections_.begin(), connections_.end(), [](const auto &entry) {
+      return entry.second->ring.pending_operations > 0;
+    });
+  };
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  io_uring_cqe completion;
+  do {
+    ring_->submit_and_wait(std::chrono::milliseconds(10));
+    while (ring_->next_completion(completion)) {
+      if (completion.flags & IORING_CQE_F_BUFFER) {
+        ring_->recycle_buffer(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+      }
+      auto operation = static_cast<RingOperation>(completion.user_data & 0xff);
+      auto it = connections_.find(completion.user_data >> 8);
+      if (operation == ACCEPT || operation == WAKE || operation == CANCEL_ALL ||
+          it == connections_.end())
+        continue;
+      if (!(completion.flags & IORING_CQE_F_MORE)) {
+        it->second->ring.pending_operations--;
+      }
+      if (operation == CLOSE && completion.res >= 0) {
+        it->second->release();
+      }
+    }
+  } while (pending() && std::chrono::steady_clock::now() < deadline);
+}
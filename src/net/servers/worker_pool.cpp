@@ -0,0 +1,87 @@
+#include "worker_pool.h"
+
+express::WorkerPool::WorkerPool(size_t thread_count) {
+  for (size_t i = 0; i < thread_count; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < thread_count; i++) {
+    threads_.emplace_back(&WorkerPool::run, this, i);
+  }
+}
+
+express::WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread &thread : threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+void express::WorkerPool::submit(Job job) {
+  size_t index = next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+  {
+    std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+    workers_[index]->jobs.push_back(std::move(job));
+  }
+  queued_.fetch_add(1);
+
+  // Both counters are sequentially consistent, so either a worker going to sleep sees the job
+  // or this sees the worker idle. Only then is the lock taken, so that the worker is not
+  // between checking queued_ and waiting when it is notified.
+  if (idle_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    wake_.notify_one();
+  }
+}
+
+size_t express::WorkerPool::size() {
+  return threads_.size();
+}
+
+void express::WorkerPool::run(size_t index) {
+  while (true) {
+    Job job;
+    if (take_job(index, job)) {
+      queued_--;
+      job();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    idle_.fetch_add(1);
+    wake_.wait(lock, [this]() {
+      return stopping_ || queued_ > 0;
+    });
+    idle_.fetch_sub(1);
+    if (stopping_ && queued_ == 0)
+      return;
+  }
+}
+
+bool express::WorkerPool::take_job(size_t index, Job &job) {
+  {
+    Worker &own = *workers_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.jobs.empty()) {
+      job = std::move(own.jobs.front());
+      own.jobs.pop_front();
+      return true;
+    }
+  }
+
+  for (size_t offset = 1; offset < workers_.size(); offset++) {
+    Worker &victim = *workers_[(index + offset) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.jobs.empty()) {
+      job = std::move(victim.jobs.back());
+      victim.jobs.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
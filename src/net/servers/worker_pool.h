@@ -0,0 +1,86 @@
+#ifndef EXPRESS_WORKER_POOL_H
+#define EXPRESS_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace express {
+/**
+ * Fixed-size pool of threads running route handlers off the I/O thread.
+ * Every worker owns a deque of jobs; idle workers steal from the back of their peers' deques.
+ */
+class WorkerPool {
+public:
+  using Job = std::function<void()>;
+
+  explicit WorkerPool(size_t thread_count);
+
+  /**
+   * Runs every job still queued, then joins the worker threads.
+   */
+  ~WorkerPool();
+
+  /**
+   * Queues a job on the next worker's deque, round-robin, and wakes an idle worker.
+   */
+  void submit(Job job);
+
+  /**
+   * Returns the number of worker threads.
+   */
+  size_t size();
+
+  // Rule of 5
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+  WorkerPool(WorkerPool &&) = delete;
+  WorkerPool &operator=(WorkerPool &&) = delete;
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  /** Per-worker job deques, indexed like threads_ */
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  /** Worker threads */
+  std::vector<std::thread> threads_;
+
+  /** Round-robin cursor for submit() */
+  std::atomic<size_t> next_worker_{0};
+
+  /** Number of jobs queued across all deques */
+  std::atomic<size_t> queued_{0};
+
+  /** Number of workers sleeping or about to, so submit() only wakes one when there is one */
+  std::atomic<size_t> idle_{0};
+
+  /** Guards sleeping and waking idle workers */
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+
+  /**
+   * Worker loop: runs own jobs first, steals when empty, and sleeps when nothing is queued.
+   * @private
+   */
+  void run(size_t index);
+
+  /**
+   * Pops the oldest job from the worker's own deque, or steals the newest from a peer.
+   * @private
+   * @return True if a job was taken.
+   */
+  bool take_job(size_t index, Job &job);
+};
+} // namespace express
+
+#endif
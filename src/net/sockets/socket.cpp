@@ -1,6 +1,7 @@
 #include "socket.h"
 #include <cerrno>
 #include <cstring>
+#include <fcntl.h>
 #include <string>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -19,6 +20,11 @@ express::Socket::Socket(SocketConfig config) {
   // Enable address reuse for all socket types
   int opt = 1;
   setsockopt(sock_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+  // Share the port with sibling listeners, one per reactor thread
+  if (config.reuse_port) {
+    test_connection(setsockopt(sock_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)));
+  }
 }
 
 express::Socket::~Socket() {
@@ -48,4 +54,9 @@ int express::Socket::sock() {
 // Setter functions
 void express::Socket::set_connection(int con) {
   connection_ = con;
+}
+void express::Socket::set_non_blocking() {
+  int flags = fcntl(sock_, F_GETFL, 0);
+  test_connection(flags);
+  test_connection(fcntl(sock_, F_SETFL, flags | O_NONBLOCK));
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define EXPRESS_SOCKET_H
 
 #include "socket_error.h"
+#include <cstring>
 #include <iostream>
 #include <netinet/in.h>
 #include <stdio.h>
@@ -15,6 +16,7 @@ struct SocketConfig {
   int port;
   u_long interface;
   int backlog;
+  bool reuse_port = false; // Lets several sockets bind the same port, kernel balances accepts
 };
 
 class Socket {
@@ -26,6 +28,7 @@ public:
   struct sockaddr_in address();
   int sock();
   void set_connection(int);
+  void set_non_blocking();
 
 private:
   struct sockaddr_in address_;
@@ -1,6 +1,10 @@
 #ifndef EXPRESS_CONSTANTS_H
 #define EXPRESS_CONSTANTS_H
 
+#include <cstddef>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
 namespace express {
 namespace constants {
 // Size constants
@@ -8,6 +12,7 @@ static constexpr size_t KB_ = 1024;
 static constexpr size_t MB_ = KB_ * 1024;
 static constexpr size_t GB_ = MB_ * 1024;
 static constexpr size_t MAX_REQUEST_SIZE_ = 1 * MB_;
+static constexpr size_t MAX_HEADER_SIZE_ = 64 * KB_;
 
 // Time conversions
 static constexpr int MILLISECONDS_IN_MICROSECONDS = 1000;
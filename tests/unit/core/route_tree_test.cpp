@@ -0,0 +1,153 @@
+#include "core/route_tree.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace express {
+namespace test {
+
+class RouteTreeFixture : public ::testing::Test {
+protected:
+  RouteTree<std::string> tree;
+  RouteTree<std::string>::Params params;
+
+  void add(const std::string &pattern) { tree.insert(pattern) = pattern; }
+
+  std::string find(std::string_view path) {
+    params.clear();
+    const std::string *found = tree.find(path, params);
+    return found ? *found : "<none>";
+  }
+};
+
+TEST_F(RouteTreeFixture, MatchesStaticRoutesSharingPrefixes) {
+  add("/");
+  add("/users");
+  add("/user");
+  add("/uploads/new");
+
+  EXPECT_EQ(find("/"), "/");
+  EXPECT_EQ(find("/users"), "/users");
+  EXPECT_EQ(find("/user"), "/user");
+  EXPECT_EQ(find("/uploads/new"), "/uploads/new");
+  EXPECT_EQ(find("/use"), "<none>");
+  EXPECT_EQ(find("/uploads"), "<none>");
+}
+
+TEST_F(RouteTreeFixture, IgnoresTrailingSlash) {
+  add("/users/");
+  EXPECT_EQ(find("/users"), "/users/");
+  EXPECT_EQ(find("/users/"), "/users/");
+}
+
+TEST_F(RouteTreeFixture, CapturesParameters) {
+  add("/users/:id/posts/:post");
+  EXPECT_EQ(find("/users/42/posts/7"), "/users/:id/posts/:post");
+  EXPECT_EQ(params["id"], "42");
+  EXPECT_EQ(params["post"], "7");
+  EXPECT_EQ(find("/users//posts/7"), "<none>");
+}
+
+TEST_F(RouteTreeFixture, ParameterValuesViewThePath) {
+  add("/files/:name");
+  std::string path = "/files/report.pdf";
+  ASSERT_EQ(find(path), "/files/:name");
+  EXPECT_EQ(params["name"].data(), path.data() + 7);
+}
+
+TEST_F(RouteTreeFixture, PrefersStaticThenParameterThenWildcard) {
+  add("/users/new");
+  add("/users/:id");
+  add("/users/*rest");
+
+  EXPECT_EQ(find("/users/new"), "/users/new");
+  EXPECT_EQ(find("/users/newer"), "/users/:id");
+  EXPECT_EQ(params["id"], "newer");
+  EXPECT_EQ(find("/users/1/avatar"), "/users/*rest");
+  EXPECT_EQ(params["rest"], "1/avatar");
+}
+
+TEST_F(RouteTreeFixture, BacktracksOutOfDeadEnds) {
+  add("/users/new/edit");
+  add("/users/:id/settings");
+
+  EXPECT_EQ(find("/users/new/settings"), "/users/:id/settings");
+  EXPECT_EQ(params["id"], "new");
+  EXPECT_EQ(params.size(), 1u);
+}
+
+TEST_F(RouteTreeFixture, WildcardCapturesRest) {
+  add("/static/*");
+  EXPECT_EQ(find("/static/css/site.css"), "/static/*");
+  EXPECT_EQ(params["*"], "css/site.css");
+}
+
+TEST_F(RouteTreeFixture, ColonInsideSegmentIsStatic) {
+  add("/time/12:30");
+  EXPECT_EQ(find("/time/12:30"), "/time/12:30");
+  EXPECT_TRUE(params.empty());
+}
+
+TEST_F(RouteTreeFixture, RepeatedPatternReturnsSameValue) {
+  tree.insert("/a/:id") += "x";
+  tree.insert("/a/:id/") += "y";
+  EXPECT_EQ(find("/a/1"), "xy");
+}
+
+TEST_F(RouteTreeFixture, RejectsMalformedPatterns) {
+  EXPECT_THROW(tree.insert("/users/:/posts"), std::invalid_argument);
+  EXPECT_THROW(tree.insert("/files/*path/more"), std::invalid_argument);
+  add("/files/*path");
+  EXPECT_THROW(tree.insert("/files/*other"), std::invalid_argument);
+}
+
+TEST_F(RouteTreeFixture, VisitsEveryPattern) {
+  add("/users");
+  add("/users/:id");
+  add("/user/settings");
+  add("/static/*");
+  add("/files/*path");
+
+  std::vector<std::string> patterns;
+  tree.for_each([&patterns](const std::string &pattern, const std::string &value) {
+    EXPECT_EQ(pattern, value);
+    patterns.push_back(pattern);
+  });
+  EXPECT_EQ(patterns.size(), 5u);
+}
+
+TEST_F(RouteTreeFixture, ErasedPatternsNoLongerMatch) {
+  add("/users/new");
+  add("/users/:id");
+  add("/users/*rest");
+
+  EXPECT_TRUE(tree.erase("/users/new/"));
+  EXPECT_EQ(find("/users/new"), "/users/:id");
+  EXPECT_TRUE(tree.erase("/users/*rest"));
+  EXPECT_EQ(find("/users/1/avatar"), "<none>");
+  EXPECT_EQ(find("/users/1"), "/users/:id");
+
+  EXPECT_FALSE(tree.erase("/users/new"));
+  EXPECT_FALSE(tree.erase("/users/:name"));
+  EXPECT_FALSE(tree.erase("/users/ne"));
+  EXPECT_FALSE(tree.erase("/missing"));
+
+  std::vector<std::string> patterns;
+  tree.for_each([&patterns](const std::string &pattern, const std::string &) {
+    patterns.push_back(pattern);
+  });
+  EXPECT_EQ(patterns, std::vector<std::string>{"/users/:id"});
+}
+
+TEST_F(RouteTreeFixture, ManyRoutesStillMatch) {
+  for (int i = 0; i < 400; i++) {
+    add("/api/v1/resource" + std::to_string(i) + "/:id");
+  }
+  EXPECT_EQ(find("/api/v1/resource123/9"), "/api/v1/resource123/:id");
+  EXPECT_EQ(params["id"], "9");
+  EXPECT_EQ(find("/api/v1/resource400/9"), "<none>");
+}
+
+} // namespace test
+} // namespace express
@@ -0,0 +1,84 @@
+#include "core/router.h"
+#include "core/router_slot.h"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace express {
+namespace test {
+
+class SlotResponse : public Response {
+public:
+  SlotResponse() : Response([](std::vector<char>) {}) {}
+};
+
+class RouterSlotFixture : public ::testing::Test {
+protected:
+  Request request{"GET /flag HTTP/1.1\r\nHost: localhost\r\n\r\n"};
+  SlotResponse response;
+  std::vector<std::string> calls;
+
+  std::shared_ptr<const CompiledRouter> table(const std::string &name) {
+    Router router;
+    router.get("/flag", [this, name](Request &, Response &) { calls.push_back(name); });
+    return router.compile();
+  }
+};
+
+TEST_F(RouterSlotFixture, PublishReplacesTableAndBumpsVersion) {
+  RouterSlot slot(table("old"));
+  uint64_t version = slot.version();
+  slot.load()->run(request, response);
+
+  slot.publish(table("new"));
+  EXPECT_NE(slot.version(), version);
+  slot.load()->run(request, response);
+  EXPECT_EQ(calls, (std::vector<std::string>{"old", "new"}));
+}
+
+TEST_F(RouterSlotFixture, PinnedTableOutlivesReplacement) {
+  RouterSlot slot(table("old"));
+  std::shared_ptr<const CompiledRouter> pinned = slot.load();
+  std::weak_ptr<const CompiledRouter> watched = pinned;
+
+  slot.publish(table("new"));
+  EXPECT_FALSE(watched.expired());
+  pinned->run(request, response);
+  pinned.reset();
+  EXPECT_TRUE(watched.expired());
+  EXPECT_EQ(calls, std::vector<std::string>{"old"});
+}
+
+TEST_F(RouterSlotFixture, ReadersSeeEveryTableWhilePublishing) {
+  RouterSlot slot(table("0"));
+  std::atomic<bool> done{false};
+  std::atomic<size_t> reloads{0};
+  std::thread reader([&]() {
+    uint64_t seen = slot.version();
+    std::shared_ptr<const CompiledRouter> current = slot.load();
+    while (!done) {
+      uint64_t version = slot.version();
+      if (version != seen) {
+        current = slot.load();
+        seen = version;
+        reloads++;
+      }
+      ASSERT_NE(current, nullptr);
+    }
+  });
+  for (int i = 1; i <= 100; i++) {
+    slot.publish(table(std::to_string(i)));
+  }
+  done = true;
+  reader.join();
+  EXPECT_LE(reloads.load(), 100u);
+
+  slot.load()->run(request, response);
+  EXPECT_EQ(calls, std::vector<std::string>{"100"});
+}
+
+} // namespace test
+} // namespace express
@@ -0,0 +1,490 @@
+#include "core/router.h"
+#include "http/body_stream.h"
+#include <express/static_routes.h>
+#include <express/task.h>
+#include <gtest/gtest.h>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace express {
+namespace test {
+
+class RouterResponse : public Response {
+public:
+  RouterResponse(std::function<void(const std::vector<char> &)> write_to_socket)
+      : Response(write_to_socket) {}
+};
+
+/** Eagerly started coroutine, for driving lazy tasks to completion in tests */
+struct Driver {
+  struct promise_type {
+    Driver get_return_object() { return {}; }
+    std::suspend_never initial_suspend() { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+template <typename T> Driver drive(Task<T> &task, std::optional<T> &result) {
+  result = co_await task;
+}
+
+Driver drive(Task<> &task, bool &threw) {
+  try {
+    co_await task;
+  } catch (const std::exception &) {
+    threw = true;
+  }
+}
+
+Task<int> answer() {
+  co_return 42;
+}
+
+Task<int> add_one() {
+  int value = co_await answer();
+  co_return value + 1;
+}
+
+Task<> fail() {
+  throw std::runtime_error("handler failed");
+  co_return;
+}
+
+TEST(TaskTest, IsLazy) {
+  Task<int> task = answer();
+  EXPECT_TRUE(task);
+  EXPECT_FALSE(task.done());
+}
+
+TEST(TaskTest, ReturnsValue) {
+  Task<int> task = add_one();
+  std::optional<int> result;
+  drive(task, result);
+  EXPECT_TRUE(task.done());
+  EXPECT_EQ(result, 43);
+}
+
+TEST(TaskTest, RethrowsToAwaiter) {
+  Task<> task = fail();
+  bool threw = false;
+  drive(task, threw);
+  EXPECT_TRUE(threw);
+}
+
+TEST(TaskTest, SleepOutsideServerThrows) {
+  Task<> task = []() -> Task<> { co_await sleep_for(std::chrono::milliseconds(1)); }();
+  bool threw = false;
+  drive(task, threw);
+  EXPECT_TRUE(threw);
+}
+
+class RouterFixture : public ::testing::Test {
+protected:
+  Request request{"GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"};
+  RouterResponse response{[](const std::vector<char> &) {}};
+  std::vector<std::string> calls;
+  std::shared_ptr<const CompiledRouter> compiled;
+
+  /** Compiles the router as it is now and runs the request through it */
+  Task<> run(const Router &router, Request &request, Response &response) {
+    compiled = router.compile();
+    return compiled->run(request, response);
+  }
+};
+
+TEST_F(RouterFixture, SynchronousHandlersRunInline) {
+  Router router;
+  router.get("/", [this](Request &, Response &) { calls.push_back("sync"); });
+  Task<> task = run(router, request, response);
+  EXPECT_FALSE(task);
+  EXPECT_EQ(calls, std::vector<std::string>{"sync"});
+}
+
+TEST_F(RouterFixture, CoroutineHandlerDefersRemainingHandlers) {
+  Router router;
+  router.get("/", [this](Request &, Response &) { calls.push_back("first"); });
+  router.get("/", [this](Request &, Response &) -> Task<> {
+    calls.push_back("async");
+    co_return;
+  });
+  router.get("/", [this](Request &, Response &) { calls.push_back("last"); });
+
+  Task<> task = run(router, request, response);
+  ASSERT_TRUE(task);
+  EXPECT_EQ(calls, std::vector<std::string>{"first"});
+
+  bool threw = false;
+  drive(task, threw);
+  EXPECT_FALSE(threw);
+  EXPECT_EQ(calls, (std::vector<std::string>{"first", "async", "last"}));
+}
+
+TEST_F(RouterFixture, DispatchesOnPathAndCapturesParameters) {
+  Request nested("GET /users/42/posts HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Router router;
+  router.get("/", [this](Request &, Response &) { calls.push_back("root"); });
+  router.get("/users/:id/posts", [this](Request &request, Response &) {
+    calls.emplace_back(request.params["id"]);
+  });
+  router.post("/users/:id/posts", [this](Request &, Response &) { calls.push_back("post"); });
+
+  EXPECT_FALSE(run(router, nested, response));
+  EXPECT_EQ(calls, std::vector<std::string>{"42"});
+}
+
+TEST_F(RouterFixture, UnmatchedPathRunsNothing) {
+  Request missing("GET /missing HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Router router;
+  router.get("/", [this](Request &, Response &) { calls.push_back("root"); });
+  EXPECT_FALSE(run(router, missing, response));
+  EXPECT_TRUE(calls.empty());
+}
+
+TEST_F(RouterFixture, MiddlewareRunsInOrderBeforeRoute) {
+  Router router;
+  router.use([this](Request &, Response &, Next &next) {
+    calls.push_back("log");
+    next();
+  });
+  router.use([this](Request &, Response &, Next &next) {
+    calls.push_back("auth");
+    next();
+  });
+  router.get("/", [this](Request &, Response &) { calls.push_back("route"); });
+
+  EXPECT_FALSE(run(router, request, response));
+  EXPECT_EQ(calls, (std::vector<std::string>{"log", "auth", "route"}));
+}
+
+TEST_F(RouterFixture, MiddlewareStopsChainWithoutNext) {
+  Router router;
+  router.use([this](Request &, Response &, Next &) { calls.push_back("gate"); });
+  router.get("/", [this](Request &, Response &) { calls.push_back("route"); });
+
+  EXPECT_FALSE(run(router, request, response));
+  EXPECT_EQ(calls, std::vector<std::string>{"gate"});
+}
+
+TEST_F(RouterFixture, MiddlewareStopsChainOnceHeadersSent) {
+  Router router;
+  router.use([this](Request &, Response &response, Next &next) {
+    calls.push_back("deny");
+    response.status(401).send("denied");
+    next();
+  });
+  router.get("/", [this](Request &, Response &) { calls.push_back("route"); });
+
+  EXPECT_FALSE(run(router, request, response));
+  EXPECT_EQ(calls, std::vector<std::string>{"deny"});
+}
+
+TEST_F(RouterFixture, RouteMiddlewareCanAnswerInsteadOfHandler) {
+  Router router;
+  bool pass = false;
+  router.get(
+      "/",
+      [this, &pass](Request &, Response &, Next &next) {
+        calls.push_back("route middleware");
+        if (pass)
+          next();
+      },
+      [this](Request &, Response &) { calls.push_back("route"); });
+
+  EXPECT_FALSE(run(router, request, response));
+  pass = true;
+  EXPECT_FALSE(run(router, request, response));
+  EXPECT_EQ(calls, (std::vector<std::string>{"route middleware", "route middleware", "route"}));
+}
+
+TEST_F(RouterFixture, PathScopedMiddlewareOnlyRunsUnderPath) {
+  Request admin("GET /admin/users HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Request administrator("GET /administrator HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Router router;
+  router.use("/admin/", [this](Request &request, Response &, Next &next) {
+    calls.push_back("admin " + std::string(request.path));
+    next();
+  });
+
+  run(router, request, response);
+  run(router, admin, response);
+  run(router, administrator, response);
+  EXPECT_EQ(calls, std::vector<std::string>{"admin /admin/users"});
+}
+
+TEST_F(RouterFixture, CoroutineMiddlewareContinuesChain) {
+  Router router;
+  router.use([this](Request &, Response &, Next &next) -> Task<> {
+    calls.push_back("async");
+    next();
+    co_return;
+  });
+  router.use([this](Request &, Response &, Next &next) {
+    calls.push_back("sync");
+    next();
+  });
+  router.get("/", [this](Request &, Response &) { calls.push_back("route"); });
+
+  Task<> task = run(router, request, response);
+  ASSERT_TRUE(task);
+  EXPECT_TRUE(calls.empty());
+
+  bool threw = false;
+  drive(task, threw);
+  EXPECT_FALSE(threw);
+  EXPECT_EQ(calls, (std::vector<std::string>{"async", "sync", "route"}));
+}
+
+TEST_F(RouterFixture, MountedRouterRoutesUnderPrefix) {
+  Request item("GET /api/v1/items/7 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Request root("GET /api/v1 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Router items;
+  items.get("/items/:id", [this](Request &request, Response &) {
+    calls.push_back(std::string(request.base_url) + " " + std::string(request.params["id"]));
+  });
+  items.get("/", [this](Request &request, Response &) {
+    calls.push_back("root " + std::string(request.base_url));
+  });
+  Router v1;
+  v1.use("/v1", items);
+  Router router;
+  router.use("/api/", v1);
+
+  run(router, item, response);
+  run(router, root, response);
+  run(router, request, response);
+  EXPECT_EQ(calls, (std::vector<std::string>{"/api/v1 7", "root /api/v1"}));
+}
+
+TEST_F(RouterFixture, MountedRouterKeepsItsMiddlewareScoped) {
+  Request inside("GET /admin/panel HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Router admin;
+  admin.use([this](Request &request, Response &, Next &next) {
+    calls.push_back("guard " + std::string(request.base_url));
+    next();
+  });
+  admin.get("/panel", [this](Request &, Response &) { calls.push_back("panel"); });
+  Router router;
+  router.use("/admin", admin);
+  router.get("/", [this](Request &, Response &) { calls.push_back("home"); });
+
+  run(router, inside, response);
+  run(router, request, response);
+  EXPECT_EQ(calls, (std::vector<std::string>{"guard /admin", "panel", "home"}));
+}
+
+TEST_F(RouterFixture, MergedRouteKeepsEachHandlersMount) {
+  Request users("GET /api/users HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Router router;
+  router.get("/api/users", [this](Request &request, Response &) {
+    calls.push_back("parent " + std::string(request.base_url));
+  });
+  Router api;
+  api.get("/users", [this](Request &request, Response &) {
+    calls.push_back("api " + std::string(request.base_url));
+  });
+  router.use("/api", api);
+  router.get("/api/users", [this](Request &request, Response &) {
+    calls.push_back("after " + std::string(request.base_url));
+  });
+
+  run(router, users, response);
+  EXPECT_EQ(calls, (std::vector<std::string>{"parent ", "api /api", "after "}));
+}
+
+TEST_F(RouterFixture, MountPathMayCaptureParameters) {
+  Request posts("GET /users/42/posts HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Router user;
+  user.use([this](Request &request, Response &, Next &next) {
+    calls.push_back("user " + std::string(request.base_url));
+    next();
+  });
+  user.get("/posts", [this](Request &request, Response &) {
+    calls.push_back("posts of " + std::string(request.params["id"]));
+  });
+  Router router;
+  router.use("/users/:id", user);
+
+  run(router, posts, response);
+  EXPECT_EQ(calls, (std::vector<std::string>{"user /users/42", "posts of 42"}));
+  EXPECT_THROW(router.use("/files/*", Router()), std::invalid_argument);
+}
+
+TEST_F(RouterFixture, RemovedRoutesAndMiddlewareNoLongerRun) {
+  Router router;
+  router.use("/beta", [this](Request &, Response &, Next &next) {
+    calls.push_back("beta middleware");
+    next();
+  });
+  router.get("/beta/feature", [this](Request &, Response &) { calls.push_back("feature"); });
+  router.get("/beta/:name", [this](Request &, Response &) { calls.push_back("fallback"); });
+  Request feature("GET /beta/feature HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+  run(router, feature, response);
+  EXPECT_TRUE(router.remove_route("GET", "/beta/feature"));
+  EXPECT_TRUE(router.remove_middleware("/beta/"));
+  run(router, feature, response);
+  EXPECT_EQ(calls, (std::vector<std::string>{"beta middleware", "feature", "fallback"}));
+
+  EXPECT_FALSE(router.remove_route("POST", "/beta/feature"));
+  EXPECT_FALSE(router.remove_middleware("/beta"));
+  EXPECT_THROW(router.remove_route("BREW", "/beta/feature"), std::runtime_error);
+}
+
+TEST_F(RouterFixture, HeadFallsBackToGetRoute) {
+  Request head("HEAD /items HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Router router;
+  router.get("/items", [this](Request &, Response &) { calls.push_back("get"); });
+  run(router, head, response);
+  router.head("/items", [this](Request &, Response &) { calls.push_back("head"); });
+  run(router, head, response);
+  EXPECT_EQ(calls, (std::vector<std::string>{"get", "head"}));
+}
+
+TEST_F(RouterFixture, OptionsListsRoutedMethods) {
+  Request options("OPTIONS /items/3 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  std::string written;
+  RouterResponse answered(
+      [&written](const std::vector<char> &data) { written.append(data.begin(), data.end()); });
+  Router router;
+  router.get("/items/:id", [](Request &, Response &) {});
+  router.patch("/items/:id", [](Request &, Response &) {});
+  router.del("/items", [](Request &, Response &) {});
+
+  EXPECT_FALSE(run(router, options, answered));
+  EXPECT_TRUE(answered.headers_sent());
+  EXPECT_NE(written.find("Allow: GET,HEAD,PATCH\r\n"), std::string::npos);
+}
+
+TEST_F(RouterFixture, MountedTableAnswersHeadAndOptions) {
+  auto table = routes(
+      route<"GET", "/items">([this](Request &, Response &) { calls.push_back("table get"); }),
+      route<"POST", "/items">([](Request &, Response &) {}),
+      route<"GET", "/items/:id">([](Request &, Response &) {}));
+  Router router;
+  router.use("/api", table);
+  router.del("/api/items", [](Request &, Response &) {});
+
+  Request head("HEAD /api/items HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  run(router, head, response);
+  EXPECT_EQ(calls, std::vector<std::string>{"table get"});
+
+  std::string written;
+  RouterResponse answered(
+      [&written](const std::vector<char> &data) { written.append(data.begin(), data.end()); });
+  Request options("OPTIONS /api/items HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  EXPECT_FALSE(run(router, options, answered));
+  EXPECT_NE(written.find("Allow: GET,POST,DELETE,HEAD\r\n"), std::string::npos);
+
+  written.clear();
+  RouterResponse item(
+      [&written](const std::vector<char> &data) { written.append(data.begin(), data.end()); });
+  Request item_options("OPTIONS /api/items/7 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  EXPECT_FALSE(run(router, item_options, item));
+  EXPECT_NE(written.find("Allow: GET,HEAD\r\n"), std::string::npos);
+}
+
+TEST_F(RouterFixture, UnknownMethodMatchesNothing) {
+  Request brew("BREW / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  Router router;
+  router.get("/", [this](Request &, Response &) { calls.push_back("root"); });
+  EXPECT_FALSE(run(router, brew, response));
+  EXPECT_TRUE(calls.empty());
+  EXPECT_FALSE(response.headers_sent());
+}
+
+TEST_F(RouterFixture, BodyChunkYieldsBufferedBodyOnce) {
+  Request post("POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello");
+  Router router;
+  router.post("/", [this](Request &request, Response &) -> Task<> {
+    std::string_view chunk;
+    while (!(chunk = co_await request.body_chunk()).empty()) {
+      calls.emplace_back(chunk);
+    }
+  });
+
+  Task<> task = run(router, post, response);
+  bool threw = false;
+  drive(task, threw);
+  EXPECT_EQ(calls, std::vector<std::string>{"hello"});
+}
+
+TEST_F(RouterFixture, BodyOptionsFollowTheirRoute) {
+  Router uploads;
+  uploads.post("/:id", BodyOptions{.max_size = 1 << 30, .stream = true},
+               [](Request &, Response &) -> Task<> { co_return; });
+  uploads.put("/:id", BodyOptions{.max_size = 4096}, [](Request &, Response &) {});
+  uploads.post("/", [](Request &, Response &) {});
+  Router router;
+  router.use("/uploads", uploads);
+  compiled = router.compile();
+
+  const BodyOptions *streamed = compiled->body_options("POST", "/uploads/7?resumable=1");
+  ASSERT_NE(streamed, nullptr);
+  EXPECT_EQ(streamed->max_size, 1 << 30);
+  EXPECT_TRUE(streamed->stream);
+  const BodyOptions *limited = compiled->body_options("PUT", "/uploads/7");
+  ASSERT_NE(limited, nullptr);
+  EXPECT_FALSE(limited->stream);
+  EXPECT_EQ(compiled->body_options("POST", "/uploads"), nullptr);
+  EXPECT_EQ(compiled->body_options("GET", "/uploads/7"), nullptr);
+}
+
+TEST_F(RouterFixture, StreamedBodyNeedsCoroutineHandler) {
+  Router router;
+  EXPECT_THROW(router.post("/upload", BodyOptions{.stream = true}, [](Request &, Response &) {}),
+               std::invalid_argument);
+  EXPECT_THROW(router.put("/upload", BodyOptions{.stream = true}, [](Request &, Response &) {}),
+               std::invalid_argument);
+  // Nothing was registered by the rejected calls
+  EXPECT_EQ(router.compile()->body_options("POST", "/upload"), nullptr);
+}
+
+TEST_F(RouterFixture, BodyChunkAwaitsStreamedBody) {
+  auto stream = std::make_shared<BodyStream>([] {});
+  Request upload("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", stream);
+  Router router;
+  router.post("/", [this](Request &request, Response &) -> Task<> {
+    std::string_view chunk;
+    while (!(chunk = co_await request.body_chunk()).empty()) {
+      calls.emplace_back(chunk);
+    }
+    calls.push_back("end");
+  });
+
+  Task<> task = run(router, upload, response);
+  bool threw = false;
+  drive(task, threw);
+  EXPECT_TRUE(calls.empty());
+
+  stream->append("hello").resume();
+  EXPECT_EQ(calls, std::vector<std::string>{"hello"});
+  std::coroutine_handle<> handler = stream->append(" wor");
+  stream->append("ld");
+  stream->finish();
+  handler.resume();
+  EXPECT_FALSE(threw);
+  EXPECT_EQ(calls, (std::vector<std::string>{"hello", " world", "end"}));
+}
+
+TEST_F(RouterFixture, BodyChunkThrowsOnceStreamedBodyFails) {
+  auto stream = std::make_shared<BodyStream>([] {});
+  Request upload("POST / HTTP/1.1\r\nContent-Length: 100\r\n\r\n", stream);
+  Router router;
+  router.post("/", [](Request &request, Response &) -> Task<> {
+    while (!(co_await request.body_chunk()).empty()) {
+    }
+  });
+
+  Task<> task = run(router, upload, response);
+  bool threw = false;
+  drive(task, threw);
+  stream->fail(400).resume();
+  EXPECT_TRUE(threw);
+}
+
+} // namespace test
+} // namespace express
@@ -0,0 +1,100 @@
+#include "core/router.h"
+#include <express/static_routes.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace express {
+namespace test {
+
+class StaticRoutesResponse : public Response {
+public:
+  StaticRoutesResponse() : Response([](const std::vector<char> &) {}) {}
+};
+
+using Health = decltype(route<"GET", "/health/">([](Request &, Response &) {}));
+using Item = decltype(route<"POST", "/items/:id/tags/*rest">([](Request &, Response &) {}));
+static_assert(Health::is_exact && Health::pattern == "/health");
+static_assert(!Item::is_exact && Item::piece_count == 4);
+static_assert(Item::pieces[1].text == "id" && Item::pieces[3].text == "rest");
+
+class StaticRoutesFixture : public ::testing::Test {
+protected:
+  StaticRoutesResponse response;
+  std::vector<std::string> calls;
+
+  static Request request(const std::string &method, const std::string &path) {
+    return Request(method + " " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  }
+
+  auto table() {
+    return routes(
+        route<"GET", "/health">([this](Request &, Response &) { calls.push_back("health"); }),
+        route<"GET", "/items">([this](Request &, Response &) { calls.push_back("list"); }),
+        route<"POST", "/items">([this](Request &, Response &) { calls.push_back("create"); }),
+        route<"GET", "/items/:id">([this](Request &request, Response &) {
+          calls.push_back("item " + std::string(request.params["id"]));
+        }),
+        route<"GET", "/files/*path">([this](Request &request, Response &) {
+          calls.push_back("file " + std::string(request.params["path"]));
+        }),
+        route<"GET", "/slow">([this](Request &, Response &) -> Task<> {
+          calls.push_back("slow");
+          co_return;
+        }));
+  }
+};
+
+TEST_F(StaticRoutesFixture, DispatchesExactRoutesByMethodAndPath) {
+  auto routes = table();
+  Request get = request("GET", "/items");
+  Request post = request("POST", "/items/");
+  ASSERT_TRUE(routes(get.path, get, response));
+  ASSERT_TRUE(routes(post.path, post, response));
+  EXPECT_EQ(calls, (std::vector<std::string>{"list", "create"}));
+}
+
+TEST_F(StaticRoutesFixture, CapturesParameters) {
+  auto routes = table();
+  Request item = request("GET", "/items/42");
+  Request file = request("GET", "/files/css/site.css");
+  ASSERT_TRUE(routes(item.path, item, response));
+  ASSERT_TRUE(routes(file.path, file, response));
+  EXPECT_EQ(calls, (std::vector<std::string>{"item 42", "file css/site.css"}));
+}
+
+TEST_F(StaticRoutesFixture, ReportsNoMatch) {
+  auto routes = table();
+  Request wrong_method = request("DELETE", "/items");
+  Request wrong_path = request("GET", "/items/42/extra");
+  EXPECT_FALSE(routes(wrong_method.path, wrong_method, response));
+  EXPECT_FALSE(routes(wrong_path.path, wrong_path, response));
+  EXPECT_TRUE(calls.empty());
+}
+
+TEST_F(StaticRoutesFixture, ReturnsTaskOfCoroutineHandler) {
+  auto routes = table();
+  Request slow = request("GET", "/slow");
+  std::optional<Task<>> task = routes(slow.path, slow, response);
+  ASSERT_TRUE(task);
+  EXPECT_TRUE(*task);
+  EXPECT_TRUE(calls.empty()); // Tasks are lazy
+}
+
+TEST_F(StaticRoutesFixture, MountsOnRouterUnderPrefix) {
+  Router router;
+  router.use("/api/", table());
+  router.get("/api/other", [this](Request &, Response &) { calls.push_back("router"); });
+
+  Request health = request("GET", "/api/health");
+  Request other = request("GET", "/api/other");
+  Request outside = request("GET", "/apihealth");
+  std::shared_ptr<const CompiledRouter> compiled = router.compile();
+  EXPECT_FALSE(compiled->run(health, response));
+  EXPECT_FALSE(compiled->run(other, response));
+  EXPECT_FALSE(compiled->run(outside, response));
+  EXPECT_EQ(calls, (std::vector<std::string>{"health", "router"}));
+}
+
+} // namespace test
+} // namespace express
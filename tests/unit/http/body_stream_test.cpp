@@ -0,0 +1,71 @@
+#include "http/body_stream.h"
+#include <express/request.h>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace express {
+namespace test {
+
+TEST(BodyStreamTest, TakesEverythingAppendedSinceLastTake) {
+  BodyStream stream([] {});
+  stream.append("hello");
+  stream.append(" world");
+  EXPECT_EQ(stream.take(), "hello world");
+  EXPECT_TRUE(stream.wait(std::noop_coroutine()));
+
+  stream.finish();
+  EXPECT_FALSE(stream.wait(std::noop_coroutine()));
+  EXPECT_EQ(stream.take(), "");
+}
+
+TEST(BodyStreamTest, AppendResumesWaitingHandler) {
+  BodyStream stream([] {});
+  std::coroutine_handle<> handler = std::noop_coroutine();
+  ASSERT_TRUE(stream.wait(handler));
+  EXPECT_EQ(stream.append(""), nullptr);
+  EXPECT_EQ(stream.append("data"), handler);
+  EXPECT_EQ(stream.append("more"), nullptr);
+}
+
+TEST(BodyStreamTest, ReportsDrainOnceFullStreamIsTaken) {
+  int drained = 0;
+  BodyStream stream([&drained] { drained++; });
+  stream.append("first");
+  EXPECT_EQ(stream.room(), BodyStream::MAX_PENDING_ - 5);
+  stream.append(std::string(BodyStream::MAX_PENDING_, 'x'));
+  EXPECT_EQ(stream.room(), 0u);
+
+  EXPECT_EQ(stream.take().size(), BodyStream::MAX_PENDING_ + 5);
+  EXPECT_EQ(drained, 1);
+  EXPECT_EQ(stream.room(), BodyStream::MAX_PENDING_);
+  stream.take();
+  EXPECT_EQ(drained, 1);
+}
+
+TEST(BodyStreamTest, FailureThrowsWithStatus) {
+  BodyStream stream([] {});
+  stream.append("partial");
+  stream.fail(413);
+  EXPECT_FALSE(stream.wait(std::noop_coroutine()));
+  try {
+    stream.take();
+    FAIL() << "take() should throw";
+  } catch (const BodyError &error) {
+    EXPECT_EQ(error.status(), 413);
+  }
+}
+
+TEST(BodyStreamTest, AbandonedStreamDropsBody) {
+  int drained = 0;
+  BodyStream stream([&drained] { drained++; });
+  stream.append(std::string(BodyStream::MAX_PENDING_, 'x'));
+  EXPECT_EQ(stream.room(), 0u);
+
+  stream.abandon();
+  EXPECT_EQ(drained, 1); // The server resumes reading, to drop the rest
+  stream.append(std::string(BodyStream::MAX_PENDING_, 'x'));
+  EXPECT_GT(stream.room(), 0u);
+}
+
+} // namespace test
+} // namespace express
@@ -0,0 +1,90 @@
+#include "http/byte_scanner.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace express {
+namespace test {
+
+std::vector<ByteScanner::Isa> supported_isas() {
+  std::vector<ByteScanner::Isa> isas;
+  for (ByteScanner::Isa isa :
+       {ByteScanner::Isa::SCALAR, ByteScanner::Isa::SSE42, ByteScanner::Isa::AVX2}) {
+    if (ByteScanner::supports(isa))
+      isas.push_back(isa);
+  }
+  return isas;
+}
+
+TEST(ByteScannerTest, SelectedVariantIsSupported) {
+  EXPECT_TRUE(ByteScanner::supports(ByteScanner::isa()));
+  EXPECT_TRUE(ByteScanner::supports(ByteScanner::Isa::SCALAR));
+}
+
+TEST(ByteScannerTest, FindsFirstDelimiterOfSet) {
+  std::string line = "Content-Type: text/html\r\n";
+  for (ByteScanner::Isa isa : supported_isas()) {
+    EXPECT_EQ(ByteScanner::find(isa, line, ":\r"), 12u);
+    EXPECT_EQ(ByteScanner::find(isa, line, "\r"), 23u);
+    EXPECT_EQ(ByteScanner::find(isa, line, ":\r", 13), 23u);
+    EXPECT_EQ(ByteScanner::find(isa, line, "#"), std::string::npos);
+    EXPECT_EQ(ByteScanner::find(isa, line, ""), std::string::npos);
+    EXPECT_EQ(ByteScanner::find(isa, line, ":", line.size()), std::string::npos);
+  }
+}
+
+TEST(ByteScannerTest, FindsDelimitersInEveryBlockPosition) {
+  // Covers matches in full vectors, at block edges and in the tail shorter than a vector
+  for (ByteScanner::Isa isa : supported_isas()) {
+    for (size_t size = 1; size <= 80; size++) {
+      for (size_t at = 0; at < size; at++) {
+        std::string text(size, 'a');
+        text[at] = '\n';
+        ASSERT_EQ(ByteScanner::find(isa, text, "\r\n"), at) << size << " " << at;
+        ASSERT_EQ(ByteScanner::find(isa, text, "\r\n", at + 1), std::string::npos);
+      }
+    }
+  }
+}
+
+TEST(ByteScannerTest, VariantsAgreeOnRandomInput) {
+  std::mt19937 random(7);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::string set = " :\r\n\t,;=";
+  for (int round = 0; round < 200; round++) {
+    std::string text(random() % 300, '\0');
+    for (char &c : text) {
+      c = static_cast<char>(byte(random) | 0x40); // Sparse delimiters, high bytes included
+    }
+    for (int i = 0; i < 3 && !text.empty(); i++) {
+      text[random() % text.size()] = set[random() % set.size()];
+    }
+    size_t from = text.empty() ? 0 : random() % text.size();
+    size_t expected = text.find_first_of(set, from);
+    for (ByteScanner::Isa isa : supported_isas()) {
+      ASSERT_EQ(ByteScanner::find(isa, text, set, from), expected);
+    }
+    ASSERT_EQ(ByteScanner::find(text, set, from), expected);
+  }
+}
+
+TEST(ByteScannerTest, MatchesFullSetOfSixteen) {
+  std::string set = "0123456789abcdef";
+  std::string text = std::string(40, 'z') + "f";
+  for (ByteScanner::Isa isa : supported_isas()) {
+    EXPECT_EQ(ByteScanner::find(isa, text, set), 40u);
+  }
+}
+
+TEST(ByteScannerTest, FallsBackToBytesForSetOfSeventeen) {
+  std::string set = "0123456789abcdefg";
+  std::string text = std::string(40, 'z') + "g";
+  for (ByteScanner::Isa isa : supported_isas()) {
+    EXPECT_EQ(ByteScanner::find(isa, text, set), 40u);
+  }
+  EXPECT_EQ(ByteScanner::find(text, set), 40u);
+}
+
+} // namespace test
+} // namespace express
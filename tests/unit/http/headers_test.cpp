@@ -0,0 +1,83 @@
+#include <express/headers.h>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace express {
+namespace test {
+
+TEST(HeadersTest, WellKnownNamesRoundTrip) {
+  for (size_t i = 0; i < Headers::WELL_KNOWN_COUNT; i++) {
+    Header id = static_cast<Header>(i);
+    EXPECT_EQ(Headers::id(Headers::name(id)), id);
+  }
+}
+
+TEST(HeadersTest, IdIgnoresCase) {
+  EXPECT_EQ(Headers::id("content-length"), Header::ContentLength);
+  EXPECT_EQ(Headers::id("HOST"), Header::Host);
+  EXPECT_EQ(Headers::id("x-forwarded-for"), Header::XForwardedFor);
+  EXPECT_EQ(Headers::id("X-Custom"), std::nullopt);
+  EXPECT_EQ(Headers::id("Content-Lengths"), std::nullopt);
+  EXPECT_EQ(Headers::id(""), std::nullopt);
+}
+
+TEST(HeadersTest, LooksUpByIdAndByName) {
+  Headers headers;
+  headers.add("host", "example.com");
+  headers.add("X-Request-Id", "abc");
+
+  EXPECT_EQ(headers.get(Header::Host), "example.com");
+  EXPECT_EQ(headers.get("HOST"), "example.com");
+  EXPECT_EQ(headers.get("x-request-id"), "abc");
+  EXPECT_TRUE(headers.contains(Header::Host));
+  EXPECT_FALSE(headers.contains(Header::ContentLength));
+  EXPECT_FALSE(headers.contains("X-Missing"));
+  EXPECT_EQ(headers.get(Header::ContentLength), "");
+}
+
+TEST(HeadersTest, RepeatedNamesKeepEveryFieldAndFindTheLast) {
+  Headers headers;
+  headers.add("Accept", "text/html");
+  headers.add("X-Tag", "one");
+  headers.add("accept", "application/json");
+  headers.add("x-tag", "two");
+
+  EXPECT_EQ(headers.size(), 4);
+  EXPECT_EQ(headers.get(Header::Accept), "application/json");
+  EXPECT_EQ(headers.get("X-Tag"), "two");
+}
+
+TEST(HeadersTest, SetReplacesOrAppends) {
+  Headers headers;
+  headers.add("Content-Type", "text/plain");
+  headers.set("content-type", "application/json");
+  headers.set("X-User", "alice");
+
+  EXPECT_EQ(headers.size(), 2);
+  EXPECT_EQ(headers.get(Header::ContentType), "application/json");
+  EXPECT_EQ(headers.get("X-User"), "alice");
+}
+
+TEST(HeadersTest, IteratesInOrderPastInlineCapacity) {
+  std::vector<std::string> names;
+  for (size_t i = 0; i < Headers::INLINE_CAPACITY + 4; i++) {
+    names.push_back("X-Field-" + std::to_string(i));
+  }
+  Headers headers;
+  for (const std::string &name : names) {
+    headers.add(name, name);
+  }
+  headers.add("Host", "example.com");
+
+  ASSERT_EQ(headers.size(), names.size() + 1);
+  size_t i = 0;
+  for (const auto &[name, value] : headers) {
+    EXPECT_EQ(name, i < names.size() ? names[i] : "Host");
+    i++;
+  }
+  EXPECT_EQ(headers.get("x-field-0"), "X-Field-0");
+  EXPECT_EQ(headers.get(Header::Host), "example.com");
+}
+
+} // namespace test
+} // namespace express
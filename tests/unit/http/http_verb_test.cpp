@@ -18,5 +18,25 @@ TEST(HttpVerbStruct, TestStringToEnum) {
   EXPECT_EQ(express::HttpVerb::toEnum("DELETE"), express::HttpVerb::Value::DELETE);
 }
 
+TEST(HttpVerbStruct, TestExtendedVerbsRoundTrip) {
+  for (size_t i = 0; i < express::HttpVerb::COUNT; i++) {
+    auto verb = static_cast<express::HttpVerb::Value>(i);
+    EXPECT_EQ(express::HttpVerb::toEnum(express::HttpVerb::toString(verb)), verb);
+  }
+  EXPECT_EQ(express::HttpVerb::toEnum("PATCH"), express::HttpVerb::Value::PATCH);
+  EXPECT_EQ(express::HttpVerb::toEnum("OPTIONS"), express::HttpVerb::Value::OPTIONS);
+}
+
+TEST(HttpVerbStruct, TestDecodeRejectsUnknownMethods) {
+  static_assert(express::HttpVerb::decode("HEAD") == express::HttpVerb::Value::HEAD);
+  EXPECT_FALSE(express::HttpVerb::decode("get"));
+  EXPECT_FALSE(express::HttpVerb::decode("GETS"));
+  EXPECT_FALSE(express::HttpVerb::decode("GE"));
+  EXPECT_FALSE(express::HttpVerb::decode(""));
+  EXPECT_FALSE(express::HttpVerb::decode("PROPFIND"));
+  EXPECT_FALSE(express::HttpVerb::decode(std::string_view("GET\0", 4)));
+  EXPECT_THROW(express::HttpVerb::toEnum("BREW"), std::runtime_error);
+}
+
 } // namespace test
 } // namespace express
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include "http/mime_type.h"
+#include <gtest/gtest.h>
+
+namespace express {
+namespace test {
+
+TEST(MimeTypeTest, KnownExtensions) {
+  EXPECT_EQ(MimeType::from_path("index.html"), "text/html; charset=utf-8");
+  EXPECT_EQ(MimeType::from_path("/assets/app.js"), "text/javascript; charset=utf-8");
+  EXPECT_EQ(MimeType::from_path("logo.png"), "image/png");
+}
+
+TEST(MimeTypeTest, ExtensionIsCaseInsensitive) {
+  EXPECT_EQ(MimeType::from_path("PHOTO.JPG"), "image/jpeg");
+}
+
+TEST(MimeTypeTest, UnknownExtensionIsOctetStream) {
+  EXPECT_EQ(MimeType::from_path("archive.unknown"), "application/octet-stream");
+  EXPECT_EQ(MimeType::from_path("Makefile"), "application/octet-stream");
+}
+
+} // namespace test
+} // namespace express
@@ -0,0 +1,227 @@
+#include <cstdio>
+#include <express/multipart.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace express {
+namespace test {
+
+/** Records what a MultipartParser calls back with, as "part name file type" and "end content" */
+class MultipartFixture : public ::testing::Test {
+protected:
+  std::vector<std::string> events;
+  std::string content;
+
+  MultipartParser::Callbacks callbacks() {
+    return {
+        .on_part =
+            [this](const MultipartPart &part) {
+              events.push_back("part " + std::string(part.name) + " " +
+                               std::string(part.filename) + " " + std::string(part.content_type));
+            },
+        .on_data = [this](std::string_view data) { content.append(data); },
+        .on_part_end =
+            [this]() {
+              events.push_back("end " + content);
+              content.clear();
+            },
+    };
+  }
+
+  static std::string form() {
+    return "preamble\r\n"
+           "--XyZ\r\n"
+           "Content-Disposition: form-data; name=\"title\"\r\n"
+           "\r\n"
+           "Holiday\r\n"
+           "--XyZ \r\n"
+           "Content-Disposition: form-data; name=\"photo\"; filename=\"a;b.jpg\"\r\n"
+           "Content-Type: image/jpeg\r\n"
+           "\r\n"
+           "\r\n--Xy\r\n-XyZ\r\n--X\r\n"
+           "--XyZ--\r\n"
+           "epilogue";
+  }
+
+  static std::vector<std::string> form_events() {
+    return {
+        "part title  ",
+        "end Holiday",
+        "part photo a;b.jpg image/jpeg",
+        "end \r\n--Xy\r\n-XyZ\r\n--X",
+    };
+  }
+};
+
+namespace {
+/** Eagerly started coroutine, for driving lazy tasks to completion in tests */
+struct MultipartDriver {
+  struct promise_type {
+    MultipartDriver get_return_object() { return {}; }
+    std::suspend_never initial_suspend() { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+MultipartDriver drive(Task<> &task, bool &threw) {
+  try {
+    co_await task;
+  } catch (const std::exception &) {
+    threw = true;
+  }
+}
+} // namespace
+
+TEST(MultipartParserTest, ExtractsBoundaryFromFormDataContentType) {
+  EXPECT_EQ(MultipartParser::boundary("multipart/form-data; boundary=----abc123"), "----abc123");
+  EXPECT_EQ(MultipartParser::boundary("Multipart/Form-Data;charset=utf-8; BOUNDARY=\"a b;c\""),
+            "a b;c");
+  EXPECT_EQ(MultipartParser::boundary("multipart/mixed; boundary=abc"), "");
+  EXPECT_EQ(MultipartParser::boundary("multipart/form-data"), "");
+}
+
+TEST(MultipartParserTest, RejectsInvalidBoundary) {
+  EXPECT_THROW(MultipartParser("", {}), BodyError);
+  EXPECT_THROW(MultipartParser(std::string(MultipartParser::MAX_BOUNDARY_SIZE_ + 1, 'a'), {}),
+               BodyError);
+}
+
+TEST_F(MultipartFixture, ParsesPartsFedAtOnce) {
+  MultipartParser parser("XyZ", callbacks());
+  parser.feed(form());
+  parser.finish();
+
+  EXPECT_TRUE(parser.done());
+  EXPECT_EQ(events, form_events());
+}
+
+TEST_F(MultipartFixture, ParsesPartsFedOneByteAtATime) {
+  MultipartParser parser("XyZ", callbacks());
+  std::string body = form();
+  for (char c : body) {
+    parser.feed(std::string_view(&c, 1));
+  }
+  parser.finish();
+
+  EXPECT_EQ(events, form_events());
+}
+
+TEST_F(MultipartFixture, ParsesPartsSplitAtEveryOffset) {
+  std::string body = form();
+  for (size_t split = 0; split <= body.size(); split++) {
+    events.clear();
+    MultipartParser parser("XyZ", callbacks());
+    parser.feed(std::string_view(body).substr(0, split));
+    parser.feed(std::string_view(body).substr(split));
+    parser.finish();
+    EXPECT_EQ(events, form_events()) << "split at " << split;
+  }
+}
+
+TEST_F(MultipartFixture, BodyMayStartWithDelimiterAndPartWithoutHeaders) {
+  MultipartParser parser("b", callbacks());
+  parser.feed("--b\r\n\r\nplain\r\n--b--");
+  parser.finish();
+
+  EXPECT_EQ(events, (std::vector<std::string>{"part   ", "end plain"}));
+}
+
+TEST_F(MultipartFixture, HandsLargePartOnWithoutBufferingIt) {
+  std::vector<size_t> pieces;
+  MultipartParser::Callbacks sizes = callbacks();
+  sizes.on_data = [&](std::string_view data) { pieces.push_back(data.size()); };
+  MultipartParser parser("boundary", sizes);
+  parser.feed("--boundary\r\nContent-Disposition: form-data; name=\"file\"\r\n\r\n");
+
+  std::string block(64 * 1024, 'x');
+  for (int i = 0; i < 16; i++) {
+    parser.feed(block);
+  }
+  parser.feed("\r\n--boundary--");
+  parser.finish();
+
+  // Each chunk is passed on as it is fed, less the bytes that could begin a delimiter
+  ASSERT_EQ(pieces.size(), 16);
+  size_t total = 0;
+  for (size_t piece : pieces) {
+    total += piece;
+  }
+  EXPECT_EQ(total, 16 * block.size());
+}
+
+TEST_F(MultipartFixture, WritesPartToFileDescriptor) {
+  FILE *file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  int fd = fileno(file);
+
+  MultipartParser *target = nullptr;
+  MultipartParser::Callbacks to_file = callbacks();
+  to_file.on_part = [&](const MultipartPart &part) {
+    if (!part.filename.empty()) {
+      target->write_to(fd);
+    }
+  };
+  MultipartParser parser("XyZ", to_file);
+  target = &parser;
+  parser.feed(form());
+  parser.finish();
+
+  std::string written(64, '\0');
+  ssize_t size = ::pread(fd, written.data(), written.size(), 0);
+  ASSERT_GE(size, 0);
+  written.resize(size);
+  std::fclose(file);
+
+  EXPECT_EQ(written, "\r\n--Xy\r\n-XyZ\r\n--X");
+  EXPECT_EQ(events, (std::vector<std::string>{"end Holiday", "end "}));
+}
+
+TEST_F(MultipartFixture, RejectsMalformedBodies) {
+  MultipartParser bad_delimiter("b", callbacks());
+  EXPECT_THROW(bad_delimiter.feed("--b\r\n\r\nx\r\n--bx"), BodyError);
+  EXPECT_THROW(bad_delimiter.feed("more"), BodyError);
+
+  MultipartParser bad_header("b", callbacks());
+  EXPECT_THROW(bad_header.feed("--b\r\nno colon\r\n\r\n"), BodyError);
+
+  MultipartParser truncated("b", callbacks());
+  truncated.feed("--b\r\n\r\nx\r\n--b");
+  EXPECT_FALSE(truncated.done());
+  EXPECT_THROW(truncated.finish(), BodyError);
+}
+
+TEST_F(MultipartFixture, RejectsOversizedPartHeaders) {
+  MultipartParser parser("b", callbacks());
+  parser.feed("--b\r\nX-Long: ");
+  try {
+    parser.feed(std::string(MultipartParser::MAX_HEADER_SIZE_, 'a'));
+    FAIL() << "Expected BodyError";
+  } catch (const BodyError &error) {
+    EXPECT_EQ(error.status(), 431);
+  }
+}
+
+TEST_F(MultipartFixture, ParsesBufferedRequestBody) {
+  std::string raw = "POST /upload HTTP/1.1\r\n"
+                    "Content-Type: multipart/form-data; boundary=XyZ\r\n"
+                    "\r\n" +
+                    form();
+  Request request(raw);
+  MultipartParser parser(MultipartParser::boundary(request.header(Header::ContentType)),
+                         callbacks());
+
+  Task<> task = parser.parse(request);
+  bool threw = false;
+  drive(task, threw);
+
+  EXPECT_FALSE(threw);
+  EXPECT_TRUE(task.done());
+  EXPECT_EQ(events, form_events());
+}
+
+} // namespace test
+} // namespace express
@@ -0,0 +1,96 @@
+#include <chrono>
+#include <express/parameters.h>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace express {
+namespace test {
+
+TEST(ParametersTest, ValuesWithoutEscapesAreViewsIntoTheSource) {
+  std::string source = "page=2&sort=price";
+  Parameters query(source, Parameters::Syntax::URL_ENCODED);
+
+  EXPECT_EQ(query.size(), 2);
+  EXPECT_EQ(query["page"], "2");
+  EXPECT_EQ(query.get("sort").data(), source.data() + 12);
+}
+
+TEST(ParametersTest, DecodesOnlyEscapedKeysAndValues) {
+  std::string source = "q=hello+world&caf%C3%A9=1&plain=abc";
+  Parameters query(source, Parameters::Syntax::URL_ENCODED);
+
+  EXPECT_EQ(query["q"], "hello world");
+  EXPECT_EQ(query["café"], "1");
+  EXPECT_EQ(query.get("plain").data(), source.data() + 32);
+}
+
+TEST(ParametersTest, RepeatedKeysKeepTheirLastValue) {
+  Parameters query("tag=a&other=b&tag=c", Parameters::Syntax::URL_ENCODED);
+
+  EXPECT_EQ(query.size(), 2);
+  EXPECT_EQ(query["tag"], "c");
+  EXPECT_EQ(query.begin()->key, "tag");
+}
+
+TEST(ParametersTest, SkipsPairsWithoutKeyOrEquals) {
+  Parameters query("flag&=orphan&&key=", Parameters::Syntax::URL_ENCODED);
+
+  EXPECT_EQ(query.size(), 1);
+  EXPECT_TRUE(query.contains("key"));
+  EXPECT_FALSE(query.contains("flag"));
+}
+
+TEST(ParametersTest, KeepsMalformedEscapesAsSent) {
+  Parameters query("bad=%E6%97ABC&short=%4", Parameters::Syntax::URL_ENCODED);
+
+  EXPECT_EQ(query["bad"], "%E6%97ABC");
+  EXPECT_EQ(query["short"], "%4");
+}
+
+TEST(ParametersTest, ParsesCookies) {
+  Parameters cookies(" session=abc123;theme=\"dark\";  name=J%C3%B6rg+M ",
+                     Parameters::Syntax::COOKIE);
+
+  EXPECT_EQ(cookies.size(), 3);
+  EXPECT_EQ(cookies["session"], "abc123");
+  EXPECT_EQ(cookies["theme"], "dark");
+  EXPECT_EQ(cookies["name"], "Jörg+M");
+}
+
+TEST(ParametersTest, EmptyByDefault) {
+  Parameters parameters;
+
+  EXPECT_TRUE(parameters.empty());
+  EXPECT_EQ(parameters["anything"], "");
+}
+
+TEST(ParametersTest, DecodedValuesSurviveMove) {
+  Parameters query("q=a+b", Parameters::Syntax::URL_ENCODED);
+  EXPECT_EQ(query["q"], "a b");
+
+  Parameters moved(std::move(query));
+
+  EXPECT_EQ(moved["q"], "a b");
+}
+
+TEST(ParametersTest, ParsesLargeFormWithManyKeys) {
+  // About the default body limit: 130k distinct keys, then a repeat of the first
+  std::string source;
+  for (int i = 0; i < 130000; i++) {
+    source += "k" + std::to_string(i) + "=" + std::to_string(i) + "&";
+  }
+  source += "k0=last";
+  Parameters form(source, Parameters::Syntax::URL_ENCODED);
+
+  auto started = std::chrono::steady_clock::now();
+  EXPECT_EQ(form.size(), 130000u);
+  EXPECT_EQ(form["k0"], "last");
+  EXPECT_EQ(form["k129999"], "129999");
+  EXPECT_EQ(form.begin()->key, "k0");
+  EXPECT_FALSE(form.contains("k130000"));
+  // Quadratic deduplication took minutes here
+  EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(2));
+}
+
+} // namespace test
+} // namespace express
@@ -0,0 +1,158 @@
+#include "http/request_framer.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace express {
+namespace test {
+
+using Status = RequestFramer::Status;
+
+/**
+ * Test fixture for RequestFramer tests.
+ * Feeds raw bytes into a buffer the way a connection's reads would.
+ */
+class RequestFramerFixture : public ::testing::Test {
+protected:
+  RequestFramer framer;
+  std::vector<char> buffer;
+
+  /** Appends bytes and advances, past the stop once the headers of a body arrived */
+  Status feed(const std::string &bytes) {
+    buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+    Status status = framer.advance(buffer.data(), buffer.size());
+    if (status == Status::HEADERS) {
+      status = framer.advance(buffer.data(), buffer.size());
+    }
+    return status;
+  }
+
+  std::string message() { return std::string(buffer.data(), framer.message_length()); }
+};
+
+TEST_F(RequestFramerFixture, RequestWithoutBody) {
+  std::string raw = "GET / HTTP/1.1\r\nHost: example.com\r\n\r\n";
+  EXPECT_EQ(feed(raw), Status::COMPLETE);
+  EXPECT_EQ(framer.message_length(), raw.size());
+  EXPECT_EQ(framer.consumed_length(), raw.size());
+}
+
+TEST_F(RequestFramerFixture, HeadersSplitAcrossReads) {
+  EXPECT_EQ(feed("GET / HTTP/1.1\r\nHost: example.com\r"), Status::INCOMPLETE);
+  EXPECT_EQ(feed("\n\r"), Status::INCOMPLETE);
+  EXPECT_EQ(feed("\n"), Status::COMPLETE);
+}
+
+TEST_F(RequestFramerFixture, ContentLengthBodySplitAcrossReads) {
+  EXPECT_EQ(feed("POST /api HTTP/1.1\r\nContent-Length: 11\r\n\r\nhello"), Status::INCOMPLETE);
+  EXPECT_EQ(feed(" world"), Status::COMPLETE);
+  EXPECT_EQ(message(), "POST /api HTTP/1.1\r\nContent-Length: 11\r\n\r\nhello world");
+}
+
+TEST_F(RequestFramerFixture, StopsAtContentLengthWhenPipelined) {
+  std::string first = "POST /a HTTP/1.1\r\ncontent-length: 3\r\n\r\nabc";
+  std::string second = "GET /b HTTP/1.1\r\n\r\n";
+  EXPECT_EQ(feed(first + second), Status::COMPLETE);
+  EXPECT_EQ(framer.consumed_length(), first.size());
+}
+
+TEST_F(RequestFramerFixture, DecodesChunkedBodyInPlace) {
+  std::string head = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+  EXPECT_EQ(feed(head + "5\r\nhel"), Status::INCOMPLETE);
+  EXPECT_EQ(feed("lo\r\n6;ext=1\r\n world\r\n"), Status::INCOMPLETE);
+  EXPECT_EQ(feed("0\r\nX-Trailer: yes\r\n\r\n"), Status::COMPLETE);
+  EXPECT_EQ(message(), head + "hello world");
+  EXPECT_EQ(framer.consumed_length(), buffer.size());
+}
+
+TEST_F(RequestFramerFixture, ResetFramesNextRequest) {
+  std::string first = "GET /a HTTP/1.1\r\n\r\n";
+  EXPECT_EQ(feed(first + "GET /b HTTP/1.1\r\n\r\n"), Status::COMPLETE);
+
+  buffer.erase(buffer.begin(), buffer.begin() + framer.consumed_length());
+  framer.reset();
+  EXPECT_EQ(framer.advance(buffer.data(), buffer.size()), Status::COMPLETE);
+  EXPECT_EQ(message(), "GET /b HTTP/1.1\r\n\r\n");
+}
+
+TEST_F(RequestFramerFixture, RejectsInvalidContentLength) {
+  EXPECT_EQ(feed("POST / HTTP/1.1\r\nContent-Length: 12abc\r\n\r\n"), Status::ERROR);
+  EXPECT_EQ(framer.error_status(), 400);
+}
+
+TEST_F(RequestFramerFixture, RejectsContentLengthWithChunked) {
+  EXPECT_EQ(feed("POST / HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n"),
+            Status::ERROR);
+  EXPECT_EQ(framer.error_status(), 400);
+}
+
+TEST_F(RequestFramerFixture, RejectsOversizedBody) {
+  EXPECT_EQ(feed("POST / HTTP/1.1\r\nContent-Length: 1073741824\r\n\r\n"), Status::ERROR);
+  EXPECT_EQ(framer.error_status(), 413);
+}
+
+TEST_F(RequestFramerFixture, StopsOnceHeadersOfBodyArrived) {
+  std::string head = "POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\n";
+  buffer.assign(head.begin(), head.end());
+  EXPECT_EQ(framer.advance(buffer.data(), buffer.size()), Status::HEADERS);
+  EXPECT_EQ(framer.header_length(), head.size());
+  EXPECT_EQ(framer.advance(buffer.data(), buffer.size()), Status::INCOMPLETE);
+}
+
+TEST_F(RequestFramerFixture, LimitBodyOverridesDefaultLimit) {
+  std::string head = "POST / HTTP/1.1\r\nContent-Length: 2097152\r\n\r\n";
+  buffer.assign(head.begin(), head.end());
+  ASSERT_EQ(framer.advance(buffer.data(), buffer.size()), Status::HEADERS);
+  EXPECT_TRUE(framer.limit_body(4 * 1024 * 1024));
+  EXPECT_EQ(framer.advance(buffer.data(), buffer.size()), Status::INCOMPLETE);
+
+  framer.reset();
+  ASSERT_EQ(framer.advance(buffer.data(), buffer.size()), Status::HEADERS);
+  EXPECT_FALSE(framer.limit_body(1024));
+  EXPECT_EQ(framer.error_status(), 413);
+}
+
+TEST_F(RequestFramerFixture, StreamsContentLengthBodyAsItArrives) {
+  std::string head = "POST / HTTP/1.1\r\nContent-Length: 11\r\n\r\n";
+  buffer.assign(head.begin(), head.end());
+  buffer.insert(buffer.end(), {'h', 'e', 'l', 'l', 'o'});
+  ASSERT_EQ(framer.advance(buffer.data(), buffer.size()), Status::HEADERS);
+  buffer.erase(buffer.begin(), buffer.begin() + framer.header_length());
+  framer.stream_body();
+
+  EXPECT_EQ(framer.advance(buffer.data(), buffer.size()), Status::INCOMPLETE);
+  EXPECT_EQ(message(), "hello");
+  buffer.erase(buffer.begin(), buffer.begin() + framer.consumed_length());
+  framer.release_body();
+
+  EXPECT_EQ(feed(" worldGET / HTTP/1.1\r\n\r\n"), Status::COMPLETE);
+  EXPECT_EQ(message(), " world");
+  EXPECT_EQ(framer.consumed_length(), 6u);
+}
+
+TEST_F(RequestFramerFixture, StreamsChunkedBodyWithinLimit) {
+  std::string head = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+  buffer.assign(head.begin(), head.end());
+  ASSERT_EQ(framer.advance(buffer.data(), buffer.size()), Status::HEADERS);
+  ASSERT_TRUE(framer.limit_body(8));
+  buffer.clear();
+  framer.stream_body();
+
+  EXPECT_EQ(feed("5\r\nhello\r\n"), Status::INCOMPLETE);
+  EXPECT_EQ(message(), "hello");
+  buffer.erase(buffer.begin(), buffer.begin() + framer.consumed_length());
+  framer.release_body();
+
+  // The limit counts the bytes already released, not only those still buffered
+  EXPECT_EQ(feed("4\r\n"), Status::ERROR);
+  EXPECT_EQ(framer.error_status(), 413);
+}
+
+TEST_F(RequestFramerFixture, RejectsOversizedHeaders) {
+  std::string huge_header = "X-Filler: " + std::string(128 * 1024, 'a');
+  EXPECT_EQ(feed("GET / HTTP/1.1\r\n" + huge_header), Status::ERROR);
+  EXPECT_EQ(framer.error_status(), 431);
+}
+
+} // namespace test
+} // namespace express
@@ -18,8 +18,8 @@ TEST(RequestTest, BasicGetRequest) {
   EXPECT_EQ(request.original_url, "/index.html");
   EXPECT_EQ(request.http_version, "HTTP/1.1");
   EXPECT_EQ(request.headers.size(), 2);
-  EXPECT_EQ(request.headers["Host"], "example.com");
-  EXPECT_EQ(request.headers["User-Agent"], "Mozilla/5.0");
+  EXPECT_EQ(request.header("Host"), "example.com");
+  EXPECT_EQ(request.header("User-Agent"), "Mozilla/5.0");
   EXPECT_EQ(request.body, "This is the request body");
 }
 
@@ -38,9 +38,9 @@ TEST(RequestTest, PostRequestWithBody) {
   EXPECT_EQ(request.original_url, "/api/data");
   EXPECT_EQ(request.http_version, "HTTP/1.1");
   EXPECT_EQ(request.headers.size(), 3);
-  EXPECT_EQ(request.headers["Host"], "api.example.com");
-  EXPECT_EQ(request.headers["Content-Type"], "application/json");
-  EXPECT_EQ(request.headers["Content-Length"], "28");
+  EXPECT_EQ(request.header("Host"), "api.example.com");
+  EXPECT_EQ(request.header("Content-Type"), "application/json");
+  EXPECT_EQ(request.header("Content-Length"), "28");
   EXPECT_EQ(request.body, "{\"key\": \"value\", \"number\": 42}");
 }
 
@@ -71,7 +71,7 @@ TEST(RequestTest, RequestWithNoBody) {
   EXPECT_EQ(request.original_url, "/");
   EXPECT_EQ(request.http_version, "HTTP/1.1");
   EXPECT_EQ(request.headers.size(), 1);
-  EXPECT_EQ(request.headers["Host"], "example.com");
+  EXPECT_EQ(request.header("Host"), "example.com");
   EXPECT_TRUE(request.body.empty());
 }
 
@@ -88,8 +88,8 @@ TEST(RequestTest, RequestWithMultipleHeaderValues) {
   EXPECT_EQ(request.original_url, "/");
   EXPECT_EQ(request.http_version, "HTTP/1.1");
   EXPECT_EQ(request.headers.size(), 2);
-  EXPECT_EQ(request.headers["Accept"], "text/html,application/xhtml+xml");
-  EXPECT_EQ(request.headers["Accept-Language"], "en-US,en;q=0.9");
+  EXPECT_EQ(request.header("Accept"), "text/html,application/xhtml+xml");
+  EXPECT_EQ(request.header("Accept-Language"), "en-US,en;q=0.9");
   EXPECT_TRUE(request.body.empty());
 }
 
@@ -108,7 +108,7 @@ TEST(RequestTest, RequestWithComplexBody) {
   EXPECT_EQ(request.original_url, "/upload");
   EXPECT_EQ(request.http_version, "HTTP/1.1");
   EXPECT_EQ(request.headers.size(), 1);
-  EXPECT_EQ(request.headers["Content-Type"], "multipart/form-data");
+  EXPECT_EQ(request.header("Content-Type"), "multipart/form-data");
   EXPECT_EQ(request.body, "This is a complex body\r\nwith multiple "
                           "lines\r\nand some special characters: \r\n\r\n");
 }
@@ -127,8 +127,8 @@ TEST(RequestTest, PutRequest) {
   EXPECT_EQ(request.original_url, "/resource/123");
   EXPECT_EQ(request.http_version, "HTTP/1.1");
   EXPECT_EQ(request.headers.size(), 2);
-  EXPECT_EQ(request.headers["Host"], "api.example.com");
-  EXPECT_EQ(request.headers["Content-Type"], "application/json");
+  EXPECT_EQ(request.header("Host"), "api.example.com");
+  EXPECT_EQ(request.header("Content-Type"), "application/json");
   EXPECT_EQ(request.body, "{\"updated\": true}");
 }
 
@@ -144,7 +144,7 @@ TEST(RequestTest, DeleteRequest) {
   EXPECT_EQ(request.original_url, "/resource/123");
   EXPECT_EQ(request.http_version, "HTTP/1.1");
   EXPECT_EQ(request.headers.size(), 1);
-  EXPECT_EQ(request.headers["Host"], "api.example.com");
+  EXPECT_EQ(request.header("Host"), "api.example.com");
   EXPECT_TRUE(request.body.empty());
 }
 
@@ -161,13 +161,13 @@ TEST(RequestTest, RequestWithQueryString) {
   EXPECT_EQ(request.path, "/search");
   EXPECT_EQ(request.http_version, "HTTP/1.1");
   EXPECT_EQ(request.headers.size(), 1);
-  EXPECT_EQ(request.headers["Host"], "example.com");
+  EXPECT_EQ(request.header("Host"), "example.com");
   EXPECT_TRUE(request.body.empty());
 
-  // Test that params were parsed correctly
-  EXPECT_EQ(request.params.size(), 2);
-  EXPECT_EQ(request.params["q"], "test");
-  EXPECT_EQ(request.params["page"], "1");
+  // Test that query parameters were parsed correctly
+  EXPECT_EQ(request.query.size(), 2);
+  EXPECT_EQ(request.query["q"], "test");
+  EXPECT_EQ(request.query["page"], "1");
 }
 
 // Test a request with a fragment in the URI
@@ -182,7 +182,7 @@ TEST(RequestTest, RequestWithFragment) {
   EXPECT_EQ(request.original_url, "/page.html#section1");
   EXPECT_EQ(request.http_version, "HTTP/1.1");
   EXPECT_EQ(request.headers.size(), 1);
-  EXPECT_EQ(request.headers["Host"], "example.com");
+  EXPECT_EQ(request.header("Host"), "example.com");
   EXPECT_TRUE(request.body.empty());
 }
 
@@ -197,9 +197,9 @@ TEST(RequestTest, RequestWithEncodedParameters) {
   EXPECT_EQ(request.method, "GET");
   EXPECT_EQ(request.original_url, "/search?q=hello+world&category=books%20%26%20media");
   EXPECT_EQ(request.path, "/search");
-  EXPECT_EQ(request.params.size(), 2);
-  EXPECT_EQ(request.params["q"], "hello world");
-  EXPECT_EQ(request.params["category"], "books & media");
+  EXPECT_EQ(request.query.size(), 2);
+  EXPECT_EQ(request.query["q"], "hello world");
+  EXPECT_EQ(request.query["category"], "books & media");
 }
 
 // Test parsing parameters with no values
@@ -212,10 +212,10 @@ TEST(RequestTest, RequestWithEmptyParameterValues) {
 
   EXPECT_EQ(request.method, "GET");
   EXPECT_EQ(request.path, "/api");
-  EXPECT_EQ(request.params.size(), 3);
-  EXPECT_EQ(request.params["token"], "abc123");
-  EXPECT_EQ(request.params["filter"], "");
-  EXPECT_EQ(request.params["sort"], "");
+  EXPECT_EQ(request.query.size(), 3);
+  EXPECT_EQ(request.query["token"], "abc123");
+  EXPECT_EQ(request.query["filter"], "");
+  EXPECT_EQ(request.query["sort"], "");
 }
 
 // Test parsing parameters with special characters
@@ -228,9 +228,9 @@ TEST(RequestTest, RequestWithSpecialCharactersInParameters) {
 
   EXPECT_EQ(request.method, "GET");
   EXPECT_EQ(request.path, "/search");
-  EXPECT_EQ(request.params.size(), 2);
-  EXPECT_EQ(request.params["q"], "日本語");
-  EXPECT_EQ(request.params["year"], "2023-2024");
+  EXPECT_EQ(request.query.size(), 2);
+  EXPECT_EQ(request.query["q"], "日本語");
+  EXPECT_EQ(request.query["year"], "2023-2024");
 }
 
 // Test parsing a complex query string with multiple parameters
@@ -246,14 +246,14 @@ TEST(RequestTest, RequestWithComplexQueryString) {
 
   EXPECT_EQ(request.method, "GET");
   EXPECT_EQ(request.path, "/products");
-  EXPECT_EQ(request.params.size(), 6);
-  EXPECT_EQ(request.params["category"], "electronics");
-  EXPECT_EQ(request.params["price"], "100-500");
-  EXPECT_EQ(request.params["in_stock"], "true");
-  EXPECT_EQ(request.params["sort"], "price");
-  EXPECT_EQ(request.params["direction"], "asc");
+  EXPECT_EQ(request.query.size(), 6);
+  EXPECT_EQ(request.query["category"], "electronics");
+  EXPECT_EQ(request.query["price"], "100-500");
+  EXPECT_EQ(request.query["in_stock"], "true");
+  EXPECT_EQ(request.query["sort"], "price");
+  EXPECT_EQ(request.query["direction"], "asc");
   // Note: For multiple values with the same key, only the last one is stored
-  EXPECT_EQ(request.params["brand"], "samsung");
+  EXPECT_EQ(request.query["brand"], "samsung");
 }
 
 // Test parsing POST request with both URL parameters and body
@@ -268,9 +268,9 @@ TEST(RequestTest, PostRequestWithUrlParameters) {
 
   EXPECT_EQ(request.method, "POST");
   EXPECT_EQ(request.path, "/submit");
-  EXPECT_EQ(request.params.size(), 2);
-  EXPECT_EQ(request.params["source"], "web");
-  EXPECT_EQ(request.params["ref"], "homepage");
+  EXPECT_EQ(request.query.size(), 2);
+  EXPECT_EQ(request.query["source"], "web");
+  EXPECT_EQ(request.query["ref"], "homepage");
   EXPECT_EQ(request.body, "name=John&email=john%40example.com");
 }
 
@@ -285,7 +285,108 @@ TEST(RequestTest, RequestWithNoParameters) {
   EXPECT_EQ(request.method, "GET");
   EXPECT_EQ(request.original_url, "/about");
   EXPECT_EQ(request.path, "/about");
-  EXPECT_TRUE(request.params.empty());
+  EXPECT_TRUE(request.query.empty());
+}
+
+// Test that fields are views into the request's own copy of the message
+TEST(RequestTest, FieldsOutliveRawRequest) {
+  std::string raw_request = "POST /items?id=7 HTTP/1.1\r\n"
+                            "Host: example.com\r\n"
+                            "\r\n"
+                            "payload";
+
+  Request request(raw_request);
+  raw_request.assign(raw_request.size(), 'x');
+
+  EXPECT_EQ(request.method, "POST");
+  EXPECT_EQ(request.original_url, "/items?id=7");
+  EXPECT_EQ(request.path, "/items");
+  EXPECT_EQ(request.header("Host"), "example.com");
+  EXPECT_EQ(request.body, "payload");
+}
+
+// Test that moving a request keeps its views valid
+TEST(RequestTest, FieldsSurviveMove) {
+  Request request("GET /about HTTP/1.1\r\nHost: example.com\r\n\r\n");
+  const char *path = request.path.data();
+
+  Request moved(std::move(request));
+
+  EXPECT_EQ(moved.path.data(), path);
+  EXPECT_EQ(moved.path, "/about");
+  EXPECT_EQ(moved.header("Host"), "example.com");
+}
+
+// Test copying a request into owned strings
+TEST(RequestTest, ToOwnedCopiesFields) {
+  std::string route = "id";
+  OwnedRequest owned;
+  {
+    Request request("PUT /users/42?debug=1 HTTP/1.1\r\n"
+                    "Content-Type: text/plain\r\n"
+                    "\r\n"
+                    "hello");
+    request.params[route] = request.path.substr(7);
+    owned = request.to_owned();
+  }
+
+  EXPECT_EQ(owned.method, "PUT");
+  EXPECT_EQ(owned.original_url, "/users/42?debug=1");
+  EXPECT_EQ(owned.path, "/users/42");
+  EXPECT_EQ(owned.params["id"], "42");
+  EXPECT_EQ(owned.query["debug"], "1");
+  EXPECT_EQ(owned.http_version, "HTTP/1.1");
+  EXPECT_EQ(owned.headers["Content-Type"], "text/plain");
+  EXPECT_EQ(owned.body, "hello");
+}
+
+// Test that header names are looked up in any case
+TEST(RequestTest, HeaderLookupIgnoresCase) {
+  std::string raw_request = "GET / HTTP/1.1\r\n"
+                            "host: example.com\r\n"
+                            "CONTENT-LENGTH: 0\r\n"
+                            "X-Request-Id: 42\r\n"
+                            "\r\n";
+
+  Request request(raw_request);
+
+  EXPECT_EQ(request.header(Header::Host), "example.com");
+  EXPECT_EQ(request.header(Header::ContentLength), "0");
+  EXPECT_EQ(request.header("Content-Length"), "0");
+  EXPECT_EQ(request.header("x-request-id"), "42");
+  EXPECT_EQ(request.header(Header::Cookie), "");
+}
+
+// Test parsing cookies from the Cookie header
+TEST(RequestTest, RequestWithCookies) {
+  std::string raw_request = "GET / HTTP/1.1\r\n"
+                            "Cookie: session=abc123; theme=dark\r\n"
+                            "\r\n";
+
+  Request request(raw_request);
+
+  EXPECT_EQ(request.cookies.size(), 2);
+  EXPECT_EQ(request.cookies["session"], "abc123");
+  EXPECT_EQ(request.cookies["theme"], "dark");
+}
+
+// Test parsing a form body, only when the content type says it is one
+TEST(RequestTest, RequestWithFormBody) {
+  std::string form_request = "POST /submit HTTP/1.1\r\n"
+                             "Content-Type: application/x-www-form-urlencoded; charset=UTF-8\r\n"
+                             "\r\n"
+                             "name=John+Doe&email=john%40example.com";
+  std::string json_request = "POST /submit HTTP/1.1\r\n"
+                             "Content-Type: application/json\r\n"
+                             "\r\n"
+                             "name=John";
+
+  Request form(form_request);
+  Request json(json_request);
+
+  EXPECT_EQ(form.form["name"], "John Doe");
+  EXPECT_EQ(form.form["email"], "john@example.com");
+  EXPECT_TRUE(json.form.empty());
 }
 
 } // namespace test
@@ -0,0 +1,234 @@
+#include "http/response_cache.h"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace express {
+namespace test {
+
+class CachedResponse : public Response {
+public:
+  CachedResponse(std::function<void(const std::vector<char> &)> write_to_socket,
+                 std::function<void(std::shared_ptr<const std::vector<char>>)>
+                     write_shared_to_socket = {})
+      : Response(write_to_socket, {}, {}, write_shared_to_socket) {}
+};
+
+class ResponseCacheFixture : public ::testing::Test {
+protected:
+  std::string written;
+  int handler_runs = 0;
+  /** Headers the handler sets on its response */
+  std::vector<std::pair<std::string, std::string>> response_headers;
+
+  /** Runs a request through the cache, and through a handler answering `body` on a miss */
+  void get(ResponseCache &cache, const std::string &target, const std::string &body = "payload",
+           const std::string &headers = "") {
+    Request request("GET " + target + " HTTP/1.1\r\nHost: localhost\r\n" + headers + "\r\n");
+    written.clear();
+    CachedResponse response([this](const std::vector<char> &data) {
+      written.append(data.begin(), data.end());
+    });
+    Next next;
+    cache.handle(request, response, next);
+    if (next.called()) {
+      handler_runs++;
+      for (const auto &[name, value] : response_headers) {
+        response.set(name, value);
+      }
+      response.send(body);
+    }
+  }
+
+  std::shared_ptr<ResponseCache> make_cache(CacheOptions options) {
+    return std::make_shared<ResponseCache>(std::move(options));
+  }
+};
+
+TEST_F(ResponseCacheFixture, HitSkipsHandler) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(30)});
+  get(*cache, "/catalog");
+  get(*cache, "/catalog", "changed");
+
+  EXPECT_EQ(handler_runs, 1);
+  EXPECT_NE(written.find("Age: 0\r\n"), std::string::npos);
+  EXPECT_TRUE(written.ends_with("\r\n\r\npayload"));
+}
+
+TEST_F(ResponseCacheFixture, ExpiredEntryRunsHandler) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(0)});
+  get(*cache, "/catalog");
+  get(*cache, "/catalog", "changed");
+
+  EXPECT_EQ(handler_runs, 2);
+  EXPECT_TRUE(written.ends_with("changed"));
+}
+
+TEST_F(ResponseCacheFixture, ExpiredEntryIsErasedWhenFound) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(0)});
+  get(*cache, "/catalog");
+  EXPECT_GT(cache->size_bytes(), 0u);
+
+  // The refreshed response is not kept, so only the erase frees the bytes
+  response_headers = {{"Set-Cookie", "session=a"}};
+  get(*cache, "/catalog");
+  EXPECT_EQ(cache->size_bytes(), 0u);
+}
+
+TEST_F(ResponseCacheFixture, KeyOnlyVariesBySelectedQueryParameters) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(30), .vary_query = {"page"}});
+  get(*cache, "/catalog?page=1&session=a");
+  get(*cache, "/catalog?page=1&session=b");
+  EXPECT_EQ(handler_runs, 1);
+
+  get(*cache, "/catalog?page=2&session=a");
+  EXPECT_EQ(handler_runs, 2);
+}
+
+TEST_F(ResponseCacheFixture, KeyVariesBySelectedHeaders) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(30), .vary_headers = {"accept-language"}});
+  get(*cache, "/catalog", "hello", "Accept-Language: en\r\n");
+  get(*cache, "/catalog", "bonjour", "Accept-Language: fr\r\n");
+  get(*cache, "/catalog", "hello", "Accept-Language: en\r\n");
+
+  EXPECT_EQ(handler_runs, 2);
+  EXPECT_TRUE(written.ends_with("hello"));
+}
+
+TEST_F(ResponseCacheFixture, OnlySuccessfulResponsesAreKept) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(30)});
+  for (int i = 0; i < 2; i++) {
+    Request request("GET /missing HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    CachedResponse response([](const std::vector<char> &) {});
+    Next next;
+    cache->handle(request, response, next);
+    ASSERT_TRUE(next.called());
+    response.status(404).send("missing");
+  }
+  EXPECT_EQ(cache->size_bytes(), 0u);
+}
+
+TEST_F(ResponseCacheFixture, EvictsLeastRecentlyUsedBeyondMaxBytes) {
+  // Room for about one response per shard, so some of the paths must evict others
+  size_t max_bytes = 16 * 300;
+  auto cache = make_cache({.ttl = std::chrono::seconds(30), .max_bytes = max_bytes});
+  std::string body(150, 'x');
+  for (int i = 0; i < 40; i++) {
+    get(*cache, "/item/" + std::to_string(i), body);
+    EXPECT_LE(cache->size_bytes(), max_bytes);
+  }
+  EXPECT_EQ(handler_runs, 40);
+
+  for (int i = 0; i < 40; i++) {
+    get(*cache, "/item/" + std::to_string(i), body);
+  }
+  EXPECT_GT(handler_runs, 40);
+  EXPECT_LT(handler_runs, 80);
+}
+
+TEST_F(ResponseCacheFixture, SkipsResponsesLargerThanShard) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(30), .max_bytes = 16 * 100});
+  get(*cache, "/large", std::string(200, 'x'));
+  get(*cache, "/large", std::string(200, 'x'));
+  EXPECT_EQ(handler_runs, 2);
+  EXPECT_EQ(cache->size_bytes(), 0u);
+}
+
+TEST_F(ResponseCacheFixture, StaleEntryIsRefreshedByOneRequest) {
+  auto cache = make_cache(
+      {.ttl = std::chrono::seconds(0), .stale_while_revalidate = std::chrono::seconds(60)});
+  get(*cache, "/catalog", "old");
+
+  // The first request finding the entry stale refreshes it, the others get the stale copy
+  Request refreshing("GET /catalog HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  CachedResponse refresh_response([](const std::vector<char> &) {});
+  Next refresh_next;
+  cache->handle(refreshing, refresh_response, refresh_next);
+  EXPECT_TRUE(refresh_next.called());
+
+  get(*cache, "/catalog", "unexpected");
+  get(*cache, "/catalog", "unexpected");
+  EXPECT_EQ(handler_runs, 1);
+  EXPECT_TRUE(written.ends_with("old"));
+
+  refresh_response.send("new");
+  get(*cache, "/catalog", "newer"); // Stale again at once, so this request refreshes it
+  EXPECT_EQ(handler_runs, 2);
+  EXPECT_TRUE(written.ends_with("newer"));
+}
+
+TEST_F(ResponseCacheFixture, NeverKeepsResponsesSettingCookies) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(30)});
+  response_headers = {{"Set-Cookie", "session=a1b2"}};
+  get(*cache, "/account");
+  get(*cache, "/account");
+
+  EXPECT_EQ(handler_runs, 2);
+  EXPECT_EQ(cache->size_bytes(), 0u);
+}
+
+TEST_F(ResponseCacheFixture, NeverKeepsPrivateOrNoStoreResponses) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(30)});
+  response_headers = {{"Cache-Control", "max-age=60, Private"}};
+  get(*cache, "/private");
+  get(*cache, "/private");
+  EXPECT_EQ(handler_runs, 2);
+
+  response_headers = {{"Cache-Control", "no-store"}};
+  get(*cache, "/no-store");
+  get(*cache, "/no-store");
+  EXPECT_EQ(handler_runs, 4);
+  EXPECT_EQ(cache->size_bytes(), 0u);
+
+  response_headers = {{"Cache-Control", "public, max-age=60"}};
+  get(*cache, "/public");
+  get(*cache, "/public");
+  EXPECT_EQ(handler_runs, 5);
+}
+
+TEST_F(ResponseCacheFixture, NeverKeepsResponsesVaryingOnHeadersOutsideKey) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(30), .vary_headers = {"Accept-Language"}});
+  response_headers = {{"Vary", "Accept-Language, Cookie"}};
+  get(*cache, "/greeting", "hello", "Cookie: user=a\r\n");
+  get(*cache, "/greeting", "hello", "Cookie: user=b\r\n");
+  EXPECT_EQ(handler_runs, 2);
+
+  response_headers = {{"Vary", "Authorization"}};
+  get(*cache, "/profile", "mine", "Authorization: Bearer a\r\n");
+  get(*cache, "/profile", "mine", "Authorization: Bearer b\r\n");
+  EXPECT_EQ(handler_runs, 4);
+  EXPECT_EQ(cache->size_bytes(), 0u);
+
+  // Headers that are part of the key are told apart, so such responses are kept
+  response_headers = {{"Vary", "accept-language"}};
+  get(*cache, "/greeting", "hello", "Accept-Language: en\r\n");
+  get(*cache, "/greeting", "hello", "Accept-Language: en\r\n");
+  EXPECT_EQ(handler_runs, 5);
+}
+
+TEST_F(ResponseCacheFixture, HitsShareOneBodyBuffer) {
+  auto cache = make_cache({.ttl = std::chrono::seconds(30)});
+  std::vector<const std::vector<char> *> bodies;
+  for (int i = 0; i < 3; i++) {
+    Request request("GET /catalog HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    CachedResponse response([](const std::vector<char> &) {},
+                            [&bodies](std::shared_ptr<const std::vector<char>> body) {
+                              bodies.push_back(body.get());
+                            });
+    Next next;
+    cache->handle(request, response, next);
+    if (next.called()) {
+      response.send("payload");
+    }
+  }
+
+  // The handler's body is sent and kept as the same buffer, then replayed without a copy
+  ASSERT_EQ(bodies.size(), 3u);
+  EXPECT_EQ(bodies[0], bodies[1]);
+  EXPECT_EQ(bodies[1], bodies[2]);
+}
+
+} // namespace test
+} // namespace express
@@ -1,7 +1,10 @@
 #include <express/response.h>
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <nlohmann/json.hpp>
 #include <span>
+#include <unistd.h>
 #include <vector>
 
 namespace express {
@@ -9,9 +12,14 @@ namespace test {
 
 class TestableResponse : public Response {
 public:
+  TestableResponse(std::function<void(const std::vector<char> &)> write_to_socket)
+      : Response(write_to_socket) {}
   TestableResponse(std::function<void(const std::vector<char> &)> write_to_socket,
-                   std::function<void()> close_socket)
-      : Response(write_to_socket, close_socket) {}
+                   std::function<void(int, size_t)> write_file_to_socket)
+      : Response(write_to_socket, {}, write_file_to_socket) {}
+
+  using Response::close_delimited;
+  using Response::set_http_version;
 };
 
 class ResponseFixture : public ::testing::Test {
@@ -21,13 +29,11 @@ protected:
     write_to_socket = [this](const std::vector<char> &data) {
       last_written = data;
     };
-    close_socket = []() {};
 
-    response = std::make_unique<TestableResponse>(write_to_socket, close_socket);
+    response = std::make_unique<TestableResponse>(write_to_socket);
   }
 
   std::function<void(const std::vector<char>)> write_to_socket;
-  std::function<void()> close_socket;
   std::unique_ptr<Response> response;
   std::vector<char> last_written;
 };
@@ -44,6 +50,12 @@ TEST_F(ResponseFixture, SetHeaderOverwrite) {
   EXPECT_EQ(response->get("X-Custom"), "second");
 }
 
+TEST_F(ResponseFixture, SetHeaderIgnoresNameCase) {
+  response->set("X-Custom", "first");
+  response->set("x-custom", "second");
+  EXPECT_EQ(response->get("X-CUSTOM"), "second");
+}
+
 TEST_F(ResponseFixture, SetHeaderAfterSend) {
   response->send("test");
   EXPECT_THROW(response->set("X-Custom", "value"), std::runtime_error);
@@ -288,5 +300,104 @@ TEST_F(ResponseFixture, SendAfterEnd) {
   EXPECT_THROW(response->send("test"), std::runtime_error);
 }
 
+// File tests
+TEST_F(ResponseFixture, SendFileReadsBodyWithoutServer) {
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "express_send_file.css";
+  std::ofstream(path) << "body { margin: 0; }";
+  response->send_file(path);
+  std::filesystem::remove(path);
+
+  EXPECT_EQ(std::string(last_written.begin(), last_written.end()), "body { margin: 0; }");
+  EXPECT_EQ(response->get("Content-Length"), "19");
+  EXPECT_EQ(response->get("Content-Type"), "text/css; charset=utf-8");
+}
+
+TEST_F(ResponseFixture, SendPathSendsFile) {
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "express_send_path.txt";
+  std::ofstream(path) << "contents";
+  response->send(path);
+  std::filesystem::remove(path);
+
+  EXPECT_EQ(std::string(last_written.begin(), last_written.end()), "contents");
+}
+
+TEST_F(ResponseFixture, SendMissingFile) {
+  response->send_file("/nonexistent/express_missing.txt");
+  EXPECT_EQ(response->status_code(), 404);
+  EXPECT_TRUE(response->headers_sent());
+}
+
+TEST_F(ResponseFixture, SendFileHandsDescriptorToServer) {
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "express_send_fd.bin";
+  std::ofstream(path) << "12345";
+  int received_fd = -1;
+  size_t received_length = 0;
+  TestableResponse streamed(
+      [this](const std::vector<char> &data) { last_written = data; },
+      [&received_fd, &received_length](int file_fd, size_t length) {
+        received_fd = file_fd;
+        received_length = length;
+      });
+  streamed.send_file(path);
+  std::filesystem::remove(path);
+
+  std::string written(last_written.begin(), last_written.end());
+  EXPECT_TRUE(written.ends_with("\r\n\r\n")); // Head only, the server sends the file
+  EXPECT_GE(received_fd, 0);
+  EXPECT_EQ(received_length, 5u);
+  close(received_fd);
+}
+
+// Streaming tests
+TEST_F(ResponseFixture, WriteStartsChunkedBody) {
+  response->write("hello");
+  std::string written(last_written.begin(), last_written.end());
+  EXPECT_NE(written.find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+  EXPECT_EQ(written.find("Content-Length"), std::string::npos);
+  EXPECT_TRUE(written.ends_with("\r\n\r\n5\r\nhello\r\n"));
+  EXPECT_TRUE(response->headers_sent());
+}
+
+TEST_F(ResponseFixture, WriteAfterHeadersSendsOnlyChunk) {
+  response->write("hello");
+  response->write("hexadecimal sizes");
+  EXPECT_EQ(std::string(last_written.begin(), last_written.end()), "11\r\nhexadecimal sizes\r\n");
+}
+
+TEST_F(ResponseFixture, EndTerminatesChunkedBody) {
+  response->write("hello");
+  response->end();
+  EXPECT_EQ(std::string(last_written.begin(), last_written.end()), "0\r\n\r\n");
+  EXPECT_THROW(response->write("late"), std::runtime_error);
+}
+
+TEST(ResponseTest, WriteToHttp10PeerSendsUnframedBodyAndCloses) {
+  std::string written;
+  TestableResponse response([&written](const std::vector<char> &data) {
+    written.append(data.begin(), data.end());
+  });
+  response.set_http_version("HTTP/1.0");
+  response.set("Connection", "keep-alive");
+  response.set("Content-Length", "10");
+  response.write("hello");
+  response.write("world");
+  response.end();
+
+  EXPECT_EQ(written.find("Transfer-Encoding"), std::string::npos);
+  EXPECT_EQ(written.find("Content-Length"), std::string::npos);
+  EXPECT_NE(written.find("Connection: close\r\n"), std::string::npos);
+  EXPECT_TRUE(written.ends_with("\r\n\r\nhelloworld"));
+  EXPECT_TRUE(response.close_delimited());
+}
+
+TEST_F(ResponseFixture, WriteAfterSend) {
+  response->send("test");
+  EXPECT_THROW(response->write("more"), std::runtime_error);
+}
+
+TEST_F(ResponseFixture, WriteWithoutDrainHookDoesNotSuspend) {
+  EXPECT_TRUE(response->write("hello").await_ready());
+}
+
 } // namespace test
 } // namespace express
\ No newline at end of file
@@ -119,5 +119,72 @@ TEST(UrlCodecTest, MalformedUtf8Sequence) {
   EXPECT_THROW(codec.decode(encoded), std::invalid_argument);
 }
 
+// Test decoding into a caller-supplied buffer
+TEST(UrlCodecTest, DecodeIntoBuffer) {
+  std::string encoded = "caf%C3%A9+au+lait";
+  char output[32];
+  UrlCodec::DecodeResult result = UrlCodec::decode(encoded, output);
+
+  EXPECT_EQ(result.error, UrlCodec::Error::NONE);
+  EXPECT_EQ(std::string_view(output, result.size), "café au lait");
+}
+
+// Test decoding in place, over the encoded text
+TEST(UrlCodecTest, DecodeInPlace) {
+  std::string text = "a%20long%20enough%20value+to+use+the+word+path";
+  UrlCodec::DecodeResult result = UrlCodec::decode(text, text.data());
+  text.resize(result.size);
+
+  EXPECT_EQ(result.error, UrlCodec::Error::NONE);
+  EXPECT_EQ(text, "a long enough value to use the word path");
+}
+
+// Test keeping '+' as is, as in cookies and paths
+TEST(UrlCodecTest, DecodeWithLiteralPlus) {
+  std::string encoded = "1+1%3D2";
+  char output[16];
+  UrlCodec::DecodeResult result = UrlCodec::decode(encoded, output, false);
+
+  EXPECT_EQ(std::string_view(output, result.size), "1+1=2");
+}
+
+// Test the error codes of malformed input
+TEST(UrlCodecTest, DecodeErrorCodes) {
+  char output[16];
+
+  EXPECT_EQ(UrlCodec::decode("abc%4", output).error, UrlCodec::Error::INCOMPLETE_ESCAPE);
+  EXPECT_EQ(UrlCodec::decode("abc%G1", output).error, UrlCodec::Error::INVALID_HEX);
+  EXPECT_EQ(UrlCodec::decode("%E6%97", output).error, UrlCodec::Error::INVALID_UTF8);
+  EXPECT_EQ(UrlCodec::decode("abc%4", output).size, 3);
+}
+
+// Test rejecting overlong forms, surrogates, code points past U+10FFFF and stray bytes
+TEST(UrlCodecTest, DecodeRejectsInvalidUtf8) {
+  char output[16];
+
+  EXPECT_EQ(UrlCodec::decode("%C0%AF", output).error, UrlCodec::Error::INVALID_UTF8);
+  EXPECT_EQ(UrlCodec::decode("%E0%80%AF", output).error, UrlCodec::Error::INVALID_UTF8);
+  EXPECT_EQ(UrlCodec::decode("%ED%A0%80", output).error, UrlCodec::Error::INVALID_UTF8);
+  EXPECT_EQ(UrlCodec::decode("%F4%90%80%80", output).error, UrlCodec::Error::INVALID_UTF8);
+  EXPECT_EQ(UrlCodec::decode("%80", output).error, UrlCodec::Error::INVALID_UTF8);
+  EXPECT_EQ(UrlCodec::decode("\xFF", output).error, UrlCodec::Error::INVALID_UTF8);
+  EXPECT_EQ(UrlCodec::decode("%F4%8F%BF%BF", output).error, UrlCodec::Error::NONE);
+}
+
+// Test encoding everything but unreserved characters
+TEST(UrlCodecTest, Encode) {
+  EXPECT_EQ(UrlCodec::encode("AZaz09-._~"), "AZaz09-._~");
+  EXPECT_EQ(UrlCodec::encode("/next?a=1&b=c d"), "%2Fnext%3Fa%3D1%26b%3Dc%20d");
+  EXPECT_EQ(UrlCodec::encode("日本"), "%E6%97%A5%E6%9C%AC");
+  EXPECT_EQ(UrlCodec::encoded_size("a b"), 5);
+}
+
+// Test that decoding undoes encoding
+TEST(UrlCodecTest, EncodeRoundTrip) {
+  std::string original = "https://example.com/path?q=café & more+😀";
+
+  EXPECT_EQ(UrlCodec::decode(UrlCodec::encode(original)), original);
+}
+
 } // namespace test
 } // namespace express
\ No newline at end of file
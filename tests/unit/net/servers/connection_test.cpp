@@ -0,0 +1,163 @@
+#include "net/servers/connection.h"
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace express {
+namespace test {
+
+/**
+ * Test fixture for Connection tests.
+ * Uses no descriptor, only the buffering and response ordering.
+ */
+class ConnectionFixture : public ::testing::Test {
+protected:
+  Connection connection{-1, 0};
+
+  static std::vector<char> bytes(const std::string &text) {
+    return std::vector<char>(text.begin(), text.end());
+  }
+
+  std::string written() {
+    std::string text;
+    size_t offset = connection.write_offset();
+    for (OutputSegment &segment : connection.output()) {
+      text += segment.is_file() ? "<file>" : std::string(segment.data() + offset,
+                                                        segment.data() + segment.size());
+      offset = 0;
+    }
+    return text;
+  }
+
+  /** Opens a temporary file holding the given text; the caller owns the descriptor */
+  static int temporary_file(const std::string &text) {
+    FILE *file = tmpfile();
+    fwrite(text.data(), 1, text.size(), file);
+    fflush(file);
+    int fd = dup(fileno(file));
+    fclose(file);
+    return fd;
+  }
+};
+
+TEST_F(ConnectionFixture, InOrderResponsesGoStraightToWriteBuffer) {
+  uint64_t first = connection.start_response();
+  uint64_t second = connection.start_response();
+
+  connection.queue_response(first, bytes("one;"));
+  EXPECT_EQ(connection.finish_response(first), 1u);
+  connection.queue_response(second, bytes("two;"));
+  EXPECT_EQ(connection.finish_response(second), 1u);
+
+  EXPECT_EQ(written(), "one;two;");
+}
+
+TEST_F(ConnectionFixture, LaterResponseIsHeldUntilEarlierFinishes) {
+  uint64_t first = connection.start_response();
+  uint64_t second = connection.start_response();
+  uint64_t third = connection.start_response();
+
+  connection.queue_response(third, bytes("three;"));
+  EXPECT_EQ(connection.finish_response(third), 0u);
+  connection.queue_response(second, bytes("two;"));
+  EXPECT_EQ(connection.finish_response(second), 0u);
+  EXPECT_FALSE(connection.has_pending_writes());
+
+  connection.queue_response(first, bytes("one;"));
+  EXPECT_EQ(connection.finish_response(first), 3u);
+  EXPECT_EQ(written(), "one;two;three;");
+}
+
+TEST_F(ConnectionFixture, UnfinishedHeldResponseContinuesAtHead) {
+  uint64_t first = connection.start_response();
+  uint64_t second = connection.start_response();
+
+  connection.queue_response(second, bytes("two-a;"));
+  EXPECT_EQ(connection.finish_response(first), 1u);
+  EXPECT_EQ(written(), "two-a;");
+
+  connection.queue_response(second, bytes("two-b;"));
+  EXPECT_EQ(connection.finish_response(second), 1u);
+  EXPECT_EQ(written(), "two-a;two-b;");
+}
+
+TEST_F(ConnectionFixture, FileRangeKeepsItsPlaceInResponseOrder) {
+  uint64_t first = connection.start_response();
+  uint64_t second = connection.start_response();
+
+  connection.queue_response(second, bytes("two;"));
+  connection.queue_response(first, bytes("head;"));
+  connection.queue_response(first, OutputSegment(temporary_file("body"), 0, 4));
+  EXPECT_EQ(connection.finish_response(first), 1u);
+  EXPECT_EQ(written(), "head;<file>two;");
+  EXPECT_EQ(connection.output().size(), 3u);
+}
+
+TEST_F(ConnectionFixture, GatherOutputKeepsSegmentsSeparate) {
+  uint64_t first = connection.start_response();
+  connection.queue_response(first, bytes("head;"));
+  connection.queue_response(first, bytes("body;"));
+  connection.queue_response(first, OutputSegment(temporary_file("file"), 0, 4));
+  connection.consume_written(2);
+
+  iovec iovecs[4];
+  ASSERT_EQ(connection.gather_output(iovecs, 4), 2u);
+  EXPECT_EQ(std::string(static_cast<char *>(iovecs[0].iov_base), iovecs[0].iov_len), "ad;");
+  EXPECT_EQ(std::string(static_cast<char *>(iovecs[1].iov_base), iovecs[1].iov_len), "body;");
+
+  connection.consume_written(4);
+  EXPECT_EQ(written(), "ody;<file>");
+  EXPECT_EQ(connection.gather_output(iovecs, 4), 1u);
+}
+
+TEST_F(ConnectionFixture, TakeOutputMovesByteSegmentsUpToFile) {
+  uint64_t first = connection.start_response();
+  connection.queue_response(first, bytes("head;"));
+  connection.queue_response(first, bytes("body;"));
+  connection.queue_response(first, OutputSegment(temporary_file("file"), 0, 4));
+  connection.consume_written(1);
+
+  std::vector<OutputSegment> taken;
+  connection.take_output(taken, 4);
+  ASSERT_EQ(taken.size(), 2u);
+  EXPECT_EQ(std::string(taken[0].bytes.begin(), taken[0].bytes.end()), "ead;");
+  EXPECT_EQ(std::string(taken[1].bytes.begin(), taken[1].bytes.end()), "body;");
+  EXPECT_EQ(written(), "<file>");
+}
+
+TEST_F(ConnectionFixture, SharedBytesAreSentInPlace) {
+  auto shared = std::make_shared<const std::vector<char>>(bytes("cached body"));
+  uint64_t first = connection.start_response();
+  connection.queue_response(first, bytes("head;"));
+  connection.queue_response(first, OutputSegment(shared));
+
+  iovec iovecs[4];
+  ASSERT_EQ(connection.gather_output(iovecs, 4), 2u);
+  EXPECT_EQ(iovecs[1].iov_base, shared->data());
+
+  // A partly sent shared segment is copied, never trimmed, when taken
+  connection.consume_written(6);
+  std::vector<OutputSegment> taken;
+  connection.take_output(taken, 4);
+  EXPECT_EQ(std::string(taken[0].bytes.begin(), taken[0].bytes.end()), "ached body");
+  EXPECT_EQ(std::string(shared->begin(), shared->end()), "cached body");
+}
+
+TEST_F(ConnectionFixture, ConsumedReadsStayUntilCompacted) {
+  std::vector<char> &buffer = connection.read_buffer();
+  std::string raw = "first;second;";
+  buffer.insert(buffer.end(), raw.begin(), raw.end());
+
+  connection.consume_read(6);
+  EXPECT_EQ(std::string(connection.unread_data(), connection.unread_size()), "second;");
+  EXPECT_EQ(buffer.size(), raw.size());
+
+  connection.compact_read_buffer();
+  EXPECT_EQ(std::string(buffer.begin(), buffer.end()), "second;");
+  EXPECT_EQ(connection.unread_size(), buffer.size());
+}
+
+} // namespace test
+} // namespace express
@@ -0,0 +1,434 @@
+#include "core/router.h"
+#include "net/servers/server.h"
+#include <express/listen_options.h>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace express {
+namespace test {
+
+/**
+ * Test fixture running a Server on an ephemeral loopback port, with raw clients.
+ */
+class ServerFixture : public ::testing::Test {
+protected:
+  std::unique_ptr<WorkerPool> pool;
+  std::shared_ptr<RouterSlot> slot;
+  std::unique_ptr<Server> server;
+  int port = 0;
+
+  void TearDown() override {
+    if (server != nullptr) {
+      server->stop();
+    }
+    server = nullptr;
+    pool = nullptr;
+  }
+
+  /** Starts serving the router, with `workers` pool threads or inline if 0 */
+  void start(Router &router, ListenOptions options = ListenOptions(), size_t workers = 0) {
+    create(router, options, workers);
+    server->launch();
+  }
+
+  /** Binds the server without running its event loop, so connections queue up in the backlog */
+  void create(Router &router, ListenOptions options = ListenOptions(), size_t workers = 0) {
+    if (workers > 0) {
+      pool = std::make_unique<WorkerPool>(workers);
+    }
+    SocketConfig config = {AF_INET, SOCK_STREAM, 0, 0, INADDR_LOOPBACK, 511};
+    slot = std::make_shared<RouterSlot>(router.compile());
+    server = std::make_unique<Server>(config, slot, options, pool.get());
+
+    struct sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    getsockname(server->socket()->sock(), (struct sockaddr *)&address, &length);
+    port = ntohs(address.sin_port);
+  }
+
+  /** Opens a client connection to the server, with a timeout so a hung server fails the test */
+  int connect_client() {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct timeval timeout = {5, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(sock, (struct sockaddr *)&address, sizeof(address)) < 0) {
+      close(sock);
+      return -1;
+    }
+    return sock;
+  }
+
+  /** Sends raw bytes on a fresh connection and reads until the server closes it */
+  std::string exchange(std::string_view raw_request) {
+    int sock = connect_client();
+    if (sock < 0)
+      return "";
+    send(sock, raw_request.data(), raw_request.size(), MSG_NOSIGNAL);
+    std::string received = read_all(sock);
+    close(sock);
+    return received;
+  }
+
+  static std::string read_all(int sock) {
+    std::string received;
+    char buffer[4096];
+    while (true) {
+      ssize_t size = recv(sock, buffer, sizeof(buffer), 0);
+      if (size < 0 && errno == EINTR)
+        continue; // Tearing down an io_uring server interrupts the thread that created it
+      if (size <= 0)
+        return received;
+      received.append(buffer, size);
+    }
+  }
+
+  /** Counts the responses in raw bytes read from a connection */
+  static size_t count_responses(std::string_view received) {
+    size_t count = 0;
+    for (size_t at = received.find("HTTP/1.1 "); at != std::string_view::npos;
+         at = received.find("HTTP/1.1 ", at + 1)) {
+      count++;
+    }
+    return count;
+  }
+
+  /**
+   * Pipelines `count` requests to a coroutine route on one connection, the last one closing it,
+   * from another thread so that neither side blocks on a full socket.
+   * @returns Everything the server sent back.
+   */
+  std::string pipeline(size_t count, std::string_view target) {
+    int sock = connect_client();
+    if (sock < 0)
+      return "";
+    std::string requests;
+    for (size_t i = 0; i + 1 < count; i++) {
+      requests += "GET " + std::string(target) + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    }
+    requests += "GET " + std::string(target) + " HTTP/1.1\r\nConnection: close\r\n\r\n";
+    std::thread sender([sock, &requests]() {
+      for (size_t sent = 0; sent < requests.size();) {
+        ssize_t size = send(sock, requests.data() + sent, requests.size() - sent, MSG_NOSIGNAL);
+        if (size < 0 && errno == EINTR)
+          continue;
+        if (size <= 0)
+          return;
+        sent += size;
+      }
+    });
+    std::string received = read_all(sock);
+    sender.join();
+    close(sock);
+    return received;
+  }
+
+  /** Routes throwing from a synchronous handler and from a synchronous middleware */
+  static void add_throwing_routes(Router &router) {
+    router.use("/guarded", [](Request &, Response &, Next &next) {
+      throw std::runtime_error("middleware failed");
+      next();
+    });
+    router.get("/guarded", [](Request &, Response &response) { response.send("unreachable"); });
+    router.get("/boom", [](Request &, Response &) { throw std::runtime_error("handler failed"); });
+    router.get("/ok", [](Request &, Response &response) { response.send("ok"); });
+  }
+};
+
+TEST_F(ServerFixture, AnswersThrowingSynchronousHandlerWith500) {
+  Router router;
+  add_throwing_routes(router);
+  start(router);
+
+  EXPECT_EQ(exchange("GET /boom HTTP/1.1\r\nConnection: close\r\n\r\n").substr(0, 12),
+            "HTTP/1.1 500");
+  EXPECT_EQ(exchange("GET /guarded HTTP/1.1\r\nConnection: close\r\n\r\n").substr(0, 12),
+            "HTTP/1.1 500");
+  // The server survived and still serves
+  EXPECT_EQ(exchange("GET /ok HTTP/1.1\r\nConnection: close\r\n\r\n").substr(0, 12),
+            "HTTP/1.1 200");
+}
+
+TEST_F(ServerFixture, AnswersThrowingHandlerOnWorkerWith500) {
+  Router router;
+  add_throwing_routes(router);
+  router.get("/bad-body", [](Request &, Response &) { throw BodyError(400, "Bad Request"); });
+  start(router, ListenOptions(), 2);
+
+  EXPECT_EQ(exchange("GET /boom HTTP/1.1\r\nConnection: close\r\n\r\n").substr(0, 12),
+            "HTTP/1.1 500");
+  EXPECT_EQ(exchange("GET /bad-body HTTP/1.1\r\nConnection: close\r\n\r\n").substr(0, 12),
+            "HTTP/1.1 400");
+  EXPECT_EQ(exchange("GET /ok HTTP/1.1\r\nConnection: close\r\n\r\n").substr(0, 12),
+            "HTTP/1.1 200");
+}
+
+TEST_F(ServerFixture, SuspendedRequestKeepsTableItStartedWith) {
+  Router first;
+  first.get("/slow", [](Request &, Response &response) -> Task<> {
+    co_await sleep_for(std::chrono::milliseconds(200));
+    response.send("first");
+  });
+  first.get("/which", [](Request &, Response &response) { response.send("first"); });
+  start(first);
+  std::weak_ptr<const CompiledRouter> first_table = slot->load();
+
+  int slow = connect_client();
+  ASSERT_GE(slow, 0);
+  std::string request = "GET /slow HTTP/1.1\r\nConnection: close\r\n\r\n";
+  send(slow, request.data(), request.size(), MSG_NOSIGNAL);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Suspended in sleep_for
+
+  Router second;
+  second.get("/which", [](Request &, Response &response) { response.send("second"); });
+  slot->publish(second.compile());
+  EXPECT_TRUE(exchange("GET /which HTTP/1.1\r\nConnection: close\r\n\r\n").ends_with("second"));
+  EXPECT_FALSE(first_table.expired());
+
+  EXPECT_TRUE(read_all(slow).ends_with("first"));
+  close(slow);
+  exchange("GET /which HTTP/1.1\r\nConnection: close\r\n\r\n"); // One more loop iteration
+  EXPECT_TRUE(first_table.expired());
+}
+
+TEST_F(ServerFixture, WorkerRequestKeepsTableItStartedWith) {
+  Router first;
+  first.get("/slow", [](Request &, Response &response) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    response.send("first");
+  });
+  start(first, ListenOptions(), 2);
+  std::weak_ptr<const CompiledRouter> first_table = slot->load();
+
+  int slow = connect_client();
+  ASSERT_GE(slow, 0);
+  std::string request = "GET /slow HTTP/1.1\r\nConnection: close\r\n\r\n";
+  send(slow, request.data(), request.size(), MSG_NOSIGNAL);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Running on a worker
+
+  Router second;
+  second.get("/which", [](Request &, Response &response) { response.send("second"); });
+  slot->publish(second.compile());
+  EXPECT_TRUE(exchange("GET /which HTTP/1.1\r\nConnection: close\r\n\r\n").ends_with("second"));
+  EXPECT_FALSE(first_table.expired());
+
+  EXPECT_TRUE(read_all(slow).ends_with("first"));
+  close(slow);
+  exchange("GET /which HTTP/1.1\r\nConnection: close\r\n\r\n");
+  EXPECT_TRUE(first_table.expired());
+}
+
+/**
+ * Runs a test against each I/O backend. Tests skip io_uring where the kernel or the build lacks
+ * it, and the server fell back to epoll.
+ */
+class BackendFixture : public ServerFixture, public ::testing::WithParamInterface<IoBackend> {
+protected:
+  ListenOptions backend_options() {
+    ListenOptions options;
+    options.backend = GetParam();
+    return options;
+  }
+};
+
+/** Normalizes raw responses for comparison across servers, dropping the Date headers */
+std::string without_dates(std::string received) {
+  for (size_t at = received.find("Date: "); at != std::string::npos;
+       at = received.find("Date: ", at)) {
+    received.erase(at, received.find("\r\n", at) + 2 - at);
+  }
+  return received;
+}
+
+TEST_P(BackendFixture, AcceptsEveryQueuedConnection) {
+  Router router;
+  router.get("/ok", [](Request &, Response &response) { response.send("ok"); });
+  create(router, backend_options());
+  if (server->backend() != GetParam())
+    GTEST_SKIP() << "io_uring is not available";
+
+  // Queued before the loop runs, so they all arrive with a single wakeup or multishot accept
+  std::vector<int> clients;
+  std::string request = "GET /ok HTTP/1.1\r\nConnection: close\r\n\r\n";
+  for (int i = 0; i < 64; i++) {
+    int sock = connect_client();
+    ASSERT_GE(sock, 0);
+    send(sock, request.data(), request.size(), MSG_NOSIGNAL);
+    clients.push_back(sock);
+  }
+  server->launch();
+
+  for (int sock : clients) {
+    EXPECT_TRUE(read_all(sock).ends_with("\r\n\r\nok"));
+    close(sock);
+  }
+  EXPECT_EQ(server->stats().connections_accepted, 64u);
+}
+
+TEST_P(BackendFixture, SendsFileSpanningSeveralChunks) {
+  std::string contents;
+  for (int i = 0; contents.size() < 200 * 1024; i++) {
+    contents += std::to_string(i) + ",";
+  }
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "express_server_test_file.txt";
+  std::ofstream(path, std::ios::binary) << contents;
+
+  Router router;
+  router.get("/file", [&path](Request &, Response &response) { response.send_file(path); });
+  start(router, backend_options());
+  if (server->backend() != GetParam())
+    GTEST_SKIP() << "io_uring is not available";
+
+  std::string received = exchange("GET /file HTTP/1.1\r\nConnection: close\r\n\r\n");
+  std::filesystem::remove(path);
+  size_t body = received.find("\r\n\r\n");
+  ASSERT_NE(body, std::string::npos);
+  EXPECT_EQ(received.substr(body + 4), contents);
+}
+
+TEST_P(BackendFixture, BacksOffWhileOutOfDescriptors) {
+  Router router;
+  router.get("/ok", [](Request &, Response &response) { response.send("ok"); });
+  start(router, backend_options());
+  if (server->backend() != GetParam())
+    GTEST_SKIP() << "io_uring is not available";
+
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  struct timeval timeout = {5, 0};
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  // Fill the descriptor table, so the server's accepts fail with EMFILE
+  struct rlimit original;
+  getrlimit(RLIMIT_NOFILE, &original);
+  struct rlimit lowered = {256, original.rlim_max};
+  setrlimit(RLIMIT_NOFILE, &lowered);
+  std::vector<int> fillers;
+  for (int fd = dup(sock); fd >= 0; fd = dup(sock)) {
+    fillers.push_back(fd);
+  }
+
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int connected = connect(sock, (struct sockaddr *)&address, sizeof(address));
+  std::string request = "GET /ok HTTP/1.1\r\nConnection: close\r\n\r\n";
+  send(sock, request.data(), request.size(), MSG_NOSIGNAL);
+  std::this_thread::sleep_for(std::chrono::milliseconds(350));
+  size_t errors = server->stats().accept_errors;
+
+  for (int fd : fillers) {
+    close(fd);
+  }
+  setrlimit(RLIMIT_NOFILE, &original);
+  ASSERT_EQ(connected, 0);
+  EXPECT_GE(errors, 1u);
+  EXPECT_LE(errors, 10u); // Retried after a backoff, not in a loop
+
+  // Accepted once descriptors are available again
+  EXPECT_TRUE(read_all(sock).ends_with("\r\n\r\nok"));
+  close(sock);
+}
+
+TEST_P(BackendFixture, AnswersPipelinedRequestsInOrderThroughPausedReads) {
+  Router router;
+  int next = 0;
+  router.get("/count", [&next](Request &, Response &response) -> Task<> {
+    int number = next++;
+    co_await sleep_for(std::chrono::microseconds(100)); // Keeps requests in flight
+    response.send(std::to_string(number) + ";");
+  });
+  ListenOptions options = backend_options();
+  options.max_body_size = 1024; // Read buffer fills, and reading pauses, after ~73KB
+  options.max_requests_per_connection = 10000;
+  start(router, options);
+  if (server->backend() != GetParam())
+    GTEST_SKIP() << "io_uring is not available";
+
+  std::string received = pipeline(4000, "/count");
+  EXPECT_EQ(count_responses(received), 4000u);
+  EXPECT_NE(received.find("\r\n\r\n0;"), std::string::npos);
+  EXPECT_TRUE(received.ends_with("\r\n\r\n3999;"));
+  size_t previous = 0;
+  for (int i = 0; i < 4000; i += 500) {
+    size_t at = received.find("\r\n\r\n" + std::to_string(i) + ";");
+    ASSERT_NE(at, std::string::npos) << i;
+    EXPECT_GE(at, previous);
+    previous = at;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(IoBackends, BackendFixture,
+                         ::testing::Values(IoBackend::EPOLL, IoBackend::IO_URING),
+                         [](const ::testing::TestParamInfo<IoBackend> &info) {
+                           return info.param == IoBackend::EPOLL ? "Epoll" : "IoUring";
+                         });
+
+TEST_F(ServerFixture, IoUringAnswersLikeEpoll) {
+  int next = 0;
+  Router router;
+  router.get("/ok", [](Request &, Response &response) { response.send("ok"); });
+  router.get("/count", [&next](Request &, Response &response) -> Task<> {
+    int number = next++;
+    co_await sleep_for(std::chrono::microseconds(100));
+    response.send(std::to_string(number) + ";");
+  });
+
+  auto transcript = [&](IoBackend backend) {
+    next = 0;
+    ListenOptions options;
+    options.backend = backend;
+    options.max_body_size = 1024;
+    options.max_requests_per_connection = 10000;
+    start(router, options);
+    std::vector<std::string> responses;
+    responses.push_back(server->backend() == backend ? "" : "fell back");
+
+    // Answer linked to the close of the connection
+    responses.push_back(exchange("GET /ok HTTP/1.1\r\nConnection: close\r\n\r\n"));
+    responses.push_back(exchange("HEAD /ok HTTP/1.1\r\nConnection: close\r\n\r\n"));
+    responses.push_back(exchange("GET /missing HTTP/1.0\r\n\r\n"));
+    responses.push_back(exchange("GET /ok HTTP/1.1\r\n\r\nGET /ok HTTP/1.1\r\n"
+                                 "Connection: close\r\n\r\n"));
+    responses.push_back(exchange("NOT A REQUEST\r\n\r\n"));
+    // Enough pipelined requests to pause and resume receiving
+    responses.push_back(pipeline(2000, "/count"));
+
+    server->stop();
+    server = nullptr;
+    for (std::string &response : responses) {
+      response = without_dates(std::move(response));
+    }
+    return responses;
+  };
+
+  std::vector<std::string> epoll = transcript(IoBackend::EPOLL);
+  std::vector<std::string> io_uring = transcript(IoBackend::IO_URING);
+  if (io_uring[0] == "fell back")
+    GTEST_SKIP() << "io_uring is not available";
+  ASSERT_EQ(epoll.size(), io_uring.size());
+  for (size_t i = 0; i < epoll.size(); i++) {
+    EXPECT_EQ(epoll[i], io_uring[i]) << "exchange " << i;
+  }
+  EXPECT_EQ(count_responses(epoll.back()), 2000u);
+}
+
+} // namespace test
+} // namespace express
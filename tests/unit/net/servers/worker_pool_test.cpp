@@ -0,0 +1,74 @@
+#include "net/servers/worker_pool.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace express {
+namespace test {
+
+TEST(WorkerPoolTest, RunsEveryJobExactlyOnce) {
+  constexpr size_t JOB_COUNT = 20000;
+  std::vector<std::atomic<int>> runs(JOB_COUNT);
+  {
+    WorkerPool pool(4);
+    // Submitted from several threads at once, as by several reactors
+    std::vector<std::thread> submitters;
+    for (size_t t = 0; t < 4; t++) {
+      submitters.emplace_back([&pool, &runs, t]() {
+        for (size_t i = t; i < JOB_COUNT; i += 4) {
+          pool.submit([&runs, i]() { runs[i]++; });
+        }
+      });
+    }
+    for (std::thread &submitter : submitters) {
+      submitter.join();
+    }
+  }
+
+  for (size_t i = 0; i < JOB_COUNT; i++) {
+    ASSERT_EQ(runs[i].load(), 1) << "job " << i;
+  }
+}
+
+TEST(WorkerPoolTest, IdleWorkerStealsJobQueuedBehindBusyOne) {
+  WorkerPool pool(2);
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<std::thread::id> blocked_on;
+  std::promise<std::thread::id> stolen_on;
+
+  // Round-robin puts the first and third jobs on the first worker's deque
+  pool.submit([&blocked_on, released]() {
+    blocked_on.set_value(std::this_thread::get_id());
+    released.wait();
+  });
+  pool.submit([]() {});
+  pool.submit([&stolen_on]() { stolen_on.set_value(std::this_thread::get_id()); });
+
+  std::future<std::thread::id> stolen = stolen_on.get_future();
+  ASSERT_EQ(stolen.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  EXPECT_NE(stolen.get(), blocked_on.get_future().get());
+  release.set_value();
+}
+
+TEST(WorkerPoolTest, DestructorRunsQueuedJobs) {
+  std::atomic<int> runs{0};
+  {
+    WorkerPool pool(1);
+    pool.submit([&runs]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      runs++;
+    });
+    for (int i = 0; i < 100; i++) {
+      pool.submit([&runs]() { runs++; });
+    }
+  }
+  EXPECT_EQ(runs.load(), 101);
+}
+
+} // namespace test
+} // namespace express
@@ -50,5 +50,14 @@ TEST_F(ListeningSocketFixture, SocketIsListeningAfterInit) {
   close(client_sock);
 }
 
+// Reactor shards each bind their own listener to the same port
+TEST(ListeningSocketTest, ReusePortAllowsSiblingListeners) {
+  express::SocketConfig config = {AF_INET, SOCK_STREAM, 0, 8081, INADDR_ANY, BACKLOG, true};
+  express::ListeningSocket first(config);
+
+  std::unique_ptr<express::ListeningSocket> second;
+  EXPECT_NO_THROW(second = std::make_unique<express::ListeningSocket>(config));
+}
+
 } // namespace test
 } // namespace express
\ No newline at end of file